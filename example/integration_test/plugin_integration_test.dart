@@ -198,6 +198,41 @@ void main() {
     });
   });
 
+  // ── 2c. Segmented decoding ───────────────────────────────────────
+  // Long PCM inputs can be split across cores (see decodeSegments in
+  // AudioDecoder.configure). The joined output must match a linear decode.
+
+  group('segmented decoding', () {
+    tearDown(() => AudioDecoder.configure(decodeSegments: 1));
+
+    testWidgets('segmented decode matches linear decode byte for byte',
+        (WidgetTester tester) async {
+      // 70 s of 16-bit mono is over 1 MB and long enough for two 30 s segments.
+      const sampleRate = 22050;
+      final inputPath = tempOutputPath('segmented_input', 'wav');
+      await File(inputPath)
+          .writeAsBytes(monoWav(sampleRate, tone(sampleRate, 70 * sampleRate)));
+      final segmentedPath = tempOutputPath('segmented', 'wav');
+      final linearPath = tempOutputPath('linear', 'wav');
+
+      final before = await AudioDecoder.getDecoderStats();
+      await AudioDecoder.configure(decodeSegments: 4);
+      // bitDepth forces a decode instead of a passthrough copy.
+      await AudioDecoder.convertToWav(inputPath, segmentedPath, bitDepth: 24);
+      final after = await AudioDecoder.getDecoderStats();
+      expect(after['segmentedDecode']['jobs'],
+          greaterThan(before['segmentedDecode']['jobs']));
+
+      await AudioDecoder.configure(decodeSegments: 1);
+      await AudioDecoder.convertToWav(inputPath, linearPath, bitDepth: 24);
+
+      final segmented = await File(segmentedPath).readAsBytes();
+      final linear = await File(linearPath).readAsBytes();
+      expect(segmented.length, linear.length);
+      expect(segmented, linear);
+    });
+  });
+
   // ── 3. convertToM4a ─────────────────────────────────────────────────
 
   group('convertToM4a', () {
@@ -268,6 +303,33 @@ void main() {
       expect(trimmedSize, lessThan(fullSize),
           reason: 'Trimmed file should be smaller than the full file');
     });
+
+    testWidgets('trimmed M4A starts and ends at the requested range',
+        (WidgetTester tester) async {
+      // 1 s of silence followed by 1 s of a full-scale 440 Hz tone, so any
+      // audio from before the range shows up as a quiet start.
+      const rate = 44100;
+      final input = silenceThenToneWav(rate);
+      final inputPath = '${tempDir.path}/silence_then_tone.wav';
+      await File(inputPath).writeAsBytes(input);
+
+      final trimmedPath = tempOutputPath('trim_range', 'm4a');
+      await AudioDecoder.trimAudio(
+        inputPath,
+        trimmedPath,
+        const Duration(milliseconds: 1000),
+        const Duration(milliseconds: 1800),
+      );
+
+      final info = await AudioDecoder.getAudioInfo(trimmedPath);
+      // AAC priming and frame rounding add a few tens of milliseconds.
+      expect(info.duration.inMilliseconds, closeTo(800, 60));
+
+      final waveform = await AudioDecoder.getWaveform(trimmedPath,
+          numberOfSamples: 16);
+      expect(waveform.first, greaterThan(0.5),
+          reason: 'The trimmed M4A must start inside the tone');
+    });
   });
 
   // ── 6. getWaveform ──────────────────────────────────────────────────
@@ -1,3 +1,4 @@
+import 'dart:math';
 import 'dart:typed_data';
 
 import 'package:flutter_test/flutter_test.dart';
@@ -39,3 +40,46 @@ Map<String, int> validateWavHeader(Uint8List bytes) {
     'bitsPerSample': bitsPerSample,
   };
 }
+
+/// A mono 16-bit WAV of [samples] at [sampleRate].
+Uint8List monoWav(int sampleRate, Int16List samples) {
+  final data = ByteData(44 + samples.length * 2);
+  void writeString(int offset, String s) {
+    for (var i = 0; i < s.length; i++) {
+      data.setUint8(offset + i, s.codeUnitAt(i));
+    }
+  }
+
+  writeString(0, 'RIFF');
+  data.setUint32(4, 36 + samples.length * 2, Endian.little);
+  writeString(8, 'WAVE');
+  writeString(12, 'fmt ');
+  data.setUint32(16, 16, Endian.little);
+  data.setUint16(20, 1, Endian.little);
+  data.setUint16(22, 1, Endian.little);
+  data.setUint32(24, sampleRate, Endian.little);
+  data.setUint32(28, sampleRate * 2, Endian.little);
+  data.setUint16(32, 2, Endian.little);
+  data.setUint16(34, 16, Endian.little);
+  writeString(36, 'data');
+  data.setUint32(40, samples.length * 2, Endian.little);
+  for (var i = 0; i < samples.length; i++) {
+    data.setInt16(44 + i * 2, samples[i], Endian.little);
+  }
+  return data.buffer.asUint8List();
+}
+
+/// [length] samples at [sampleRate] holding a full-scale 440 Hz tone from
+/// sample [from] on, and silence before it.
+Int16List tone(int sampleRate, int length, {int from = 0}) {
+  final samples = Int16List(length);
+  for (var i = from; i < length; i++) {
+    samples[i] = (32767 * sin(2 * pi * 440 * i / sampleRate)).round();
+  }
+  return samples;
+}
+
+/// A mono 16-bit WAV of 1 s of silence followed by 1 s of a full-scale
+/// 440 Hz tone at [sampleRate].
+Uint8List silenceThenToneWav(int sampleRate) =>
+    monoWav(sampleRate, tone(sampleRate, 2 * sampleRate, from: sampleRate));
@@ -0,0 +1,91 @@
+import 'wav_sample_format.dart';
+
+/// One conversion in a call to [AudioDecoder.convertBatch].
+final class AudioBatchItem {
+  /// Absolute path of the source audio file.
+  final String inputPath;
+
+  /// Absolute path where the converted file will be written.
+  final String outputPath;
+
+  /// Output format, `'wav'` or `'m4a'`.
+  final String format;
+
+  /// Output sample rate for WAV output; defaults to the source rate.
+  final int? sampleRate;
+
+  /// Output channel count for WAV output; defaults to the source channels.
+  final int? channels;
+
+  /// Output bit depth for WAV output; defaults to 16.
+  final int? bitDepth;
+
+  /// Sample encoding for WAV output.
+  final WavSampleFormat sampleFormat;
+
+  /// Creates an item that converts [inputPath] to a WAV file, with the same
+  /// options as [AudioDecoder.convertToWav].
+  const AudioBatchItem.wav(this.inputPath, this.outputPath,
+      {this.sampleRate, this.channels, this.bitDepth, this.sampleFormat = WavSampleFormat.integer})
+      : format = 'wav';
+
+  /// Creates an item that converts [inputPath] to an M4A (AAC) file.
+  const AudioBatchItem.m4a(this.inputPath, this.outputPath)
+      : format = 'm4a',
+        sampleRate = null,
+        channels = null,
+        bitDepth = null,
+        sampleFormat = WavSampleFormat.integer;
+
+  @override
+  String toString() => 'AudioBatchItem($format: $inputPath -> $outputPath)';
+}
+
+/// Outcome of one [AudioBatchItem].
+final class AudioBatchItemResult {
+  /// Position of the item in the list passed to [AudioDecoder.convertBatch].
+  final int index;
+
+  /// The item's [AudioBatchItem.inputPath].
+  final String inputPath;
+
+  /// The item's [AudioBatchItem.outputPath].
+  final String outputPath;
+
+  /// Why the item failed, or `null` if it was converted.
+  final String? error;
+
+  /// Creates an [AudioBatchItemResult].
+  const AudioBatchItemResult({
+    required this.index,
+    required this.inputPath,
+    required this.outputPath,
+    this.error,
+  });
+
+  /// Whether the item was converted.
+  bool get succeeded => error == null;
+
+  @override
+  String toString() =>
+      'AudioBatchItemResult(index: $index, inputPath: $inputPath, '
+      'outputPath: $outputPath${error != null ? ', error: $error' : ''})';
+}
+
+/// Outcome of a whole [AudioDecoder.convertBatch] call.
+final class AudioBatchResult {
+  /// One result per item, in the order the items were given.
+  final List<AudioBatchItemResult> items;
+
+  /// Creates an [AudioBatchResult] from the per-item [items].
+  const AudioBatchResult(this.items);
+
+  /// The items that failed.
+  Iterable<AudioBatchItemResult> get failures => items.where((item) => !item.succeeded);
+
+  /// Whether every item was converted.
+  bool get allSucceeded => items.every((item) => item.succeeded);
+
+  @override
+  String toString() => 'AudioBatchResult(items: ${items.length}, failed: ${failures.length})';
+}
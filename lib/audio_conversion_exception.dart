@@ -16,3 +16,14 @@ final class AudioConversionException implements Exception {
   @override
   String toString() => 'AudioConversionException: $message${details != null ? ' ($details)' : ''}';
 }
+
+/// Exception thrown when an operation was stopped by `AudioDecoder.cancel`.
+///
+/// Any partial output of the operation has been removed.
+final class AudioJobCancelledException extends AudioConversionException {
+  /// Creates an [AudioJobCancelledException] with the given [message].
+  AudioJobCancelledException([super.message = 'Job was cancelled']);
+
+  @override
+  String toString() => 'AudioJobCancelledException: $message';
+}
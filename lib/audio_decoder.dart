@@ -1,10 +1,18 @@
 import 'dart:typed_data';
 
+import 'audio_batch.dart';
 import 'audio_decoder_platform_interface.dart';
 import 'audio_info.dart';
+import 'audio_job_progress.dart';
+import 'audio_pcm_stream.dart';
+import 'wav_sample_format.dart';
 
+export 'audio_batch.dart';
 export 'audio_conversion_exception.dart';
 export 'audio_info.dart';
+export 'audio_job_progress.dart';
+export 'audio_pcm_stream.dart';
+export 'wav_sample_format.dart';
 
 /// A lightweight audio decoder and converter using native platform APIs.
 ///
@@ -18,9 +26,17 @@ final class AudioDecoder {
   /// [sampleRate] optionally sets the output sample rate (e.g., 44100). Defaults to source sample rate.
   /// [channels] optionally sets the number of output channels (e.g., 1 for mono, 2 for stereo). Defaults to source channels.
   /// [bitDepth] optionally sets the output bit depth (e.g., 16, 24). Defaults to 16.
+  /// [sampleFormat] selects float or decoder-native samples instead of
+  /// integers (Linux only; other platforms write integers).
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
+  ///
+  /// On Linux, a PCM WAV input that already has the requested format is
+  /// copied by the kernel instead of decoded, and output with more than
+  /// 4 GB of samples is written as RF64.
   ///
   /// Returns the output path on success.
-  /// Throws [ArgumentError] if [sampleRate], [channels], or [bitDepth] is invalid.
+  /// Throws [ArgumentError] if [sampleRate], [channels], or [bitDepth] is
+  /// invalid, or [bitDepth] is set for a non-integer [sampleFormat].
   /// Throws [AudioConversionException] on failure.
   static Future<String> convertToWav(
     String inputPath,
@@ -28,36 +44,85 @@ final class AudioDecoder {
     int? sampleRate,
     int? channels,
     int? bitDepth,
+    WavSampleFormat sampleFormat = WavSampleFormat.integer,
+    String? jobId,
   }) {
-    _validateWavParameters(sampleRate: sampleRate, channels: channels, bitDepth: bitDepth);
-    return AudioDecoderPlatform.instance.convertToWav(inputPath, outputPath, sampleRate: sampleRate, channels: channels, bitDepth: bitDepth);
+    _validateWavParameters(sampleRate: sampleRate, channels: channels, bitDepth: bitDepth, sampleFormat: sampleFormat);
+    return AudioDecoderPlatform.instance.convertToWav(inputPath, outputPath, sampleRate: sampleRate, channels: channels, bitDepth: bitDepth, sampleFormat: sampleFormat, jobId: jobId);
   }
 
   /// Converts an audio file (MP3, WAV, FLAC, etc.) to M4A (AAC) format.
   ///
   /// [inputPath] is the absolute path to the source audio file.
   /// [outputPath] is the absolute path where the M4A file will be written.
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
   ///
   /// Returns the output path on success.
   /// Throws [AudioConversionException] on failure.
-  static Future<String> convertToM4a(String inputPath, String outputPath) {
-    return AudioDecoderPlatform.instance.convertToM4a(inputPath, outputPath);
+  static Future<String> convertToM4a(String inputPath, String outputPath, {String? jobId}) {
+    return AudioDecoderPlatform.instance.convertToM4a(inputPath, outputPath, jobId: jobId);
+  }
+
+  /// Converts many files in one call.
+  ///
+  /// The items run concurrently on the native worker pool (see
+  /// `maxConcurrentJobs` in [configure]), so throughput scales with the
+  /// number of cores without any scheduling on the Dart side. A failing item
+  /// does not stop the others: its [AudioBatchItemResult.error] is set
+  /// instead. [onItemDone] is called as each item finishes, in completion
+  /// order.
+  ///
+  /// [jobId] lets [cancel] stop the whole batch, in which case this throws
+  /// [AudioJobCancelledException]; one is created if omitted.
+  ///
+  /// Returns one result per item, in the order of [items].
+  /// Throws [ArgumentError] if a WAV item has an invalid option.
+  static Future<AudioBatchResult> convertBatch(
+    List<AudioBatchItem> items, {
+    void Function(AudioBatchItemResult result)? onItemDone,
+    String? jobId,
+  }) {
+    for (final item in items) {
+      _validateWavParameters(sampleRate: item.sampleRate, channels: item.channels, bitDepth: item.bitDepth, sampleFormat: item.sampleFormat);
+    }
+    if (items.isEmpty) return Future.value(const AudioBatchResult([]));
+    return AudioDecoderPlatform.instance.convertBatch(items, jobId: jobId ?? createJobId(), onItemDone: onItemDone);
   }
 
   /// Returns metadata about the audio file at [path].
   ///
   /// Includes duration, sample rate, channel count, bit rate, and format.
+  /// On Linux, PCM WAV, AIFF, FLAC, MP3 and AAC/ALAC M4A files are read
+  /// from their headers without starting a GStreamer probe.
   /// Throws [AudioConversionException] if the file cannot be read.
   static Future<AudioInfo> getAudioInfo(String path) {
     return AudioDecoderPlatform.instance.getAudioInfo(path);
   }
 
+  /// Returns metadata for every file in [paths], in the same order.
+  ///
+  /// Meant for indexing many files: on Linux all of them are probed in one
+  /// call by a pool of long-lived discoverers working in parallel, instead
+  /// of one [getAudioInfo] round trip and probe after another. Other
+  /// platforms probe the files one at a time. A file that cannot be read
+  /// gets an [AudioInfoResult.error] instead of failing the call.
+  ///
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
+  static Future<List<AudioInfoResult>> getAudioInfoBatch(List<String> paths, {String? jobId}) {
+    if (paths.isEmpty) return Future.value(const []);
+    return AudioDecoderPlatform.instance.getAudioInfoBatch(paths, jobId: jobId);
+  }
+
   /// Trims the audio file to the specified time range.
   ///
   /// [inputPath] is the absolute path to the source audio file.
   /// [outputPath] is the absolute path where the trimmed file will be written.
   /// The output format is determined by the file extension (.wav or .m4a).
   /// [start] and [end] define the time range to extract.
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
+  ///
+  /// On Linux, trimming a 16-bit PCM WAV file to WAV copies just the bytes
+  /// of the range.
   ///
   /// Returns the output path on success.
   /// Throws [AudioConversionException] on failure.
@@ -65,9 +130,10 @@ final class AudioDecoder {
     String inputPath,
     String outputPath,
     Duration start,
-    Duration end,
-  ) {
-    return AudioDecoderPlatform.instance.trimAudio(inputPath, outputPath, start, end);
+    Duration end, {
+    String? jobId,
+  }) {
+    return AudioDecoderPlatform.instance.trimAudio(inputPath, outputPath, start, end, jobId: jobId);
   }
 
   /// Extracts waveform amplitude data from the audio file.
@@ -75,17 +141,82 @@ final class AudioDecoder {
   /// Returns a list of [numberOfSamples] normalized amplitude values (0.0–1.0).
   /// Useful for rendering waveform visualizations.
   ///
+  /// [start] and [end] limit the waveform to a time range, for example the
+  /// visible part of a zoomed editor; by default the whole file is used.
+  /// Ranges are currently honored on Linux only.
+  ///
+  /// On Linux the first request for a file builds a min/max/RMS pyramid and
+  /// stores it in the user cache directory. Later requests for the same,
+  /// unmodified file at any resolution or range are answered from it without
+  /// decoding. See [configure] to turn this off.
+  ///
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
+  ///
   /// Throws [AudioConversionException] if the file cannot be decoded.
+  /// Throws [ArgumentError] if [end] is not after [start].
   static Future<List<double>> getWaveform(
     String path, {
     int numberOfSamples = 100,
+    Duration? start,
+    Duration? end,
+    String? jobId,
+  }) {
+    if (start != null && end != null && end <= start) {
+      throw ArgumentError.value(end, 'end', 'Must be after start');
+    }
+    return AudioDecoderPlatform.instance.getWaveform(path, numberOfSamples, start: start, end: end, jobId: jobId);
+  }
+
+  /// Decodes the audio file at [inputPath] and delivers its PCM as it is
+  /// decoded, in chunks of about [chunkSize] bytes.
+  ///
+  /// Unlike [convertToWavBytes], the first chunk arrives as soon as it is
+  /// decoded, so playback or analysis can start before the whole file is
+  /// done. Decoding follows the listener: while the subscription is paused
+  /// the native decoder stops after a few chunks, so memory use stays fixed
+  /// however long the file is. Cancelling the subscription stops decoding.
+  ///
+  /// [sampleRate] and [channels] default to the source's. [format] selects
+  /// 16-bit integer or 32-bit float samples. [start] and [end] limit
+  /// decoding to a time range. [jobId] names the call in [progressEvents]
+  /// and for [cancel]; one is created if omitted.
+  ///
+  /// Decoding starts when the stream is listened to. Errors are delivered
+  /// on the stream as [AudioConversionException]s, including when 16
+  /// streams are already running. Currently supported on Linux only.
+  /// Throws [ArgumentError] if [sampleRate], [channels] or [chunkSize] is
+  /// not positive, or if [end] is not after [start].
+  static Stream<AudioPcmChunk> decodeStream(
+    String inputPath, {
+    int? sampleRate,
+    int? channels,
+    AudioPcmFormat format = AudioPcmFormat.s16,
+    int chunkSize = 64 * 1024,
+    Duration? start,
+    Duration? end,
+    String? jobId,
   }) {
-    return AudioDecoderPlatform.instance.getWaveform(path, numberOfSamples);
+    _validateWavParameters(sampleRate: sampleRate, channels: channels);
+    if (chunkSize <= 0) {
+      throw ArgumentError.value(chunkSize, 'chunkSize', 'Must be positive');
+    }
+    if (start != null && end != null && end <= start) {
+      throw ArgumentError.value(end, 'end', 'Must be after start');
+    }
+    return AudioDecoderPlatform.instance.decodeStream(inputPath,
+        sampleRate: sampleRate,
+        channels: channels,
+        format: format,
+        chunkSize: chunkSize,
+        start: start,
+        end: end,
+        jobId: jobId ?? createJobId());
   }
 
-  /// Validates [sampleRate], [channels], and [bitDepth] parameters
-  /// shared by all WAV conversion methods.
-  static void _validateWavParameters({int? sampleRate, int? channels, int? bitDepth}) {
+  /// Validates [sampleRate], [channels], [bitDepth], and [sampleFormat]
+  /// parameters shared by all WAV conversion methods.
+  static void _validateWavParameters({int? sampleRate, int? channels, int? bitDepth,
+      WavSampleFormat sampleFormat = WavSampleFormat.integer}) {
     if (sampleRate != null && sampleRate <= 0) {
       throw ArgumentError.value(sampleRate, 'sampleRate', 'Must be positive');
     }
@@ -95,6 +226,9 @@ final class AudioDecoder {
     if (bitDepth != null && !const [8, 16, 24, 32].contains(bitDepth)) {
       throw ArgumentError.value(bitDepth, 'bitDepth', 'Must be 8, 16, 24, or 32');
     }
+    if (bitDepth != null && sampleFormat != WavSampleFormat.integer) {
+      throw ArgumentError.value(bitDepth, 'bitDepth', 'Only applies to integer samples');
+    }
   }
 
   /// Known audio extensions that can be converted to WAV.
@@ -140,11 +274,16 @@ final class AudioDecoder {
   /// [sampleRate] optionally sets the output sample rate (e.g., 44100). Defaults to source sample rate.
   /// [channels] optionally sets the number of output channels (e.g., 1 for mono, 2 for stereo). Defaults to source channels.
   /// [bitDepth] optionally sets the output bit depth (e.g., 16, 24). Defaults to 16.
+  /// [sampleFormat] selects float or decoder-native samples instead of
+  /// integers (Linux only; other platforms write integers).
   /// [includeHeader] when true (default), returns a complete WAV file with the
-  /// 44-byte RIFF/WAV header. When false, returns only raw interleaved PCM data.
+  /// RIFF/WAV header (44 bytes, or 80 for float samples). When false, returns
+  /// only raw interleaved PCM data.
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
   ///
   /// Returns the WAV file bytes (or raw PCM bytes if [includeHeader] is false).
-  /// Throws [ArgumentError] if [sampleRate], [channels], or [bitDepth] is invalid.
+  /// Throws [ArgumentError] if [sampleRate], [channels], or [bitDepth] is
+  /// invalid, or [bitDepth] is set for a non-integer [sampleFormat].
   /// Throws [AudioConversionException] on failure.
   static Future<Uint8List> convertToWavBytes(
     Uint8List inputData, {
@@ -152,23 +291,26 @@ final class AudioDecoder {
     int? sampleRate,
     int? channels,
     int? bitDepth,
+    WavSampleFormat sampleFormat = WavSampleFormat.integer,
     bool includeHeader = true,
+    String? jobId,
   }) {
-    _validateWavParameters(sampleRate: sampleRate, channels: channels, bitDepth: bitDepth);
+    _validateWavParameters(sampleRate: sampleRate, channels: channels, bitDepth: bitDepth, sampleFormat: sampleFormat);
     return AudioDecoderPlatform.instance.convertToWavBytes(inputData, formatHint,
         sampleRate: sampleRate, channels: channels, bitDepth: bitDepth,
-        includeHeader: includeHeader);
+        sampleFormat: sampleFormat, includeHeader: includeHeader, jobId: jobId);
   }
 
   /// Converts audio bytes to M4A (AAC) format.
   ///
   /// [inputData] is the raw bytes of the source audio file.
   /// [formatHint] indicates the input format (e.g., 'mp3', 'wav', 'flac').
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
   ///
   /// Returns the M4A file bytes.
   /// Throws [AudioConversionException] on failure.
-  static Future<Uint8List> convertToM4aBytes(Uint8List inputData, {required String formatHint}) {
-    return AudioDecoderPlatform.instance.convertToM4aBytes(inputData, formatHint);
+  static Future<Uint8List> convertToM4aBytes(Uint8List inputData, {required String formatHint, String? jobId}) {
+    return AudioDecoderPlatform.instance.convertToM4aBytes(inputData, formatHint, jobId: jobId);
   }
 
   /// Returns metadata about the audio data in [inputData].
@@ -186,6 +328,7 @@ final class AudioDecoder {
   /// [formatHint] indicates the input format (e.g., 'mp3', 'm4a').
   /// [start] and [end] define the time range to extract.
   /// [outputFormat] determines the output encoding ('wav' or 'm4a').
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
   ///
   /// Returns the trimmed audio bytes.
   /// Throws [AudioConversionException] on failure.
@@ -195,8 +338,9 @@ final class AudioDecoder {
     required Duration start,
     required Duration end,
     String outputFormat = 'wav',
+    String? jobId,
   }) {
-    return AudioDecoderPlatform.instance.trimAudioBytes(inputData, formatHint, start, end, outputFormat: outputFormat);
+    return AudioDecoderPlatform.instance.trimAudioBytes(inputData, formatHint, start, end, outputFormat: outputFormat, jobId: jobId);
   }
 
   /// Extracts waveform amplitude data from audio bytes.
@@ -204,13 +348,230 @@ final class AudioDecoder {
   /// [inputData] is the raw bytes of the source audio file.
   /// [formatHint] indicates the input format (e.g., 'mp3', 'm4a').
   /// Returns a list of [numberOfSamples] normalized amplitude values (0.0–1.0).
+  /// [jobId] lets [cancel] stop the call; see [createJobId].
   ///
   /// Throws [AudioConversionException] if the data cannot be decoded.
   static Future<List<double>> getWaveformBytes(
     Uint8List inputData, {
     required String formatHint,
     int numberOfSamples = 100,
+    String? jobId,
+  }) {
+    return AudioDecoderPlatform.instance.getWaveformBytes(inputData, formatHint, numberOfSamples, jobId: jobId);
+  }
+
+  static int _jobCounter = 0;
+
+  /// Returns a new ID to pass as `jobId` to a conversion, trim or waveform
+  /// call, so that the call can later be stopped with [cancel] and followed
+  /// with [progressOf].
+  ///
+  /// IDs are unique within the running app. Any other string works too, as
+  /// long as no two running calls share it.
+  static String createJobId() {
+    _jobCounter++;
+    return 'job-${DateTime.now().microsecondsSinceEpoch}-$_jobCounter';
+  }
+
+  /// Stops the call started with [jobId].
+  ///
+  /// The call's future then completes with an [AudioJobCancelledException]
+  /// and any partially written output is deleted. A call that is still
+  /// queued never starts.
+  ///
+  /// Returns `true` if a running or queued call with that ID was found,
+  /// `false` if it has already finished or the ID is unknown. Cancellation
+  /// is currently supported on Linux; other platforms return `false` and let
+  /// the call run to completion.
+  static Future<bool> cancel(String jobId) {
+    return AudioDecoderPlatform.instance.cancel(jobId);
+  }
+
+  /// Progress of every running call that was started with a `jobId`.
+  ///
+  /// Events arrive at most once per `progressInterval` (see [configure]) per
+  /// call, and each call ends with an event whose
+  /// [AudioJobProgress.done] is `true`. The stream is currently fed on
+  /// Linux only; other platforms emit nothing.
+  static Stream<AudioJobProgress> get progressEvents {
+    return AudioDecoderPlatform.instance.progressEvents;
+  }
+
+  /// Progress of the call started with [jobId]; closes after its last event.
+  ///
+  /// Listen before starting the call, or early events are missed.
+  static Stream<AudioJobProgress> progressOf(String jobId) async* {
+    await for (final event in progressEvents) {
+      if (event.jobId != jobId) continue;
+      yield event;
+      if (event.done) return;
+    }
+  }
+
+  /// Adjusts native decoder settings that apply to all subsequent calls.
+  ///
+  /// [maxQueuedBuffers] and [maxQueuedBytes] bound how much decoded audio may
+  /// queue up ahead of a slow consumer (for example a slow disk). When the
+  /// limit is reached the decoder waits instead of dropping data, so peak
+  /// memory per job stays fixed. Pass `0` to lift a limit.
+  ///
+  /// [waveformSampleRate] caps the rate at which waveform requests decode. On
+  /// Linux, waveforms are computed from a mono downmix resampled to at most this
+  /// rate (8000 Hz by default) instead of the full-rate source.
+  ///
+  /// [waveformCache] enables or disables the on-disk waveform pyramid used
+  /// by [getWaveform] (enabled by default).
+  ///
+  /// [decodeSegments] sets how many parts of a long PCM WAV, AIFF or FLAC
+  /// file are decoded in parallel by [convertToWav] and [getWaveform] on
+  /// Linux. `1` (the default) decodes linearly; `0` uses one per CPU core,
+  /// up to 8. Compressed formats are never split, as their seeks are not
+  /// sample-accurate.
+  ///
+  /// [maxConcurrentJobs] sets how many calls the Linux decoder runs at once.
+  /// Further calls wait in a queue until a worker is free. `0` (the default)
+  /// uses one worker per CPU core.
+  ///
+  /// [progressInterval] sets how often [progressEvents] reports on each
+  /// running call (every 200 ms by default).
+  ///
+  /// [scratchDirectory] and [scratchMemoryBudget] control the few temporary
+  /// files the Linux decoder cannot avoid. They are kept in anonymous memory
+  /// while no more than [scratchMemoryBudget] bytes (64 MB by default) are in
+  /// use; beyond that they go to unnamed files in [scratchDirectory]
+  /// (`$TMPDIR` or `/tmp` by default). Scratch files have no name and are
+  /// released when the process exits, even if it crashes. Scratch that
+  /// outgrows the budget while being written fails the call with an
+  /// [AudioConversionException] instead of exceeding it. A budget of `0`
+  /// keeps all scratch on disk.
+  ///
+  /// [infoTimeout] limits how long probing one file for [getAudioInfo] and
+  /// [getAudioInfoBatch] may take on Linux (5 seconds by default).
+  ///
+  /// [streamPauseTimeout] limits how long a [decodeStream] waits for a
+  /// paused listener before failing with an [AudioConversionException]
+  /// (5 minutes by default). Paused streams run outside the
+  /// [maxConcurrentJobs] workers, so they never hold up other calls;
+  /// [Duration.zero] waits indefinitely.
+  ///
+  /// [infoCacheEntries] sets how many [getAudioInfo] results the Linux
+  /// decoder keeps for local files (4096 by default; `0` disables the
+  /// cache). A result is reused until the file's size or modification time
+  /// changes. With [infoCacheFile] the results are also saved to that file
+  /// and loaded from it on the next start; an empty string keeps them in
+  /// memory only.
+  ///
+  /// [wavPreallocate] makes the Linux decoder allocate WAV output files at
+  /// their expected size before writing (enabled by default), and
+  /// [wavDirectIo] writes large WAV outputs (64 MB and up) with `O_DIRECT`,
+  /// bypassing the page cache (disabled by default). Compare the write
+  /// counters under `wavWriter` in [getDecoderStats] to pick the faster
+  /// setting for a file system.
+  ///
+  /// Only parameters that are non-null are changed. Platforms without
+  /// tunable settings ignore the call.
+  /// Throws [ArgumentError] if a value is negative, or if
+  /// [waveformSampleRate] or [infoTimeout] is not positive.
+  static Future<void> configure({
+    int? maxQueuedBuffers,
+    int? maxQueuedBytes,
+    int? waveformSampleRate,
+    bool? waveformCache,
+    int? decodeSegments,
+    int? maxConcurrentJobs,
+    Duration? progressInterval,
+    String? scratchDirectory,
+    int? scratchMemoryBudget,
+    Duration? infoTimeout,
+    Duration? streamPauseTimeout,
+    int? infoCacheEntries,
+    String? infoCacheFile,
+    bool? wavPreallocate,
+    bool? wavDirectIo,
   }) {
-    return AudioDecoderPlatform.instance.getWaveformBytes(inputData, formatHint, numberOfSamples);
+    if (maxQueuedBuffers != null && maxQueuedBuffers < 0) {
+      throw ArgumentError.value(maxQueuedBuffers, 'maxQueuedBuffers', 'Must not be negative');
+    }
+    if (maxQueuedBytes != null && maxQueuedBytes < 0) {
+      throw ArgumentError.value(maxQueuedBytes, 'maxQueuedBytes', 'Must not be negative');
+    }
+    if (decodeSegments != null && decodeSegments < 0) {
+      throw ArgumentError.value(decodeSegments, 'decodeSegments', 'Must not be negative');
+    }
+    if (maxConcurrentJobs != null && maxConcurrentJobs < 0) {
+      throw ArgumentError.value(maxConcurrentJobs, 'maxConcurrentJobs', 'Must not be negative');
+    }
+    if (progressInterval != null && progressInterval.isNegative) {
+      throw ArgumentError.value(progressInterval, 'progressInterval', 'Must not be negative');
+    }
+    if (scratchMemoryBudget != null && scratchMemoryBudget < 0) {
+      throw ArgumentError.value(scratchMemoryBudget, 'scratchMemoryBudget', 'Must not be negative');
+    }
+    if (infoCacheEntries != null && infoCacheEntries < 0) {
+      throw ArgumentError.value(infoCacheEntries, 'infoCacheEntries', 'Must not be negative');
+    }
+    if (streamPauseTimeout != null && streamPauseTimeout.isNegative) {
+      throw ArgumentError.value(streamPauseTimeout, 'streamPauseTimeout', 'Must not be negative');
+    }
+    if (infoTimeout != null && infoTimeout <= Duration.zero) {
+      throw ArgumentError.value(infoTimeout, 'infoTimeout', 'Must be positive');
+    }
+    if (waveformSampleRate != null && waveformSampleRate <= 0) {
+      throw ArgumentError.value(waveformSampleRate, 'waveformSampleRate', 'Must be positive');
+    }
+    return AudioDecoderPlatform.instance.configure(
+        maxQueuedBuffers: maxQueuedBuffers,
+        maxQueuedBytes: maxQueuedBytes,
+        waveformSampleRate: waveformSampleRate,
+        waveformCache: waveformCache,
+        decodeSegments: decodeSegments,
+        maxConcurrentJobs: maxConcurrentJobs,
+        progressIntervalMs: progressInterval?.inMilliseconds,
+        scratchDirectory: scratchDirectory,
+        scratchMemoryBytes: scratchMemoryBudget,
+        infoTimeoutMs: infoTimeout?.inMilliseconds,
+        streamPauseTimeoutMs: streamPauseTimeout?.inMilliseconds,
+        infoCacheEntries: infoCacheEntries,
+        infoCacheFile: infoCacheFile,
+        wavPreallocate: wavPreallocate,
+        wavDirectIo: wavDirectIo);
+  }
+
+  /// Returns counters reported by the native decoder, grouped by subsystem.
+  ///
+  /// On Linux this includes `pipelinePool`, with decode pipeline reuse
+  /// `hits` and `misses` in total and per output caps under `pools`, and
+  /// `decodeQueue`, with the configured limits and the `peakBuffers` /
+  /// `peakBytes` high-water marks reached by any job, and `analysis`, with
+  /// the `sampleRate` and `channels` used for waveform decoding, and
+  /// `waveformCache`, with pyramid sidecar `hits` and `misses`, and
+  /// `segmentedDecode`, with the number of parallel decode `jobs`, and
+  /// `wavPassthrough`, with the WAV outputs (`jobs`) and `bytes` copied
+  /// from matching PCM WAV inputs without decoding, and `wavWriter`, with
+  /// the WAV `files` written, their `bytes`, the `writeCalls` and
+  /// `writeCallsPerMB` made, the `writeMs` spent in them, the
+  /// `preallocatedBytes` and the number of `directFiles`, and
+  /// `executor`, with the worker count, `queued` and `peakQueued` call
+  /// counts, the `averageWaitMs` / `maxWaitMs` calls spent queued and the
+  /// number of `cancelled` calls, and `memoryInput`, with the number of
+  /// bytes-API `inputs` decoded from memory and the `bytesServed` to them,
+  /// and `scratch`, with the number of `memoryFiles` and `diskFiles`
+  /// created for temporary data, how many were `spilled` to disk over the
+  /// budget and the `memoryBytes` / `peakMemoryBytes` in use, and
+  /// `pcmStream`, with the [decodeStream] `chunks` and `bytes` sent and the
+  /// number of `stalls` where decoding waited for a paused listener and of
+  /// `timeouts` where it gave up on one, and
+  /// `infoProbe`, with the probe `timeoutMs`, the number of pooled
+  /// `discoverers`, the files `discovered`, `failed`, hit by `timeouts` and
+  /// dropped unprobed from a `cancelled` batch, and the `inFlight` /
+  /// `peakInFlight` probes, and `infoCache`, with the
+  /// cached `entries` and `capacity`, the lookup `hits`, `misses` and
+  /// `hitRate`, the entries found `stale` and the `evictions`, and
+  /// `headerProbe`, with the number of files whose metadata was read from
+  /// their headers (`recognized`) or left to GStreamer (`unrecognized`) and
+  /// the `averageMicros` a header read took.
+  /// Platforms that do not report statistics return an empty map.
+  static Future<Map<String, dynamic>> getDecoderStats() {
+    return AudioDecoderPlatform.instance.getDecoderStats();
   }
 }
@@ -1,9 +1,26 @@
+import 'dart:async';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
+import 'audio_batch.dart';
 import 'audio_conversion_exception.dart';
 import 'audio_decoder_platform_interface.dart';
 import 'audio_info.dart';
+import 'audio_job_progress.dart';
+import 'audio_pcm_stream.dart';
+import 'wav_sample_format.dart';
+
+/// Converts a native error into the exception thrown to callers.
+AudioConversionException _conversionError(PlatformException e, String fallback) {
+  if (e.code == 'CANCELLED') {
+    return AudioJobCancelledException(e.message ?? 'Job was cancelled');
+  }
+  return AudioConversionException(
+    e.message ?? fallback,
+    details: e.details?.toString(),
+  );
+}
 
 /// Platform implementation of audio_decoder that uses a method channel to
 /// communicate with native platform code.
@@ -11,16 +28,30 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('audio_decoder');
 
+  @visibleForTesting
+  final eventChannel = const EventChannel('audio_decoder/events');
+
+  Stream<Map<String, dynamic>>? _events;
+
+  /// Events of all kinds, decoded once and shared by every listener.
+  Stream<Map<String, dynamic>> get _nativeEvents {
+    return _events ??= eventChannel
+        .receiveBroadcastStream()
+        .map((event) => Map<String, dynamic>.from(event as Map));
+  }
+
   @override
-  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth}) async {
+  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, String? jobId}) async {
     try {
       final args = <String, dynamic>{
         'inputPath': inputPath,
         'outputPath': outputPath,
+        if (jobId != null) 'jobId': jobId,
       };
       if (sampleRate != null) args['sampleRate'] = sampleRate;
       if (channels != null) args['channels'] = channels;
       if (bitDepth != null) args['bitDepth'] = bitDepth;
+      if (sampleFormat != WavSampleFormat.integer) args['sampleFormat'] = sampleFormat.name;
       final result = await methodChannel.invokeMethod<String>(
         'convertToWav',
         args,
@@ -30,29 +61,23 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown conversion error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown conversion error');
     }
   }
 
   @override
-  Future<String> convertToM4a(String inputPath, String outputPath) async {
+  Future<String> convertToM4a(String inputPath, String outputPath, {String? jobId}) async {
     try {
       final result = await methodChannel.invokeMethod<String>(
         'convertToM4a',
-        {'inputPath': inputPath, 'outputPath': outputPath},
+        {'inputPath': inputPath, 'outputPath': outputPath, if (jobId != null) 'jobId': jobId},
       );
       if (result == null) {
         throw AudioConversionException('Native conversion returned null');
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown conversion error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown conversion error');
     }
   }
 
@@ -66,23 +91,60 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       if (result == null) {
         throw AudioConversionException('Native getAudioInfo returned null');
       }
-      return AudioInfo(
-        duration: Duration(milliseconds: result['durationMs'] as int),
-        sampleRate: result['sampleRate'] as int,
-        channels: result['channels'] as int,
-        bitRate: result['bitRate'] as int,
-        format: result['format'] as String,
-      );
+      return _audioInfoFromMap(result);
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
+      throw _conversionError(e, 'Unknown error');
+    }
+  }
+
+  @override
+  Future<List<AudioInfoResult>> getAudioInfoBatch(List<String> paths, {String? jobId}) async {
+    try {
+      final result = await methodChannel.invokeListMethod<Object?>(
+        'getAudioInfoBatch',
+        {'paths': paths, if (jobId != null) 'jobId': jobId},
       );
+      if (result == null) {
+        throw AudioConversionException('Native getAudioInfoBatch returned null');
+      }
+      return [
+        for (final entry in result.cast<Map<Object?, Object?>>())
+          AudioInfoResult(
+            path: entry['path'] as String,
+            info: entry['info'] == null ? null : _audioInfoFromMap(Map<String, dynamic>.from(entry['info'] as Map)),
+            error: entry['error'] as String?,
+          ),
+      ];
+    } on MissingPluginException {
+      // Platforms without a native batch probe answer one file at a time.
+      return [
+        for (final path in paths) await _probeOne(path),
+      ];
+    } on PlatformException catch (e) {
+      throw _conversionError(e, 'Unknown error');
     }
   }
 
+  Future<AudioInfoResult> _probeOne(String path) async {
+    try {
+      return AudioInfoResult(path: path, info: await getAudioInfo(path));
+    } on AudioConversionException catch (e) {
+      return AudioInfoResult(path: path, error: e.message);
+    }
+  }
+
+  static AudioInfo _audioInfoFromMap(Map<String, dynamic> result) {
+    return AudioInfo(
+      duration: Duration(milliseconds: result['durationMs'] as int),
+      sampleRate: result['sampleRate'] as int,
+      channels: result['channels'] as int,
+      bitRate: result['bitRate'] as int,
+      format: result['format'] as String,
+    );
+  }
+
   @override
-  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end) async {
+  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end, {String? jobId}) async {
     try {
       final result = await methodChannel.invokeMethod<String>(
         'trimAudio',
@@ -91,6 +153,7 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
           'outputPath': outputPath,
           'startMs': start.inMilliseconds,
           'endMs': end.inMilliseconds,
+          if (jobId != null) 'jobId': jobId,
         },
       );
       if (result == null) {
@@ -98,42 +161,38 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown error');
     }
   }
 
   @override
-  Future<List<double>> getWaveform(String path, int numberOfSamples) async {
+  Future<List<double>> getWaveform(String path, int numberOfSamples, {Duration? start, Duration? end, String? jobId}) async {
     try {
-      final result = await methodChannel.invokeListMethod<double>(
-        'getWaveform',
-        {'path': path, 'numberOfSamples': numberOfSamples},
-      );
+      final args = <String, dynamic>{'path': path, 'numberOfSamples': numberOfSamples, if (jobId != null) 'jobId': jobId};
+      if (start != null) args['startMs'] = start.inMilliseconds;
+      if (end != null) args['endMs'] = end.inMilliseconds;
+      final result = await methodChannel.invokeListMethod<double>('getWaveform', args);
       if (result == null) {
         throw AudioConversionException('Native getWaveform returned null');
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown error');
     }
   }
 
   @override
-  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, bool? includeHeader}) async {
+  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, bool? includeHeader, String? jobId}) async {
     try {
       final args = <String, dynamic>{
         'inputData': inputData,
         'formatHint': formatHint,
+        if (jobId != null) 'jobId': jobId,
       };
       if (sampleRate != null) args['sampleRate'] = sampleRate;
       if (channels != null) args['channels'] = channels;
       if (bitDepth != null) args['bitDepth'] = bitDepth;
+      if (sampleFormat != WavSampleFormat.integer) args['sampleFormat'] = sampleFormat.name;
       if (includeHeader != null && includeHeader == false) args['includeHeader'] = false;
       final result = await methodChannel.invokeMethod<Uint8List>(
         'convertToWavBytes',
@@ -144,29 +203,23 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown conversion error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown conversion error');
     }
   }
 
   @override
-  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint) async {
+  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint, {String? jobId}) async {
     try {
       final result = await methodChannel.invokeMethod<Uint8List>(
         'convertToM4aBytes',
-        {'inputData': inputData, 'formatHint': formatHint},
+        {'inputData': inputData, 'formatHint': formatHint, if (jobId != null) 'jobId': jobId},
       );
       if (result == null) {
         throw AudioConversionException('Native conversion returned null');
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown conversion error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown conversion error');
     }
   }
 
@@ -180,23 +233,14 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       if (result == null) {
         throw AudioConversionException('Native getAudioInfo returned null');
       }
-      return AudioInfo(
-        duration: Duration(milliseconds: result['durationMs'] as int),
-        sampleRate: result['sampleRate'] as int,
-        channels: result['channels'] as int,
-        bitRate: result['bitRate'] as int,
-        format: result['format'] as String,
-      );
+      return _audioInfoFromMap(result);
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown error');
     }
   }
 
   @override
-  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav'}) async {
+  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav', String? jobId}) async {
     try {
       final result = await methodChannel.invokeMethod<Uint8List>(
         'trimAudioBytes',
@@ -206,6 +250,7 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
           'startMs': start.inMilliseconds,
           'endMs': end.inMilliseconds,
           'outputFormat': outputFormat,
+          if (jobId != null) 'jobId': jobId,
         },
       );
       if (result == null) {
@@ -213,29 +258,239 @@ final class MethodChannelAudioDecoder extends AudioDecoderPlatform {
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
-      );
+      throw _conversionError(e, 'Unknown error');
     }
   }
 
   @override
-  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples) async {
+  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples, {String? jobId}) async {
     try {
       final result = await methodChannel.invokeListMethod<double>(
         'getWaveformBytes',
-        {'inputData': inputData, 'formatHint': formatHint, 'numberOfSamples': numberOfSamples},
+        {'inputData': inputData, 'formatHint': formatHint, 'numberOfSamples': numberOfSamples, if (jobId != null) 'jobId': jobId},
       );
       if (result == null) {
         throw AudioConversionException('Native getWaveform returned null');
       }
       return result;
     } on PlatformException catch (e) {
-      throw AudioConversionException(
-        e.message ?? 'Unknown error',
-        details: e.details?.toString(),
+      throw _conversionError(e, 'Unknown error');
+    }
+  }
+
+  @override
+  Future<AudioBatchResult> convertBatch(List<AudioBatchItem> items,
+      {required String jobId, void Function(AudioBatchItemResult result)? onItemDone}) async {
+    // Subscribe first so that no item finishing early is missed.
+    final reported = <int>{};
+    final subscription = onItemDone == null
+        ? null
+        : _nativeEvents
+            .where((event) => event['type'] == 'batchItem' && event['jobId'] == jobId)
+            .map(_batchItemFromMap)
+            .listen((item) {
+              if (reported.add(item.index)) onItemDone(item);
+            });
+    try {
+      final result = await methodChannel.invokeMapMethod<String, dynamic>(
+        'convertBatch',
+        {
+          'items': [
+            for (final item in items)
+              {
+                'inputPath': item.inputPath,
+                'outputPath': item.outputPath,
+                'format': item.format,
+                if (item.sampleRate != null) 'sampleRate': item.sampleRate,
+                if (item.channels != null) 'channels': item.channels,
+                if (item.bitDepth != null) 'bitDepth': item.bitDepth,
+                if (item.sampleFormat != WavSampleFormat.integer) 'sampleFormat': item.sampleFormat.name,
+              },
+          ],
+          'jobId': jobId,
+        },
       );
+      if (result == null) {
+        throw AudioConversionException('Native convertBatch returned null');
+      }
+      final batch = AudioBatchResult([
+        for (final item in result['items'] as List) _batchItemFromMap(Map<String, dynamic>.from(item as Map)),
+      ]);
+      // Items whose event has not arrived by now are reported from the
+      // result, so onItemDone still sees every item exactly once.
+      await subscription?.cancel();
+      if (onItemDone != null) {
+        for (final item in batch.items) {
+          if (reported.add(item.index)) onItemDone(item);
+        }
+      }
+      return batch;
+    } on PlatformException catch (e) {
+      throw _conversionError(e, 'Unknown conversion error');
+    } finally {
+      await subscription?.cancel();
+    }
+  }
+
+  static AudioBatchItemResult _batchItemFromMap(Map<String, dynamic> item) {
+    return AudioBatchItemResult(
+      index: item['index'] as int,
+      inputPath: item['inputPath'] as String,
+      outputPath: item['outputPath'] as String,
+      error: item['error'] as String?,
+    );
+  }
+
+  /// Chunks a [decodeStream] may have in flight; more are requested when
+  /// half of them have been delivered to an unpaused listener.
+  static const int _pcmCreditWindow = 4;
+
+  @override
+  Stream<AudioPcmChunk> decodeStream(String inputPath,
+      {int? sampleRate, int? channels, AudioPcmFormat format = AudioPcmFormat.s16, required int chunkSize, Duration? start, Duration? end, required String jobId}) {
+    late final StreamController<AudioPcmChunk> controller;
+    StreamSubscription<Map<String, dynamic>>? subscription;
+    var inFlight = 0;
+    var done = false;
+    var sampleRateOut = 0;
+    var channelsOut = 0;
+    var formatOut = format;
+
+    void requestChunks() {
+      if (done || controller.isPaused || inFlight > _pcmCreditWindow ~/ 2) return;
+      final count = _pcmCreditWindow - inFlight;
+      inFlight += count;
+      methodChannel.invokeMethod<bool>('requestPcmChunks', {'jobId': jobId, 'count': count}).ignore();
+    }
+
+    Future<void> finish([Object? error, StackTrace? stackTrace]) async {
+      if (done) return;
+      done = true;
+      await subscription?.cancel();
+      if (error != null) controller.addError(error, stackTrace);
+      await controller.close();
+    }
+
+    void onEvent(Map<String, dynamic> event) {
+      switch (event['type']) {
+        case 'pcmFormat':
+          sampleRateOut = event['sampleRate'] as int;
+          channelsOut = event['channels'] as int;
+          formatOut = event['float'] as bool ? AudioPcmFormat.f32 : AudioPcmFormat.s16;
+        case 'pcm':
+          inFlight--;
+          controller.add(AudioPcmChunk(
+            data: event['data'] as Uint8List,
+            sampleRate: sampleRateOut,
+            channels: channelsOut,
+            format: formatOut,
+            frameOffset: event['frameOffset'] as int,
+          ));
+          requestChunks();
+        case 'pcmEnd':
+          finish();
+      }
+    }
+
+    controller = StreamController<AudioPcmChunk>(
+      onListen: () {
+        // Subscribe first so that no chunk sent early is missed.
+        subscription = _nativeEvents.where((event) => event['jobId'] == jobId).listen(onEvent);
+        inFlight = _pcmCreditWindow;
+        final args = <String, dynamic>{
+          'inputPath': inputPath,
+          'format': format.name,
+          'chunkBytes': chunkSize,
+          'credits': _pcmCreditWindow,
+          'jobId': jobId,
+        };
+        if (sampleRate != null) args['sampleRate'] = sampleRate;
+        if (channels != null) args['channels'] = channels;
+        if (start != null) args['startMs'] = start.inMilliseconds;
+        if (end != null) args['endMs'] = end.inMilliseconds;
+        methodChannel.invokeMethod<void>('decodeStream', args).catchError((Object e, StackTrace stackTrace) {
+          finish(e is PlatformException ? _conversionError(e, 'Unknown decode error') : e, stackTrace);
+        });
+      },
+      // A paused listener grants no credits, so the native decode stops
+      // once the chunks already requested have been sent.
+      onResume: requestChunks,
+      onCancel: () async {
+        if (done) return;
+        done = true;
+        await subscription?.cancel();
+        await cancel(jobId);
+      },
+    );
+    return controller.stream;
+  }
+
+  @override
+  Future<bool> cancel(String jobId) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>('cancel', {'jobId': jobId});
+      return result ?? false;
+    } on MissingPluginException {
+      // Platforms without cancellation run every job to completion.
+      return false;
+    } on PlatformException catch (e) {
+      throw _conversionError(e, 'Unknown error');
+    }
+  }
+
+  @override
+  Stream<AudioJobProgress> get progressEvents {
+    return _nativeEvents.where((event) => event['type'] == 'progress').map(_progressFromEvent);
+  }
+
+  static AudioJobProgress _progressFromEvent(Map<String, dynamic> event) {
+    final durationMs = event['durationMs'] as int;
+    return AudioJobProgress(
+      jobId: event['jobId'] as String,
+      position: Duration(milliseconds: event['positionMs'] as int),
+      duration: durationMs < 0 ? null : Duration(milliseconds: durationMs),
+      bytesWritten: event['bytesWritten'] as int,
+      realTimeFactor: (event['realTimeFactor'] as num).toDouble(),
+      done: event['done'] as bool,
+    );
+  }
+
+  @override
+  Future<void> configure({int? maxQueuedBuffers, int? maxQueuedBytes, int? waveformSampleRate, bool? waveformCache, int? decodeSegments, int? maxConcurrentJobs, int? progressIntervalMs, String? scratchDirectory, int? scratchMemoryBytes, int? infoTimeoutMs, int? streamPauseTimeoutMs, int? infoCacheEntries, String? infoCacheFile, bool? wavPreallocate, bool? wavDirectIo}) async {
+    try {
+      final args = <String, dynamic>{};
+      if (maxQueuedBuffers != null) args['maxQueuedBuffers'] = maxQueuedBuffers;
+      if (maxQueuedBytes != null) args['maxQueuedBytes'] = maxQueuedBytes;
+      if (waveformSampleRate != null) args['waveformSampleRate'] = waveformSampleRate;
+      if (waveformCache != null) args['waveformCache'] = waveformCache;
+      if (decodeSegments != null) args['decodeSegments'] = decodeSegments;
+      if (maxConcurrentJobs != null) args['maxConcurrentJobs'] = maxConcurrentJobs;
+      if (progressIntervalMs != null) args['progressIntervalMs'] = progressIntervalMs;
+      if (scratchDirectory != null) args['scratchDirectory'] = scratchDirectory;
+      if (scratchMemoryBytes != null) args['scratchMemoryBytes'] = scratchMemoryBytes;
+      if (infoTimeoutMs != null) args['infoTimeoutMs'] = infoTimeoutMs;
+      if (streamPauseTimeoutMs != null) args['streamPauseTimeoutMs'] = streamPauseTimeoutMs;
+      if (infoCacheEntries != null) args['infoCacheEntries'] = infoCacheEntries;
+      if (infoCacheFile != null) args['infoCacheFile'] = infoCacheFile;
+      if (wavPreallocate != null) args['wavPreallocate'] = wavPreallocate;
+      if (wavDirectIo != null) args['wavDirectIo'] = wavDirectIo;
+      await methodChannel.invokeMethod<void>('configure', args);
+    } on MissingPluginException {
+      // Platforms without tunable native settings ignore the call.
+    } on PlatformException catch (e) {
+      throw _conversionError(e, 'Unknown error');
+    }
+  }
+
+  @override
+  Future<Map<String, dynamic>> getDecoderStats() async {
+    try {
+      final result = await methodChannel.invokeMapMethod<String, dynamic>('getDecoderStats');
+      return result ?? <String, dynamic>{};
+    } on MissingPluginException {
+      return <String, dynamic>{};
+    } on PlatformException catch (e) {
+      throw _conversionError(e, 'Unknown error');
     }
   }
 }
@@ -2,8 +2,12 @@ import 'dart:typed_data';
 
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
+import 'audio_batch.dart';
 import 'audio_decoder_method_channel.dart';
 import 'audio_info.dart';
+import 'audio_job_progress.dart';
+import 'audio_pcm_stream.dart';
+import 'wav_sample_format.dart';
 
 /// The interface that platform-specific implementations of audio_decoder must
 /// extend.
@@ -28,11 +32,11 @@ abstract base class AudioDecoderPlatform extends PlatformInterface {
     _instance = instance;
   }
 
-  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth}) {
+  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, String? jobId}) {
     throw UnimplementedError('convertToWav() has not been implemented.');
   }
 
-  Future<String> convertToM4a(String inputPath, String outputPath) {
+  Future<String> convertToM4a(String inputPath, String outputPath, {String? jobId}) {
     throw UnimplementedError('convertToM4a() has not been implemented.');
   }
 
@@ -40,19 +44,23 @@ abstract base class AudioDecoderPlatform extends PlatformInterface {
     throw UnimplementedError('getAudioInfo() has not been implemented.');
   }
 
-  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end) {
+  Future<List<AudioInfoResult>> getAudioInfoBatch(List<String> paths, {String? jobId}) {
+    throw UnimplementedError('getAudioInfoBatch() has not been implemented.');
+  }
+
+  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end, {String? jobId}) {
     throw UnimplementedError('trimAudio() has not been implemented.');
   }
 
-  Future<List<double>> getWaveform(String path, int numberOfSamples) {
+  Future<List<double>> getWaveform(String path, int numberOfSamples, {Duration? start, Duration? end, String? jobId}) {
     throw UnimplementedError('getWaveform() has not been implemented.');
   }
 
-  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, bool? includeHeader}) {
+  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, bool? includeHeader, String? jobId}) {
     throw UnimplementedError('convertToWavBytes() has not been implemented.');
   }
 
-  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint) {
+  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint, {String? jobId}) {
     throw UnimplementedError('convertToM4aBytes() has not been implemented.');
   }
 
@@ -60,11 +68,37 @@ abstract base class AudioDecoderPlatform extends PlatformInterface {
     throw UnimplementedError('getAudioInfoBytes() has not been implemented.');
   }
 
-  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav'}) {
+  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav', String? jobId}) {
     throw UnimplementedError('trimAudioBytes() has not been implemented.');
   }
 
-  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples) {
+  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples, {String? jobId}) {
     throw UnimplementedError('getWaveformBytes() has not been implemented.');
   }
+
+  Future<AudioBatchResult> convertBatch(List<AudioBatchItem> items,
+      {required String jobId, void Function(AudioBatchItemResult result)? onItemDone}) {
+    throw UnimplementedError('convertBatch() has not been implemented.');
+  }
+
+  Stream<AudioPcmChunk> decodeStream(String inputPath,
+      {int? sampleRate, int? channels, AudioPcmFormat format = AudioPcmFormat.s16, required int chunkSize, Duration? start, Duration? end, required String jobId}) {
+    throw UnimplementedError('decodeStream() has not been implemented.');
+  }
+
+  Future<bool> cancel(String jobId) {
+    throw UnimplementedError('cancel() has not been implemented.');
+  }
+
+  Stream<AudioJobProgress> get progressEvents {
+    throw UnimplementedError('progressEvents has not been implemented.');
+  }
+
+  Future<void> configure({int? maxQueuedBuffers, int? maxQueuedBytes, int? waveformSampleRate, bool? waveformCache, int? decodeSegments, int? maxConcurrentJobs, int? progressIntervalMs, String? scratchDirectory, int? scratchMemoryBytes, int? infoTimeoutMs, int? streamPauseTimeoutMs, int? infoCacheEntries, String? infoCacheFile, bool? wavPreallocate, bool? wavDirectIo}) {
+    throw UnimplementedError('configure() has not been implemented.');
+  }
+
+  Future<Map<String, dynamic>> getDecoderStats() {
+    throw UnimplementedError('getDecoderStats() has not been implemented.');
+  }
 }
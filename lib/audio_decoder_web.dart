@@ -5,9 +5,13 @@ import 'dart:typed_data';
 import 'package:flutter_web_plugins/flutter_web_plugins.dart';
 import 'package:web/web.dart' as web;
 
+import 'audio_batch.dart';
 import 'audio_conversion_exception.dart';
 import 'audio_decoder_platform_interface.dart';
 import 'audio_info.dart';
+import 'audio_job_progress.dart';
+import 'audio_pcm_stream.dart';
+import 'wav_sample_format.dart';
 
 /// Standard RIFF/WAV header size in bytes (no extra chunks).
 const int _wavHeaderSize = 44;
@@ -28,13 +32,13 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
   // --- File-based methods (not supported on web) ---
 
   @override
-  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth}) {
+  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, String? jobId}) {
     throw UnsupportedError(
         'File-based operations are not supported on web. Use convertToWavBytes instead.');
   }
 
   @override
-  Future<String> convertToM4a(String inputPath, String outputPath) {
+  Future<String> convertToM4a(String inputPath, String outputPath, {String? jobId}) {
     throw UnsupportedError(
         'File-based operations are not supported on web. Use convertToM4aBytes instead.');
   }
@@ -45,19 +49,51 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
         'File-based operations are not supported on web. Use getAudioInfoBytes instead.');
   }
 
+  @override
+  Future<List<AudioInfoResult>> getAudioInfoBatch(List<String> paths, {String? jobId}) {
+    throw UnsupportedError(
+        'File-based operations are not supported on web. Use getAudioInfoBytes instead.');
+  }
+
   @override
   Future<String> trimAudio(
-      String inputPath, String outputPath, Duration start, Duration end) {
+      String inputPath, String outputPath, Duration start, Duration end, {String? jobId}) {
     throw UnsupportedError(
         'File-based operations are not supported on web. Use trimAudioBytes instead.');
   }
 
   @override
-  Future<List<double>> getWaveform(String path, int numberOfSamples) {
+  Future<List<double>> getWaveform(String path, int numberOfSamples, {Duration? start, Duration? end, String? jobId}) {
     throw UnsupportedError(
         'File-based operations are not supported on web. Use getWaveformBytes instead.');
   }
 
+  @override
+  Future<AudioBatchResult> convertBatch(List<AudioBatchItem> items,
+      {required String jobId, void Function(AudioBatchItemResult result)? onItemDone}) {
+    throw UnsupportedError(
+        'File-based operations are not supported on web. Use convertToWavBytes instead.');
+  }
+
+  @override
+  Stream<AudioPcmChunk> decodeStream(String inputPath,
+      {int? sampleRate, int? channels, AudioPcmFormat format = AudioPcmFormat.s16, required int chunkSize, Duration? start, Duration? end, required String jobId}) {
+    throw UnsupportedError(
+        'File-based operations are not supported on web. Use convertToWavBytes instead.');
+  }
+
+  @override
+  Future<bool> cancel(String jobId) async {
+    // Web Audio decoding cannot be interrupted; calls run to completion.
+    return false;
+  }
+
+  @override
+  Stream<AudioJobProgress> get progressEvents {
+    // decodeAudioData() does not report progress.
+    return const Stream.empty();
+  }
+
   // --- Bytes-based methods (Web Audio API) ---
 
   Future<web.AudioBuffer> _decodeAudioData(Uint8List inputData) async {
@@ -189,7 +225,7 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
 
   @override
   Future<Uint8List> convertToWavBytes(
-      Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, bool? includeHeader}) async {
+      Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, bool? includeHeader, String? jobId}) async {
     try {
       var buffer = await _decodeAudioData(inputData);
       if (sampleRate != null && sampleRate != buffer.sampleRate.toInt()) {
@@ -220,7 +256,7 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
 
   @override
   Future<Uint8List> convertToM4aBytes(
-      Uint8List inputData, String formatHint) async {
+      Uint8List inputData, String formatHint, {String? jobId}) async {
     throw AudioConversionException(
       'M4A encoding is not supported on web',
       details:
@@ -255,7 +291,7 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
   @override
   Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint,
       Duration start, Duration end,
-      {String outputFormat = 'wav'}) async {
+      {String outputFormat = 'wav', String? jobId}) async {
     if (outputFormat == 'm4a') {
       throw AudioConversionException(
         'M4A encoding is not supported on web',
@@ -279,7 +315,7 @@ final class AudioDecoderWeb extends AudioDecoderPlatform {
 
   @override
   Future<List<double>> getWaveformBytes(
-      Uint8List inputData, String formatHint, int numberOfSamples) async {
+      Uint8List inputData, String formatHint, int numberOfSamples, {String? jobId}) async {
     try {
       final buffer = await _decodeAudioData(inputData);
       final channelData = buffer.getChannelData(0).toDart;
@@ -31,3 +31,24 @@ final class AudioInfo {
       'AudioInfo(duration: $duration, sampleRate: $sampleRate, '
       'channels: $channels, bitRate: $bitRate, format: $format)';
 }
+
+/// Outcome of probing one path in [AudioDecoder.getAudioInfoBatch].
+final class AudioInfoResult {
+  /// The path as passed to [AudioDecoder.getAudioInfoBatch].
+  final String path;
+
+  /// The file's metadata, or `null` if it could not be read.
+  final AudioInfo? info;
+
+  /// Why the file could not be read, or `null` if it was.
+  final String? error;
+
+  /// Creates an [AudioInfoResult].
+  const AudioInfoResult({required this.path, this.info, this.error});
+
+  /// Whether [info] is available.
+  bool get succeeded => info != null;
+
+  @override
+  String toString() => succeeded ? 'AudioInfoResult($path: $info)' : 'AudioInfoResult($path failed: $error)';
+}
@@ -0,0 +1,49 @@
+/// Progress of a running call that was started with a `jobId`.
+///
+/// Emitted by [AudioDecoder.progressEvents].
+final class AudioJobProgress {
+  /// The `jobId` the call was started with.
+  final String jobId;
+
+  /// Media time processed so far, relative to the start of the processed
+  /// range.
+  final Duration position;
+
+  /// Length of the processed range, or `null` if it is not known yet.
+  final Duration? duration;
+
+  /// Bytes of output produced so far.
+  final int bytesWritten;
+
+  /// Media time processed per second of wall time (e.g. 40.0 means the
+  /// call runs 40 times faster than playback).
+  final double realTimeFactor;
+
+  /// Whether this is the last event for [jobId]. It is sent just before the
+  /// call's future completes, whether the call succeeded or not.
+  final bool done;
+
+  /// Creates an [AudioJobProgress] with the given values.
+  const AudioJobProgress({
+    required this.jobId,
+    required this.position,
+    this.duration,
+    required this.bytesWritten,
+    required this.realTimeFactor,
+    required this.done,
+  });
+
+  /// Fraction of the call completed, from 0.0 to 1.0, or `null` if the
+  /// duration is not known.
+  double? get fraction {
+    final total = duration;
+    if (total == null || total.inMicroseconds <= 0) return null;
+    return (position.inMicroseconds / total.inMicroseconds).clamp(0.0, 1.0);
+  }
+
+  @override
+  String toString() =>
+      'AudioJobProgress(jobId: $jobId, position: $position, '
+      'duration: $duration, bytesWritten: $bytesWritten, '
+      'realTimeFactor: $realTimeFactor, done: $done)';
+}
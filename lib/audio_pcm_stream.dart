@@ -0,0 +1,52 @@
+import 'dart:typed_data';
+
+/// Sample format of the PCM delivered by [AudioDecoder.decodeStream].
+enum AudioPcmFormat {
+  /// 16-bit signed little-endian integers.
+  s16,
+
+  /// 32-bit little-endian IEEE floats, nominally in -1.0 to 1.0.
+  f32,
+}
+
+/// A block of decoded, interleaved PCM from [AudioDecoder.decodeStream].
+final class AudioPcmChunk {
+  /// The samples, little-endian and interleaved by channel. Every chunk but
+  /// the last holds the requested chunk size, rounded down to whole frames.
+  final Uint8List data;
+
+  /// Frames per second.
+  final int sampleRate;
+
+  /// Samples per frame.
+  final int channels;
+
+  /// Sample format of [data].
+  final AudioPcmFormat format;
+
+  /// Index of the first frame of [data] in the decoded stream.
+  final int frameOffset;
+
+  /// Creates an [AudioPcmChunk].
+  const AudioPcmChunk({
+    required this.data,
+    required this.sampleRate,
+    required this.channels,
+    required this.format,
+    required this.frameOffset,
+  });
+
+  /// Bytes per sample of [format].
+  int get bytesPerSample => format == AudioPcmFormat.f32 ? 4 : 2;
+
+  /// Number of frames in [data].
+  int get frameCount => data.lengthInBytes ~/ (bytesPerSample * channels);
+
+  /// Time of the first frame, relative to the start of the decoded range.
+  Duration get position => Duration(microseconds: frameOffset * Duration.microsecondsPerSecond ~/ sampleRate);
+
+  @override
+  String toString() =>
+      'AudioPcmChunk(${data.lengthInBytes} bytes, $sampleRate Hz, '
+      '$channels ch, ${format.name}, frameOffset: $frameOffset)';
+}
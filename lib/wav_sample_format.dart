@@ -0,0 +1,17 @@
+/// Sample encoding of the WAV output of [AudioDecoder.convertToWav],
+/// [AudioDecoder.convertToWavBytes] and [AudioBatchItem.wav].
+enum WavSampleFormat {
+  /// Signed integers of the requested bit depth, 16 bits by default.
+  integer,
+
+  /// 32-bit IEEE floats, in a WAVE_FORMAT_EXTENSIBLE file. Decoders that
+  /// work in float (Vorbis, Opus, AAC, MP3) deliver these without being
+  /// quantized.
+  float,
+
+  /// Whatever format the decoder produces, as long as WAV can hold it
+  /// (8-bit unsigned, 16-, 24- or 32-bit integer, 32- or 64-bit float), so
+  /// the samples are written without any conversion. Read the format from
+  /// the header of the result.
+  native,
+}
@@ -2,28 +2,205 @@
 
 #include <flutter_linux/flutter_linux.h>
 
+#include "decode_pipeline_pool.h"
+#include "discoverer_pool.h"
+#include "header_probe.h"
+#include "info_cache.h"
+#include "job_executor.h"
+#include "job_progress.h"
+#include "job_registry.h"
+#include "memory_source.h"
+#include "pcm_chunk.h"
+#include "pcm_stream.h"
+#include "scratch_file.h"
+#include "wav_writer.h"
+#include "waveform_accumulator.h"
+#include "waveform_kernels.h"
+#include "waveform_pyramid.h"
+
+#include <gio/gio.h>
 #include <gst/gst.h>
 #include <gst/audio/audio.h>
 #include <gst/pbutils/pbutils.h>
 #include <gst/app/gstappsink.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <thread>
 
-/// Standard RIFF/WAV header size in bytes (no extra chunks).
-static constexpr size_t kWavHeaderSize = 44;
+using audio_decoder::DecodePipelinePool;
+using audio_decoder::DecodeQueueLimits;
+using audio_decoder::AudioInfoCache;
+using audio_decoder::AudioInfoRecord;
+using audio_decoder::DiscovererPool;
+using audio_decoder::HeaderProbe;
+using audio_decoder::CancelToken;
+using audio_decoder::JobCancelledError;
+using audio_decoder::JobExecutor;
+using audio_decoder::JobProgress;
+using audio_decoder::JobRegistry;
+using audio_decoder::MemorySource;
+using audio_decoder::PcmChunk;
+using audio_decoder::PcmStream;
+using audio_decoder::ScratchFile;
+using audio_decoder::WavFileWriter;
+using audio_decoder::WavMemoryWriter;
+using audio_decoder::SampleFormat;
+using audio_decoder::PyramidKey;
+using audio_decoder::WaveformAccumulator;
+using audio_decoder::WaveformPyramid;
+
+/// WAV passthrough copies advance this many bytes between cancellation
+/// checks and progress reports.
+static constexpr uint64_t kPassthroughSliceBytes = 16 * 1024 * 1024;
+
+/// Default bound on decoded data queued ahead of the consumer.  Enough to
+/// keep the decoder busy across short consumer stalls while keeping peak
+/// memory per job fixed regardless of input length.
+static constexpr guint kDefaultMaxQueuedBuffers = 32;
+static constexpr guint64 kDefaultMaxQueuedBytes = 4 * 1024 * 1024;
+
+/// Default ceiling on the sample rate of waveform (analysis) decodes.  Far
+/// above what a visual envelope needs, far below typical source rates.
+static constexpr int kDefaultAnalysisSampleRate = 8000;
+
+/// Segmented decoding (opt-in): at most this many concurrent segments when
+/// configured to use one per core, and none shorter than kMinSegmentMs, so
+/// short files keep a single pipeline.
+static constexpr int kMaxDefaultDecodeSegments = 8;
+static constexpr int64_t kMinSegmentMs = 30 * 1000;
+/// Extra time decoded past a segment's end so the decoder's output always
+/// reaches the boundary; the surplus is cut off at the exact frame.
+static constexpr GstClockTime kSegmentOverrunNs = 100 * GST_MSECOND;
+/// Inputs smaller than this are never split.
+static constexpr off_t kMinSegmentedInputBytes = 1024 * 1024;
+/// Bytes a segment batches before a positioned write; it also writes once
+/// it holds WavFileWriter::kMaxHeldChunks decoder buffers.
+static constexpr size_t kSegmentWriteBytes = 1024 * 1024;
+
+/// Default minimum time between two progress events of the same job.
+static constexpr int kDefaultProgressIntervalMs = 200;
+/// How often an encode with progress reporting polls its position.
+static constexpr GstClockTime kProgressPollNs = 50 * GST_MSECOND;
+
+/// convertBatch asks the kernel to read this many inputs ahead of the ones
+/// being decoded, and only their first bytes: enough for typefinding and
+/// the decoder's first reads, which are what stall a freshly started item.
+static constexpr size_t kBatchReadAheadItems = 2;
+static constexpr off_t kBatchReadAheadBytes = 4 * 1024 * 1024;
+
+/// Default time allowed to probe one file for getAudioInfo.
+static constexpr int kDefaultInfoTimeoutMs = 5000;
+
+/// getAudioInfo results kept in memory by default.
+static constexpr size_t kDefaultInfoCacheEntries = 4096;
+
+/// decodeStream chunk size when the call does not pass one.
+static constexpr size_t kDefaultPcmChunkBytes = 64 * 1024;
+/// decodeStream calls running at once; each has a thread of its own.
+static constexpr size_t kMaxPcmStreams = 16;
+/// Default time a decodeStream waits for its listener to ask for more
+/// chunks before taking it for abandoned and failing.
+static constexpr int kDefaultStreamPauseTimeoutMs = 5 * 60 * 1000;
 
-/// Maximum PCM data size that fits in a standard WAV file (~4 GB).
-static constexpr int64_t kMaxWavDataSize = 0xFFFFFFFFL - 36;
+// ---------------------------------------------------------------------------
+// Configuration and statistics
+// ---------------------------------------------------------------------------
+
+/// Plugin-wide settings, updated from Dart through the `configure` call.
+struct DecoderConfig {
+    DecodeQueueLimits queueLimits{kDefaultMaxQueuedBuffers,
+                                  kDefaultMaxQueuedBytes};
+    int analysisSampleRate = kDefaultAnalysisSampleRate;
+    bool waveformCache = true;
+    /// Parallel segments for long sample-accurate inputs; 1 (the default)
+    /// decodes linearly and 0 picks one per core.
+    int decodeSegments = 1;
+    /// Executor workers running method-call jobs; 0 picks one per core.
+    int maxConcurrentJobs = 0;
+    int progressIntervalMs = kDefaultProgressIntervalMs;
+    /// Time allowed to probe one file for getAudioInfo.
+    int infoTimeoutMs = kDefaultInfoTimeoutMs;
+    /// Time a decodeStream waits for credit; 0 waits indefinitely.
+    int streamPauseTimeoutMs = kDefaultStreamPauseTimeoutMs;
+    /// Unavoidable temporary files (see ScratchFile).
+    audio_decoder::ScratchConfig scratch;
+    /// Preallocation and O_DIRECT for WAV file output.
+    audio_decoder::WavWriterConfig wavWriter;
+};
+
+static std::mutex gConfigMutex;
+static DecoderConfig gConfig;
+
+static DecoderConfig CurrentConfig() {
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    return gConfig;
+}
+
+/// High-water marks of the decode queue across all jobs.
+struct DecodeQueueStats {
+    uint64_t jobs = 0;
+    uint64_t overruns = 0;
+    guint peakBuffers = 0;
+    guint64 peakBytes = 0;
+};
+
+static std::mutex gQueueStatsMutex;
+static DecodeQueueStats gQueueStats;
+
+/// Waveform pyramid sidecar lookups.
+struct WaveformCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t writeFailures = 0;
+};
+
+static std::mutex gWaveformCacheMutex;
+static WaveformCacheStats gWaveformCacheStats;
+
+/// Decodes that ran as parallel segments, and how many segments in total.
+struct SegmentStats {
+    uint64_t jobs = 0;
+    uint64_t segments = 0;
+};
+
+static std::mutex gSegmentStatsMutex;
+static SegmentStats gSegmentStats;
+
+/// WAV outputs copied from a matching PCM WAV input instead of decoded.
+struct PassthroughStats {
+    uint64_t jobs = 0;
+    uint64_t bytes = 0;
+};
+
+static std::mutex gPassthroughStatsMutex;
+static PassthroughStats gPassthroughStats;
+
+static void RecordQueueUsage(guint peakBuffers, guint64 peakBytes,
+                             uint64_t overruns) {
+    std::lock_guard<std::mutex> lock(gQueueStatsMutex);
+    gQueueStats.jobs++;
+    gQueueStats.overruns += overruns;
+    gQueueStats.peakBuffers = std::max(gQueueStats.peakBuffers, peakBuffers);
+    gQueueStats.peakBytes = std::max(gQueueStats.peakBytes, peakBytes);
+}
 
 // ---------------------------------------------------------------------------
 // Helpers
@@ -33,72 +210,192 @@ struct PcmInfo {
     uint32_t sampleRate;
     uint32_t channels;
     uint32_t bitsPerSample;
+    GstAudioFormat format;
 };
 
-struct PcmResult {
-    std::vector<uint8_t> data;
-    uint32_t sampleRate;
-    uint32_t channels;
-    uint32_t bitsPerSample;
+/// Sample encoding of WAV output.
+enum class WavSampleFormat {
+    /// Signed integers of the requested bit depth, 16 bits by default.
+    kInteger,
+    /// 32-bit IEEE float.
+    kFloat,
+    /// The decoder's own format, as long as a WAV file can hold it.
+    kNative,
 };
 
-static PcmInfo DecodeToPcmStream(
-        const std::string& inputPath,
-        const std::function<void(const uint8_t*, size_t)>& onChunk,
-        int64_t startMs = -1, int64_t endMs = -1,
-        int targetSampleRate = -1, int targetChannels = -1,
-        int targetBitDepth = -1) {
-    PcmInfo info{};
+static bool IsFloatFormat(GstAudioFormat format) {
+    return format == GST_AUDIO_FORMAT_F32LE || format == GST_AUDIO_FORMAT_F64LE;
+}
 
-    std::string uri;
-    if (inputPath.rfind("file://", 0) == 0) {
-        uri = inputPath;
-    } else {
-        gchar* fileUri = g_filename_to_uri(inputPath.c_str(), nullptr, nullptr);
-        if (!fileUri) {
-            throw std::runtime_error("Cannot convert path to URI: " + inputPath);
-        }
-        uri = fileUri;
-        g_free(fileUri);
+/// Reads the optional `sampleFormat` argument in [args]: "float", "native",
+/// or integer output when absent.
+static WavSampleFormat SampleFormatArg(FlValue* args) {
+    FlValue* value = fl_value_lookup_string(args, "sampleFormat");
+    if (!value || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+        return WavSampleFormat::kInteger;
     }
+    const gchar* name = fl_value_get_string(value);
+    if (strcmp(name, "float") == 0) return WavSampleFormat::kFloat;
+    if (strcmp(name, "native") == 0) return WavSampleFormat::kNative;
+    return WavSampleFormat::kInteger;
+}
 
-    // Determine output format based on bit depth
-    std::string gstFormat = "S16LE";
-    if (targetBitDepth == 8) gstFormat = "S8";
-    else if (targetBitDepth == 24) gstFormat = "S24LE";
-    else if (targetBitDepth == 32) gstFormat = "S32LE";
+/// What to decode and the PCM format to deliver.  Unset (-1) fields keep the
+/// source's value.
+struct DecodeOptions {
+    int64_t startMs = -1;
+    int64_t endMs = -1;
+    int sampleRate = -1;
+    int channels = -1;
+    int bitDepth = -1;
+    /// Upper bound on the output rate; sources at or below it are not
+    /// resampled.  Ignored when [sampleRate] is set.
+    int maxSampleRate = -1;
+    /// Accept any sample format the waveform kernels can reduce, letting
+    /// audioconvert keep the source's format instead of converting to S16.
+    /// Ignored when [bitDepth] is set.
+    bool kernelFormats = false;
+    /// Deliver 32-bit float samples.  Overrides [bitDepth].
+    bool floatSamples = false;
+    /// Accept every interleaved format a WAV file can hold, so audioconvert
+    /// passes the decoder's samples through unconverted.  Ignored when
+    /// [bitDepth] is set.
+    bool nativeFormat = false;
+    /// Stops the decode early (with JobCancelledError) when cancelled.
+    CancelToken* cancel = nullptr;
+    /// Receives decoded media time and bytes as they are delivered.
+    JobProgress* progress = nullptr;
+};
 
-    // Build caps string with optional rate/channels
-    std::string capsStr = "audio/x-raw,format=" + gstFormat;
-    if (targetSampleRate > 0) {
-        capsStr += ",rate=" + std::to_string(targetSampleRate);
+/// Decode profile for waveform and other analysis jobs: mono, decimated to
+/// at most the configured analysis rate inside the pipeline, so the
+/// consumer sees a fraction of the samples of a full-rate decode.
+static DecodeOptions AnalysisDecodeOptions() {
+    DecodeOptions options;
+    options.channels = 1;
+    options.maxSampleRate = CurrentConfig().analysisSampleRate;
+    options.kernelFormats = true;
+    return options;
+}
+
+/// Returns [inputPath] as a URI; `file://` and MemorySource URIs are passed
+/// through.
+static std::string PathToUri(const std::string& inputPath) {
+    if (inputPath.rfind("file://", 0) == 0 ||
+        MemorySource::IsMemoryUri(inputPath)) {
+        return inputPath;
     }
-    if (targetChannels > 0) {
-        capsStr += ",channels=" + std::to_string(targetChannels);
+    gchar* fileUri = g_filename_to_uri(inputPath.c_str(), nullptr, nullptr);
+    if (!fileUri) {
+        throw std::runtime_error("Cannot convert path to URI: " + inputPath);
     }
+    std::string uri = fileUri;
+    g_free(fileUri);
+    return uri;
+}
 
-    // Build pipeline: uridecodebin ! audioconvert ! audioresample ! appsink
-    std::string pipeDesc =
-        "uridecodebin uri=\"" + uri + "\" ! audioconvert ! audioresample ! "
-        + capsStr + " ! appsink name=sink sync=false";
-
-    GError* error = nullptr;
-    GstElement* pipeline = gst_parse_launch(pipeDesc.c_str(), &error);
-    if (!pipeline || error) {
-        std::string msg = error ? error->message : "Unknown error";
-        if (error) g_error_free(error);
-        if (pipeline) gst_object_unref(pipeline);
-        throw std::runtime_error("Failed to create pipeline: " + msg);
+/// Estimates the PCM bytes a decode of [startMs, endMs) will produce from the
+/// container duration, which is known once the first sample has prerolled.
+/// Returns -1 when the duration cannot be queried.
+static int64_t EstimatePcmBytes(GstElement* pipeline,
+                                const GstAudioInfo& audioInfo,
+                                int64_t startMs, int64_t endMs) {
+    gint64 durationNs = -1;
+    if (!gst_element_query_duration(pipeline, GST_FORMAT_TIME, &durationNs) ||
+        durationNs <= 0) {
+        return -1;
+    }
+    gint64 from = startMs > 0 ? startMs * static_cast<gint64>(GST_MSECOND) : 0;
+    gint64 to = durationNs;
+    if (endMs >= 0) {
+        to = std::min<gint64>(to, endMs * static_cast<gint64>(GST_MSECOND));
     }
+    if (to <= from) return -1;
+    guint64 frames = gst_util_uint64_scale(static_cast<guint64>(to - from),
+                                           audioInfo.rate, GST_SECOND);
+    return static_cast<int64_t>(frames * audioInfo.bpf);
+}
 
-    GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
-    if (!sink) {
-        gst_object_unref(pipeline);
-        throw std::runtime_error("Failed to get appsink element");
+static void ThrowIfCancelled(const CancelToken* cancel) {
+    if (cancel) cancel->ThrowIfCancelled();
+}
+
+/// While the returned hook is alive, cancelling [cancel] sends EOS into
+/// [pipeline], so a pull blocked on its appsink (or a wait for the bus EOS)
+/// returns promptly.  The pipeline must be at least PAUSED, or the event
+/// never reaches its sources.
+static CancelToken::Hook StopOnCancel(CancelToken* cancel,
+                                      GstElement* pipeline) {
+    if (!cancel) return CancelToken::Hook();
+    // Held so the hook stays safe if the caller releases the pipeline first.
+    std::shared_ptr<GstElement> ref(
+        GST_ELEMENT(gst_object_ref(pipeline)),
+        [](GstElement* element) { gst_object_unref(element); });
+    return cancel->OnCancel([ref]() {
+        gst_element_send_event(ref.get(), gst_event_new_eos());
+    });
+}
+
+/// Returns the appsink caps for [options]; also the pipeline pool key.
+static std::string OutputCaps(const DecodeOptions& options) {
+    // Determine output format based on bit depth
+    std::string gstFormat = "S16LE";
+    if (options.bitDepth == 8) gstFormat = "S8";
+    else if (options.bitDepth == 24) gstFormat = "S24LE";
+    else if (options.bitDepth == 32) gstFormat = "S32LE";
+    else if (options.bitDepth <= 0 && options.kernelFormats)
+        gstFormat = "(string){F32LE,S32LE,S24LE,S16LE}";
+    else if (options.bitDepth <= 0 && options.nativeFormat)
+        gstFormat = "(string){F32LE,F64LE,S32LE,S24LE,S16LE,U8},layout=interleaved";
+    if (options.floatSamples) gstFormat = "F32LE";
+
+    // Build caps string with optional rate/channels.  A rate range lets
+    // audioresample pass lower-rate sources through untouched.
+    std::string capsStr = "audio/x-raw,format=" + gstFormat;
+    if (options.sampleRate > 0) {
+        capsStr += ",rate=" + std::to_string(options.sampleRate);
+    } else if (options.maxSampleRate > 0) {
+        capsStr += ",rate=(int)[1," + std::to_string(options.maxSampleRate) + "]";
     }
-    g_object_set(sink, "emit-signals", FALSE, "max-buffers", 0, nullptr);
+    if (options.channels > 0) {
+        capsStr += ",channels=" + std::to_string(options.channels);
+    }
+    return capsStr;
+}
 
-    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+/// Decodes [inputPath] and calls [onChunk] for every decoded buffer.
+/// [onFormat], if set, is called once before the first chunk with the
+/// negotiated format and the expected PCM size in bytes (-1 if unknown).
+static PcmInfo DecodeToPcmStream(
+        const std::string& inputPath,
+        const DecodeOptions& options,
+        const std::function<void(const PcmChunk&)>& onChunk,
+        const std::function<void(const PcmInfo&, int64_t)>& onFormat = nullptr) {
+    PcmInfo info{};
+    ThrowIfCancelled(options.cancel);
+    std::string uri = PathToUri(inputPath);
+    const int64_t startMs = options.startMs;
+    const int64_t endMs = options.endMs;
+
+    std::string capsStr = OutputCaps(options);
+
+    // Borrow a pre-built uridecodebin ! audioconvert ! audioresample !
+    // capsfilter ! appsink pipeline for these caps and point it at the input.
+    auto lease = DecodePipelinePool::Instance().Acquire(capsStr);
+    GstElement* pipeline = lease->pipeline;
+    GstElement* sink = lease->sink;
+    g_object_set(lease->source, "uri", uri.c_str(), nullptr);
+    audio_decoder::SetQueueLimits(lease.operator->(),
+                                  CurrentConfig().queueLimits);
+    const uint64_t overrunsBefore = lease->overruns.load();
+    guint peakBuffers = 0;
+    guint64 peakBytes = 0;
+
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) ==
+            GST_STATE_CHANGE_FAILURE) {
+        lease.Discard();
+    }
+    CancelToken::Hook stopHook = StopOnCancel(options.cancel, pipeline);
 
     // Seek to start position if specified
     if (startMs >= 0) {
@@ -107,19 +404,20 @@ static PcmInfo DecodeToPcmStream(
             startMs * GST_MSECOND);
     }
 
-    // Pull samples from appsink
-    auto cleanup = [&]() {
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(sink);
-        gst_object_unref(pipeline);
-    };
-
     bool gotCaps = false;
+    uint64_t bytesPerSecond = 0;
     try {
         while (true) {
+            ThrowIfCancelled(options.cancel);
             GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
             if (!sample) break;
 
+            guint levelBuffers = 0, levelBytes = 0;
+            g_object_get(lease->queue, "current-level-buffers", &levelBuffers,
+                         "current-level-bytes", &levelBytes, nullptr);
+            peakBuffers = std::max(peakBuffers, levelBuffers);
+            peakBytes = std::max<guint64>(peakBytes, levelBytes);
+
             if (!gotCaps) {
                 GstCaps* caps = gst_sample_get_caps(sample);
                 if (caps) {
@@ -128,7 +426,17 @@ static PcmInfo DecodeToPcmStream(
                         info.sampleRate = audioInfo.rate;
                         info.channels = audioInfo.channels;
                         info.bitsPerSample = audioInfo.finfo->width;
+                        info.format = GST_AUDIO_INFO_FORMAT(&audioInfo);
                         gotCaps = true;
+                        bytesPerSecond =
+                            static_cast<uint64_t>(audioInfo.rate) * audioInfo.bpf;
+                        int64_t expectedBytes = EstimatePcmBytes(
+                            pipeline, audioInfo, startMs, endMs);
+                        if (options.progress && expectedBytes > 0) {
+                            options.progress->SetDuration(gst_util_uint64_scale(
+                                expectedBytes, GST_SECOND, bytesPerSecond));
+                        }
+                        if (onFormat) onFormat(info, expectedBytes);
                     }
                 }
             }
@@ -145,200 +453,788 @@ static PcmInfo DecodeToPcmStream(
                     }
                 }
 
-                GstMapInfo map;
-                if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+                // The chunk holds its own reference to the buffer, so the
+                // consumer may keep it after the sample is released.
+                PcmChunk chunk = PcmChunk::Wrap(buffer);
+                if (!chunk.empty()) {
                     try {
-                        onChunk(map.data, map.size);
+                        onChunk(chunk);
                     } catch (...) {
-                        gst_buffer_unmap(buffer, &map);
                         gst_sample_unref(sample);
                         throw;
                     }
-                    gst_buffer_unmap(buffer, &map);
+                    if (options.progress && bytesPerSecond > 0) {
+                        options.progress->Advance(
+                            gst_util_uint64_scale(chunk.size(), GST_SECOND,
+                                                  bytesPerSecond),
+                            chunk.size());
+                    }
                 }
             }
             gst_sample_unref(sample);
         }
+        // A cancel ends the pull with an EOS of our own making.
+        ThrowIfCancelled(options.cancel);
     } catch (...) {
-        cleanup();
+        RecordQueueUsage(peakBuffers, peakBytes,
+                         lease->overruns.load() - overrunsBefore);
+        lease.Discard();
         throw;
     }
 
-    cleanup();
+    RecordQueueUsage(peakBuffers, peakBytes,
+                     lease->overruns.load() - overrunsBefore);
     return info;
 }
 
-static PcmResult DecodeToPcm(const std::string& inputPath,
-                              int64_t startMs = -1, int64_t endMs = -1,
-                              int targetSampleRate = -1, int targetChannels = -1,
-                              int targetBitDepth = -1) {
-    PcmResult result{};
-    auto info = DecodeToPcmStream(inputPath,
-        [&](const uint8_t* data, size_t size) {
-            result.data.insert(result.data.end(), data, data + size);
-        },
-        startMs, endMs, targetSampleRate, targetChannels, targetBitDepth);
-    result.sampleRate = info.sampleRate;
-    result.channels = info.channels;
-    result.bitsPerSample = info.bitsPerSample;
-    return result;
-}
+// ---------------------------------------------------------------------------
+// Segmented decoding
+// ---------------------------------------------------------------------------
+
+/// Layout of a segmented decode: segment i covers output frames
+/// [bounds[i], bounds[i + 1]); the last bound is UINT64_MAX (to EOS).
+struct SegmentPlan {
+    PcmInfo info;
+    uint32_t bytesPerFrame;
+    /// Frames the container duration promises; the last segment runs to
+    /// the end of the stream whatever it holds.
+    uint64_t totalFrames;
+    std::vector<uint64_t> bounds;
+
+    size_t segments() const { return bounds.size() - 1; }
+};
 
-static void WriteWavHeader(std::ostream& file, uint32_t dataSize,
-                           uint32_t sampleRate, uint16_t channels,
-                           uint16_t bitsPerSample) {
-    uint32_t byteRate = sampleRate * channels * bitsPerSample / 8;
-    uint16_t blockAlign = channels * bitsPerSample / 8;
-    uint32_t chunkSize = 36 + dataSize;
-    uint32_t subChunk1Size = 16;
-    uint16_t audioFormat = 1;
-
-    file.write("RIFF", 4);
-    file.write(reinterpret_cast<char*>(&chunkSize), 4);
-    file.write("WAVE", 4);
-    file.write("fmt ", 4);
-    file.write(reinterpret_cast<char*>(&subChunk1Size), 4);
-    file.write(reinterpret_cast<char*>(&audioFormat), 2);
-    file.write(reinterpret_cast<char*>(&channels), 2);
-    file.write(reinterpret_cast<char*>(&sampleRate), 4);
-    file.write(reinterpret_cast<char*>(&byteRate), 4);
-    file.write(reinterpret_cast<char*>(&blockAlign), 2);
-    file.write(reinterpret_cast<char*>(&bitsPerSample), 2);
-    file.write("data", 4);
-    file.write(reinterpret_cast<char*>(&dataSize), 4);
+/// Callbacks of a segmented decode, invoked on the thread running the segment.
+/// Each segment's chunks arrive in order and cover its frames exactly.
+struct SegmentCallbacks {
+    std::function<void(const SegmentPlan&)> onPlan;
+    std::function<void(size_t segment, const PcmChunk& chunk)> onChunk;
+    std::function<void(size_t segment)> onSegmentEnd;
+};
+
+static int DecodeSegmentCount() {
+    int configured = CurrentConfig().decodeSegments;
+    if (configured > 0) return configured;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(cores, kMaxDefaultDecodeSegments));
 }
 
-static std::string WriteTempFile(const std::vector<uint8_t>& data,
-                                 const std::string& extension) {
-    std::string templ = "/tmp/audio_decoder_XXXXXX." + extension;
-    std::vector<char> buf(templ.begin(), templ.end());
-    buf.push_back('\0');
+/// Whether seeks in the local file at [path] land on exact samples, so
+/// segments decoded from seek points join up with what a linear decode
+/// produces: PCM WAV, AIFF and FLAC.  Compressed formats are not split, as
+/// codec priming, VBR seek tables and resampler state make their joins
+/// drift.
+static bool IsSampleAccurateInput(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    uint8_t head[12];
+    bool accurate = false;
+    if (pread(fd, head, sizeof(head), 0) == static_cast<ssize_t>(sizeof(head))) {
+        if (std::memcmp(head, "fLaC", 4) == 0) {
+            accurate = true;
+        } else if (std::memcmp(head, "FORM", 4) == 0) {
+            accurate = std::memcmp(head + 8, "AIFF", 4) == 0 ||
+                       std::memcmp(head + 8, "AIFC", 4) == 0;
+        } else {
+            audio_decoder::WavLayout layout;
+            accurate = HeaderProbe::ReadPcmWavLayout(fd, &layout);
+        }
+    }
+    close(fd);
+    return accurate;
+}
 
-    int fd = mkstemps(buf.data(), static_cast<int>(extension.size() + 1));
-    if (fd < 0) {
-        throw std::runtime_error("Failed to create temp file");
+/// Delivers [frames] frames of silence (used where the decoder left a gap).
+static void EmitSilence(size_t segment, uint64_t frames, uint32_t bytesPerFrame,
+                        const SegmentCallbacks& callbacks) {
+    static const std::vector<uint8_t> zeros(64 * 1024);
+    uint64_t bytes = frames * bytesPerFrame;
+    while (bytes > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(bytes, zeros.size()));
+        n -= n % bytesPerFrame;
+        if (n == 0) n = bytesPerFrame;
+        callbacks.onChunk(segment, PcmChunk::Adopt(nullptr, zeros.data(), n));
+        bytes -= n;
     }
+}
 
-    if (!data.empty()) {
-        ssize_t written = write(fd, data.data(), data.size());
-        (void)written;
+/// Runs segment [index] of [plan] on [lease], which must be prerolled:
+/// an accurate flushing seek to the segment, then the pull loop, placing
+/// every buffer by its timestamp and trimming it to the segment's frames.
+static void DecodeSegment(DecodePipelinePool::Lease& lease,
+                          const SegmentPlan& plan, size_t index,
+                          const SegmentCallbacks& callbacks,
+                          const std::atomic<bool>& abort,
+                          CancelToken* cancel) {
+    GstElement* pipeline = lease->pipeline;
+    const uint64_t rate = plan.info.sampleRate;
+    const uint32_t bpf = plan.bytesPerFrame;
+    const uint64_t first = plan.bounds[index];
+    const uint64_t end = plan.bounds[index + 1];
+    const bool last = index + 1 == plan.segments();
+
+    gint64 startNs = static_cast<gint64>(
+        gst_util_uint64_scale(first, GST_SECOND, rate));
+    gint64 stopNs = last ? -1 : static_cast<gint64>(
+        gst_util_uint64_scale(end, GST_SECOND, rate) + kSegmentOverrunNs);
+    if (!gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME,
+            static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+            GST_SEEK_TYPE_SET, startNs,
+            last ? GST_SEEK_TYPE_NONE : GST_SEEK_TYPE_SET, stopNs)) {
+        lease.Discard();
+        throw std::runtime_error("Segment seek failed");
     }
-    close(fd);
-    return std::string(buf.data());
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    CancelToken::Hook stopHook = StopOnCancel(cancel, pipeline);
+
+    uint64_t next = first;
+    while (next < end && !abort.load()) {
+        ThrowIfCancelled(cancel);
+        GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(lease->sink));
+        if (!sample) break;
+        GstBuffer* buffer = gst_sample_get_buffer(sample);
+        PcmChunk chunk = buffer ? PcmChunk::Wrap(buffer) : PcmChunk();
+        uint64_t frame = next;
+        if (buffer && GST_CLOCK_TIME_IS_VALID(GST_BUFFER_PTS(buffer))) {
+            frame = gst_util_uint64_scale_round(GST_BUFFER_PTS(buffer), rate,
+                                                GST_SECOND);
+        }
+        gst_sample_unref(sample);
+
+        uint64_t frames = chunk.size() / bpf;
+        if (frames == 0 || frame + frames <= next) continue;
+        if (frame > next) {
+            EmitSilence(index, std::min(frame, end) - next, bpf, callbacks);
+            next = std::min(frame, end);
+            if (next == end) break;
+        }
+        uint64_t skip = next - frame;
+        uint64_t take = std::min(frames - skip, end - next);
+        callbacks.onChunk(index, chunk.Slice(skip * bpf, take * bpf));
+        next += take;
+    }
+    ThrowIfCancelled(cancel);
+    if (!last && next < end && !abort.load()) {
+        EmitSilence(index, end - next, bpf, callbacks);
+    }
+    if (callbacks.onSegmentEnd) callbacks.onSegmentEnd(index);
 }
 
-static std::vector<uint8_t> ReadAndDeleteFile(const std::string& path) {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot read output file");
-    }
-    auto size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    std::vector<uint8_t> bytes(size);
-    file.read(reinterpret_cast<char*>(bytes.data()), size);
-    file.close();
-    std::remove(path.c_str());
-    return bytes;
+/// Decodes the whole of [inputPath] as N time segments on N pipelines in
+/// parallel and returns true, or returns false without delivering anything
+/// when the input is too short, not seekable or has no known duration, so
+/// the caller can use DecodeToPcmStream instead.  Segment bounds are
+/// multiples of [frameAlign] frames.
+static bool DecodeSegmented(const std::string& inputPath,
+                            const DecodeOptions& options, uint64_t frameAlign,
+                            const SegmentCallbacks& callbacks) {
+    int maxSegments = DecodeSegmentCount();
+    if (maxSegments < 2 || options.startMs >= 0 || options.endMs >= 0) {
+        return false;
+    }
+    // Only local, sample-accurate files are split, and small ones are not
+    // worth the extra preroll the probe below costs.
+    struct stat st;
+    if (stat(inputPath.c_str(), &st) != 0 ||
+        st.st_size < kMinSegmentedInputBytes ||
+        !IsSampleAccurateInput(inputPath)) {
+        return false;
+    }
+
+    std::string uri = PathToUri(inputPath);
+    std::string capsStr = OutputCaps(options);
+    DecodeQueueLimits limits = CurrentConfig().queueLimits;
+    auto prepare = [&](DecodePipelinePool::Lease& lease) {
+        g_object_set(lease->source, "uri", uri.c_str(), nullptr);
+        audio_decoder::SetQueueLimits(lease.operator->(), limits);
+        gst_element_set_state(lease->pipeline, GST_STATE_PAUSED);
+        CancelToken::Hook stopHook = StopOnCancel(options.cancel,
+                                                  lease->pipeline);
+        // Blocks until the first buffer reaches appsink (or EOS/error).
+        return gst_app_sink_pull_preroll(GST_APP_SINK(lease->sink));
+    };
+
+    // Preroll one pipeline to learn the output format, duration and
+    // seekability; it then decodes the first segment.
+    auto lease = DecodePipelinePool::Instance().Acquire(capsStr);
+    GstSample* preroll = prepare(lease);
+    if (!preroll) {
+        lease.Discard();
+        ThrowIfCancelled(options.cancel);
+        return false;
+    }
+    SegmentPlan plan{};
+    GstAudioInfo audioInfo;
+    GstCaps* caps = gst_sample_get_caps(preroll);
+    bool haveFormat = caps && gst_audio_info_from_caps(&audioInfo, caps);
+    gst_sample_unref(preroll);
+    gint64 durationNs = -1;
+    gboolean seekable = FALSE;
+    GstQuery* query = gst_query_new_seeking(GST_FORMAT_TIME);
+    if (gst_element_query(lease->pipeline, query)) {
+        gst_query_parse_seeking(query, nullptr, &seekable, nullptr, nullptr);
+    }
+    gst_query_unref(query);
+    if (!haveFormat || !seekable ||
+        !gst_element_query_duration(lease->pipeline, GST_FORMAT_TIME,
+                                    &durationNs) ||
+        durationNs <= 0) {
+        return false;
+    }
+    int64_t segments = std::min<int64_t>(
+        maxSegments, durationNs / (kMinSegmentMs * static_cast<gint64>(GST_MSECOND)));
+    if (segments < 2) return false;
+
+    plan.info.sampleRate = audioInfo.rate;
+    plan.info.channels = audioInfo.channels;
+    plan.info.bitsPerSample = audioInfo.finfo->width;
+    plan.info.format = GST_AUDIO_INFO_FORMAT(&audioInfo);
+    plan.bytesPerFrame = audioInfo.bpf;
+    uint64_t totalFrames = gst_util_uint64_scale(
+        static_cast<guint64>(durationNs), audioInfo.rate, GST_SECOND);
+    plan.totalFrames = totalFrames;
+    for (int64_t i = 0; i < segments; i++) {
+        uint64_t bound = totalFrames * i / segments;
+        plan.bounds.push_back(bound - bound % frameAlign);
+    }
+    plan.bounds.push_back(UINT64_MAX);
+    if (callbacks.onPlan) callbacks.onPlan(plan);
+
+    // Every segment reports into the same progress, so the position is
+    // the total media time decoded so far across segments.
+    SegmentCallbacks tracked = callbacks;
+    if (options.progress) {
+        JobProgress* progress = options.progress;
+        uint64_t bytesPerSecond =
+            static_cast<uint64_t>(audioInfo.rate) * audioInfo.bpf;
+        progress->SetDuration(static_cast<uint64_t>(durationNs));
+        tracked.onChunk = [&callbacks, progress, bytesPerSecond](
+                size_t segment, const PcmChunk& chunk) {
+            callbacks.onChunk(segment, chunk);
+            progress->Advance(gst_util_uint64_scale(chunk.size(), GST_SECOND,
+                                                    bytesPerSecond),
+                              chunk.size());
+        };
+    }
+
+    std::atomic<bool> abort{false};
+    std::vector<std::exception_ptr> errors(plan.segments());
+    auto run = [&](size_t index, DecodePipelinePool::Lease segmentLease) {
+        try {
+            if (abort.load()) return;
+            if (index > 0) {
+                GstSample* sample = prepare(segmentLease);
+                if (!sample) {
+                    segmentLease.Discard();
+                    ThrowIfCancelled(options.cancel);
+                    throw std::runtime_error("Failed to preroll decode segment");
+                }
+                gst_sample_unref(sample);
+            }
+            DecodeSegment(segmentLease, plan, index, tracked, abort,
+                          options.cancel);
+        } catch (...) {
+            segmentLease.Discard();
+            errors[index] = std::current_exception();
+            abort = true;
+        }
+    };
+
+    // Segments run on idle executor workers; whatever none picks up runs on
+    // this thread, so a busy pool degrades to a serial decode.
+    JobExecutor::Instance().ParallelFor(plan.segments(), [&](size_t index) {
+        run(index, index == 0 ? std::move(lease)
+                              : DecodePipelinePool::Instance().Acquire(capsStr));
+    });
+    {
+        std::lock_guard<std::mutex> lock(gSegmentStatsMutex);
+        gSegmentStats.jobs++;
+        gSegmentStats.segments += plan.segments();
+    }
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return true;
 }
 
 // ---------------------------------------------------------------------------
 // Core operations
 // ---------------------------------------------------------------------------
 
-/// Streams decoded PCM to a WAV file on disk.  Opens the output file, writes
-/// a placeholder header, decodes via DecodeToPcmStream, then seeks back to
-/// finalize the header.  On any failure the output file is removed.
-static PcmInfo StreamPcmToWav(
-        const std::string& inputPath,
-        const std::string& outputPath,
-        int64_t startMs = -1, int64_t endMs = -1,
-        int targetSampleRate = -1, int targetChannels = -1,
-        int targetBitDepth = -1) {
-    std::fstream file(outputPath,
-                      std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open output file for writing");
+/// WAV bytes are returned in one message without RF64, so they cannot pass the
+/// 32-bit data size of a plain WAV file.
+static constexpr const char* kMemoryWavTooLarge =
+    "WAV bytes exceed the 4 GB in-memory limit; convert to a file instead";
+
+/// Decodes [inputPath] into [writer], a WavFileWriter or WavMemoryWriter,
+/// and finalizes it.
+template <typename Writer>
+static PcmInfo DecodeToWav(
+        Writer& writer, const std::string& inputPath,
+        int64_t startMs, int64_t endMs,
+        int targetSampleRate, int targetChannels, int targetBitDepth,
+        WavSampleFormat sampleFormat, CancelToken* cancel,
+        JobProgress* progress) {
+    DecodeOptions options;
+    options.startMs = startMs;
+    options.endMs = endMs;
+    options.sampleRate = targetSampleRate;
+    options.channels = targetChannels;
+    options.bitDepth = targetBitDepth;
+    options.floatSamples = sampleFormat == WavSampleFormat::kFloat;
+    options.nativeFormat = sampleFormat == WavSampleFormat::kNative;
+    options.cancel = cancel;
+    options.progress = progress;
+
+    // Long seekable inputs decode as parallel segments, each writing its
+    // frames at their final offset in the data chunk.
+    struct SegmentBatch {
+        uint64_t offset = 0;
+        std::vector<PcmChunk> chunks;
+        size_t bytes = 0;
+    };
+    std::vector<SegmentBatch> batches;
+    PcmInfo segmentedInfo{};
+    auto flush = [&](SegmentBatch& batch) {
+        writer.WriteAt(batch.offset, batch.chunks);
+        batch.offset += batch.bytes;
+        batch.chunks.clear();
+        batch.bytes = 0;
+    };
+    SegmentCallbacks callbacks;
+    callbacks.onPlan = [&](const SegmentPlan& plan) {
+        segmentedInfo = plan.info;
+        writer.SetFloatSamples(IsFloatFormat(plan.info.format));
+        writer.Reserve(plan.totalFrames * plan.bytesPerFrame);
+        batches.resize(plan.segments());
+        for (size_t i = 0; i < batches.size(); i++) {
+            batches[i].offset = plan.bounds[i] * plan.bytesPerFrame;
+        }
+    };
+    callbacks.onChunk = [&](size_t segment, const PcmChunk& chunk) {
+        SegmentBatch& batch = batches[segment];
+        if constexpr (std::is_same_v<Writer, WavMemoryWriter>) {
+            if (batch.offset + batch.bytes + chunk.size() >
+                WavMemoryWriter::kMaxDataSize) {
+                throw std::runtime_error(kMemoryWavTooLarge);
+            }
+        }
+        batch.chunks.push_back(chunk);
+        batch.bytes += chunk.size();
+        if (batch.bytes >= kSegmentWriteBytes ||
+            batch.chunks.size() >= WavFileWriter::kMaxHeldChunks) {
+            flush(batch);
+        }
+    };
+    callbacks.onSegmentEnd = [&](size_t segment) { flush(batches[segment]); };
+    if (DecodeSegmented(inputPath, options, 1, callbacks)) {
+        if (writer.dataSize() == 0) {
+            throw std::runtime_error("No audio data decoded");
+        }
+        writer.Finalize(segmentedInfo.sampleRate,
+                        static_cast<uint16_t>(segmentedInfo.channels),
+                        static_cast<uint16_t>(segmentedInfo.bitsPerSample));
+        return segmentedInfo;
     }
 
-    WriteWavHeader(file, 0, 0, 0, 0);
-
-    int64_t totalPcmBytes = 0;
-    PcmInfo info{};
-    try {
-        info = DecodeToPcmStream(inputPath,
-            [&](const uint8_t* data, size_t size) {
-                file.write(reinterpret_cast<const char*>(data), size);
-                if (!file) {
-                    throw std::runtime_error("Failed to write PCM data to WAV file");
-                }
-                totalPcmBytes += static_cast<int64_t>(size);
-                if (totalPcmBytes > kMaxWavDataSize) {
-                    throw std::runtime_error("WAV output exceeds maximum size (~4 GB)");
+    PcmInfo info = DecodeToPcmStream(inputPath, options,
+        [&](const PcmChunk& chunk) {
+            if constexpr (std::is_same_v<Writer, WavMemoryWriter>) {
+                if (writer.dataSize() + chunk.size() >
+                    WavMemoryWriter::kMaxDataSize) {
+                    throw std::runtime_error(kMemoryWavTooLarge);
                 }
-            },
-            startMs, endMs, targetSampleRate, targetChannels, targetBitDepth);
-    } catch (...) {
-        file.close();
-        std::remove(outputPath.c_str());
-        throw;
-    }
+            }
+            writer.Append(chunk);
+        },
+        [&](const PcmInfo& format, int64_t expectedBytes) {
+            writer.SetFloatSamples(IsFloatFormat(format.format));
+            if (expectedBytes > 0) writer.Reserve(expectedBytes);
+        });
 
-    if (totalPcmBytes == 0) {
-        file.close();
-        std::remove(outputPath.c_str());
+    if (writer.dataSize() == 0) {
         throw std::runtime_error("No audio data decoded");
     }
 
-    file.seekp(0);
-    if (!file) {
-        file.close();
-        std::remove(outputPath.c_str());
-        throw std::runtime_error("Failed to seek to beginning of WAV file");
-    }
-    WriteWavHeader(file, static_cast<uint32_t>(totalPcmBytes), info.sampleRate,
-                   static_cast<uint16_t>(info.channels),
-                   static_cast<uint16_t>(info.bitsPerSample));
-    file.close();
+    writer.Finalize(info.sampleRate, static_cast<uint16_t>(info.channels),
+                    static_cast<uint16_t>(info.bitsPerSample));
     return info;
 }
 
+/// Opens [inputPath] if it is a PCM WAV file whose samples are already what
+/// a decode would deliver: the requested rate and channels, defaulting to
+/// the source's, in [sampleFormat].  Integer output defaults to 16 bits and
+/// excludes 8-bit files, as WAV stores them unsigned; native output takes
+/// any file whose format a decode would keep.  Returns the open descriptor,
+/// or -1 if the input has to be decoded.
+static int OpenPassthroughWav(const std::string& inputPath,
+                              int targetSampleRate, int targetChannels,
+                              int targetBitDepth, WavSampleFormat sampleFormat,
+                              audio_decoder::WavLayout* layout) {
+    if (MemorySource::IsMemoryUri(inputPath)) return -1;
+    std::string path = inputPath;
+    if (path.rfind("file://", 0) == 0) {
+        gchar* filename = g_filename_from_uri(path.c_str(), nullptr, nullptr);
+        if (!filename) return -1;
+        path = filename;
+        g_free(filename);
+    }
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int bitDepth = targetBitDepth > 0 ? targetBitDepth : 16;
+    bool matches = HeaderProbe::ReadPcmWavLayout(fd, layout);
+    switch (sampleFormat) {
+        case WavSampleFormat::kInteger:
+            matches = matches && !layout->floatSamples &&
+                      layout->bitsPerSample == bitDepth && bitDepth != 8;
+            break;
+        case WavSampleFormat::kFloat:
+            matches = matches && layout->floatSamples &&
+                      layout->bitsPerSample == 32;
+            break;
+        case WavSampleFormat::kNative:
+            matches = matches && (layout->floatSamples ||
+                                  (layout->bitsPerSample % 8 == 0 &&
+                                   layout->bitsPerSample <= 32));
+            break;
+    }
+    if (!matches ||
+        (targetSampleRate > 0 &&
+         layout->sampleRate != static_cast<uint32_t>(targetSampleRate)) ||
+        (targetChannels > 0 && layout->channels != targetChannels)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Copies the frames of [startMs, endMs) of the PCM WAV open at [fd] into
+/// [writer] in the kernel, in slices so the job can be cancelled and report
+/// progress.  Returns false, having written nothing, if the range holds no
+/// frames; a decode then reports the error.
+static bool CopyPcmWav(WavFileWriter& writer, int fd,
+                       const audio_decoder::WavLayout& layout,
+                       int64_t startMs, int64_t endMs,
+                       CancelToken* cancel, JobProgress* progress) {
+    uint64_t totalFrames = layout.dataSize / layout.blockAlign;
+    uint64_t startFrame = startMs > 0
+        ? gst_util_uint64_scale(startMs, layout.sampleRate, 1000) : 0;
+    uint64_t endFrame = endMs >= 0
+        ? std::min<uint64_t>(
+              gst_util_uint64_scale(endMs, layout.sampleRate, 1000), totalFrames)
+        : totalFrames;
+    if (startFrame >= endFrame) return false;
+    uint64_t size = (endFrame - startFrame) * layout.blockAlign;
+    writer.SetFloatSamples(layout.floatSamples);
+    writer.Reserve(size);
+
+    uint64_t offset = layout.dataOffset + startFrame * layout.blockAlign;
+    uint64_t bytesPerSecond =
+        static_cast<uint64_t>(layout.sampleRate) * layout.blockAlign;
+    if (progress) {
+        progress->SetDuration(gst_util_uint64_scale(size, GST_SECOND,
+                                                    bytesPerSecond));
+    }
+    for (uint64_t copied = 0; copied < size;) {
+        ThrowIfCancelled(cancel);
+        uint64_t slice = std::min(kPassthroughSliceBytes, size - copied);
+        writer.CopyFrom(fd, offset + copied, slice);
+        copied += slice;
+        if (progress) {
+            progress->Advance(gst_util_uint64_scale(slice, GST_SECOND,
+                                                    bytesPerSecond),
+                              slice);
+        }
+    }
+    writer.Finalize(layout.sampleRate, layout.channels, layout.bitsPerSample);
+    std::lock_guard<std::mutex> lock(gPassthroughStatsMutex);
+    gPassthroughStats.jobs++;
+    gPassthroughStats.bytes += size;
+    return true;
+}
+
+/// Writes [inputPath], or its [startMs, endMs) range, to a WAV file.  A PCM
+/// WAV input already in the target format is copied rather than decoded.
+static PcmInfo StreamPcmToWav(
+        const std::string& inputPath,
+        const std::string& outputPath,
+        int64_t startMs = -1, int64_t endMs = -1,
+        int targetSampleRate = -1, int targetChannels = -1,
+        int targetBitDepth = -1,
+        WavSampleFormat sampleFormat = WavSampleFormat::kInteger,
+        CancelToken* cancel = nullptr, JobProgress* progress = nullptr) {
+    audio_decoder::WavLayout layout;
+    int fd = OpenPassthroughWav(inputPath, targetSampleRate, targetChannels,
+                                targetBitDepth, sampleFormat, &layout);
+    WavFileWriter writer(outputPath);
+    if (fd >= 0) {
+        bool copied = false;
+        try {
+            copied = CopyPcmWav(writer, fd, layout, startMs, endMs, cancel,
+                                progress);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        if (copied) {
+            GstAudioFormat format;
+            if (layout.floatSamples) {
+                format = layout.bitsPerSample == 64 ? GST_AUDIO_FORMAT_F64LE
+                                                    : GST_AUDIO_FORMAT_F32LE;
+            } else {
+                format = gst_audio_format_build_integer(
+                    layout.bitsPerSample > 8, G_LITTLE_ENDIAN,
+                    layout.bitsPerSample, layout.bitsPerSample);
+            }
+            return PcmInfo{layout.sampleRate, layout.channels,
+                           layout.bitsPerSample, format};
+        }
+    }
+    return DecodeToWav(writer, inputPath, startMs, endMs, targetSampleRate,
+                       targetChannels, targetBitDepth, sampleFormat, cancel,
+                       progress);
+}
+
+/// Like StreamPcmToWav, but returns the WAV file (or, without
+/// [includeHeader], the bare PCM) as bytes.
+static FlValue* DecodeToWavBytes(
+        const std::string& inputPath, int64_t startMs, int64_t endMs,
+        int targetSampleRate, int targetChannels, int targetBitDepth,
+        WavSampleFormat sampleFormat, bool includeHeader, CancelToken* cancel,
+        JobProgress* progress) {
+    WavMemoryWriter writer(includeHeader);
+    DecodeToWav(writer, inputPath, startMs, endMs, targetSampleRate,
+                targetChannels, targetBitDepth, sampleFormat, cancel,
+                progress);
+    return fl_value_new_uint8_list(writer.bytes().data(), writer.bytes().size());
+}
+
 static std::string ConvertToWav(const std::string& inputPath,
                                 const std::string& outputPath,
                                 int targetSampleRate = -1,
                                 int targetChannels = -1,
-                                int targetBitDepth = -1) {
-    StreamPcmToWav(inputPath, outputPath, -1, -1,
-                   targetSampleRate, targetChannels, targetBitDepth);
+                                int targetBitDepth = -1,
+                                WavSampleFormat sampleFormat =
+                                    WavSampleFormat::kInteger,
+                                CancelToken* cancel = nullptr,
+                                JobProgress* progress = nullptr) {
+    StreamPcmToWav(inputPath, outputPath, -1, -1, targetSampleRate,
+                   targetChannels, targetBitDepth, sampleFormat, cancel,
+                   progress);
     return outputPath;
 }
 
-static std::string ConvertToM4a(const std::string& inputPath,
-                                const std::string& outputPath) {
-    // Stream PCM to temp WAV, then encode to M4A via GStreamer pipeline
-    std::string tempWav = WriteTempFile({}, "wav");
-    StreamPcmToWav(inputPath, tempWav);
-
-    gchar* srcUri = g_filename_to_uri(tempWav.c_str(), nullptr, nullptr);
-    std::string pipeDesc =
-        std::string("uridecodebin uri=\"") + srcUri + "\" ! audioconvert ! "
-        "avenc_aac ! mp4mux ! filesink location=\"" + outputPath + "\"";
-    g_free(srcUri);
-
-    GError* error = nullptr;
-    GstElement* pipeline = gst_parse_launch(pipeDesc.c_str(), &error);
-    if (!pipeline || error) {
-        std::string msg = error ? error->message : "Unknown error";
-        if (error) g_error_free(error);
+/// AAC encoders in order of preference; the first one installed is used.
+static const char* const kAacEncoders[] = {"avenc_aac", "fdkaacenc", "voaacenc"};
+
+/// Charges the bytes a sink is about to write to a ScratchFile.  The first
+/// buffer that does not fit the memory budget is dropped and an error is
+/// posted for the sink instead.
+struct ScratchBudget {
+    ScratchFile* file;
+    GstElement* sink;
+    uint64_t written = 0;
+    bool exceeded = false;
+
+    static GstPadProbeReturn OnBuffer(GstPad*, GstPadProbeInfo* info,
+                                      gpointer data) {
+        auto* self = static_cast<ScratchBudget*>(data);
+        if (self->exceeded) return GST_PAD_PROBE_DROP;
+        self->written += (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER)
+            ? gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info))
+            : gst_buffer_list_calculate_size(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+        if (self->file->Reserve(self->written)) return GST_PAD_PROBE_OK;
+        self->exceeded = true;
+        GError* err = g_error_new_literal(
+            GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_NO_SPACE_LEFT,
+            "Output exceeds the scratch memory budget (scratchMemoryBudget)");
+        gst_element_post_message(self->sink, gst_message_new_error(
+            GST_OBJECT(self->sink), err, nullptr));
+        g_error_free(err);
+        return GST_PAD_PROBE_DROP;
+    }
+};
+
+/// Transcodes [inputPath] to AAC in an MP4 container in a single streaming
+/// pass:
+///
+///   uridecodebin ! audioconvert ! audioresample ! <aac encoder> ! mp4mux ! filesink
+///
+/// No intermediate PCM file is written.  If [startMs] or [endMs] is set,
+/// decoded buffers are held before audioconvert until an accurate flushing
+/// seek has limited the decode to that range, so the encoder never sees
+/// audio from outside it.  On failure or cancellation the partial output file is
+/// removed.  [progress], if set, gets the encoded position and the bytes
+/// written to the file.
+/// With [stream] set, the file is written to it instead of [outputPath];
+/// mp4mux seeks back to patch its headers, so it must be seekable.
+/// With [scratch] set, [outputPath] is its path() and every buffer the sink
+/// takes is charged to it first; encoding fails once the scratch memory
+/// budget runs out.
+static void EncodeToM4a(const std::string& inputPath,
+                        const std::string& outputPath,
+                        int64_t startMs = -1, int64_t endMs = -1,
+                        CancelToken* cancel = nullptr,
+                        JobProgress* progress = nullptr,
+                        GOutputStream* stream = nullptr,
+                        ScratchFile* scratch = nullptr) {
+    ThrowIfCancelled(cancel);
+    std::string uri = PathToUri(inputPath);
+
+    GstElement* encoder = nullptr;
+    for (const char* name : kAacEncoders) {
+        encoder = gst_element_factory_make(name, nullptr);
+        if (encoder) break;
+    }
+    GstElement* pipeline = gst_pipeline_new(nullptr);
+    GstElement* source = gst_element_factory_make("uridecodebin", nullptr);
+    GstElement* convert = gst_element_factory_make("audioconvert", nullptr);
+    GstElement* resample = gst_element_factory_make("audioresample", nullptr);
+    GstElement* mux = gst_element_factory_make("mp4mux", nullptr);
+    GstElement* sink = gst_element_factory_make(
+        stream ? "giostreamsink" : "filesink", nullptr);
+
+    if (!pipeline || !source || !convert || !resample || !encoder || !mux ||
+            !sink) {
+        for (GstElement* e : {source, convert, resample, encoder, mux, sink}) {
+            if (e) gst_object_unref(e);
+        }
         if (pipeline) gst_object_unref(pipeline);
-        std::remove(tempWav.c_str());
-        throw std::runtime_error("Failed to create M4A encoding pipeline: " + msg);
+        throw std::runtime_error(
+            "Failed to create M4A encoding pipeline: missing GStreamer element");
     }
 
-    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    g_object_set(source, "uri", uri.c_str(), nullptr);
+    g_signal_connect(source, "source-setup",
+                     G_CALLBACK(MemorySource::OnSourceSetup), nullptr);
+    if (stream) {
+        g_object_set(sink, "stream", stream, nullptr);
+    } else {
+        g_object_set(sink, "location", outputPath.c_str(), nullptr);
+    }
+    gst_bin_add_many(GST_BIN(pipeline), source, convert, resample, encoder,
+                     mux, sink, nullptr);
+    if (!gst_element_link_many(convert, resample, encoder, mux, sink, nullptr)) {
+        gst_object_unref(pipeline);
+        throw std::runtime_error("Failed to link M4A encoding pipeline");
+    }
+    audio_decoder::LinkDecodedAudioPads(source, convert);
+
+    // filesink writes the scratch through its path, past ScratchFile::Write,
+    // so the budget is enforced before each buffer reaches the sink.
+    ScratchBudget budget{scratch, sink};
+    if (scratch) {
+        GstPad* sinkPad = gst_element_get_static_pad(sink, "sink");
+        gst_pad_add_probe(sinkPad,
+            static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER |
+                                         GST_PAD_PROBE_TYPE_BUFFER_LIST),
+            ScratchBudget::OnBuffer, &budget, nullptr);
+        gst_object_unref(sinkPad);
+    }
 
     GstBus* bus = gst_element_get_bus(pipeline);
-    GstMessage* msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE,
-        static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+    auto discard = [&]() {
+        gst_object_unref(bus);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        // Scratch has no name to unlink; its owner closes it.
+        if (!stream && !scratch) std::remove(outputPath.c_str());
+    };
+    auto fail = [&](const std::string& message) {
+        discard();
+        throw std::runtime_error(message);
+    };
+
+    const GstMessageType finished =
+        static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+    if (startMs >= 0 || endMs >= 0) {
+        // mp4mux keeps the samples it has taken across a flush, so nothing
+        // may reach the encoder before the seek.  The first decoded buffer
+        // shows the demuxer is running; it is held at audioconvert, the
+        // seek flushes it away and then the gate opens.
+        std::atomic<bool> held{false};
+        GstPad* gatePad = gst_element_get_static_pad(convert, "sink");
+        gulong gate = gst_pad_add_probe(gatePad,
+            static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BLOCK |
+                                         GST_PAD_PROBE_TYPE_BUFFER |
+                                         GST_PAD_PROBE_TYPE_BUFFER_LIST),
+            [](GstPad*, GstPadProbeInfo*, gpointer data) {
+                static_cast<std::atomic<bool>*>(data)->store(true);
+                return GST_PAD_PROBE_OK;
+            },
+            &held, nullptr);
+        auto openGate = [&]() {
+            if (!gatePad) return;
+            gst_pad_remove_probe(gatePad, gate);
+            gst_object_unref(gatePad);
+            gatePad = nullptr;
+        };
+        gst_element_set_state(pipeline, GST_STATE_PAUSED);
+        while (!held.load()) {
+            if (cancel && cancel->cancelled()) {
+                openGate();
+                discard();
+                throw JobCancelledError();
+            }
+            GstMessage* early =
+                gst_bus_timed_pop_filtered(bus, kProgressPollNs, finished);
+            if (early) {
+                bool eos = GST_MESSAGE_TYPE(early) == GST_MESSAGE_EOS;
+                std::string errMsg = "No audio in input";
+                if (!eos) {
+                    GError* err = nullptr;
+                    gst_message_parse_error(early, &err, nullptr);
+                    if (err) errMsg = err->message;
+                    if (err) g_error_free(err);
+                }
+                gst_message_unref(early);
+                openGate();
+                fail("M4A encoding failed: " + errMsg);
+            }
+        }
+        gboolean seeked = gst_pad_push_event(gatePad, gst_event_new_seek(
+            1.0, GST_FORMAT_TIME,
+            static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+            GST_SEEK_TYPE_SET,
+            startMs > 0 ? startMs * static_cast<gint64>(GST_MSECOND) : 0,
+            endMs >= 0 ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE,
+            endMs >= 0 ? endMs * static_cast<gint64>(GST_MSECOND) : -1));
+        openGate();
+        if (!seeked) fail("M4A encoding failed: input is not seekable");
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    // Cancelling pushes EOS through the encoder, so the wait below ends as
+    // soon as the muxer has flushed; the file is then removed.
+    CancelToken::Hook stopHook = StopOnCancel(cancel, pipeline);
+
+    GstMessage* msg = nullptr;
+    if (!progress) {
+        msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, finished);
+    }
+    // With progress reporting, poll the pipeline position and the bytes
+    // the sink has written between waits for the bus.
+    const gint64 rangeStart =
+        startMs > 0 ? startMs * static_cast<gint64>(GST_MSECOND) : 0;
+    bool haveDuration = false;
+    while (!msg && progress) {
+        msg = gst_bus_timed_pop_filtered(bus, kProgressPollNs, finished);
+        gint64 durationNs = 0, positionNs = 0, bytes = 0;
+        if (!haveDuration &&
+            gst_element_query_duration(pipeline, GST_FORMAT_TIME, &durationNs) &&
+            durationNs > 0) {
+            gint64 rangeEnd = endMs >= 0
+                ? std::min<gint64>(durationNs, endMs * static_cast<gint64>(GST_MSECOND))
+                : durationNs;
+            if (rangeEnd > rangeStart) progress->SetDuration(rangeEnd - rangeStart);
+            haveDuration = true;
+        }
+        gst_element_query_position(pipeline, GST_FORMAT_TIME, &positionNs);
+        gst_element_query_position(sink, GST_FORMAT_BYTES, &bytes);
+        progress->Set(static_cast<uint64_t>(std::max<gint64>(0, positionNs - rangeStart)),
+                      static_cast<uint64_t>(std::max<gint64>(0, bytes)));
+    }
 
     bool success = true;
     std::string errMsg;
@@ -353,49 +1249,71 @@ static std::string ConvertToM4a(const std::string& inputPath,
         gst_message_unref(msg);
     }
 
-    gst_object_unref(bus);
-    gst_element_set_state(pipeline, GST_STATE_NULL);
-    gst_object_unref(pipeline);
-    std::remove(tempWav.c_str());
-
+    if (cancel && cancel->cancelled()) {
+        discard();
+        throw JobCancelledError();
+    }
     if (!success) {
-        throw std::runtime_error("M4A encoding failed: " + errMsg);
+        fail("M4A encoding failed: " + errMsg);
     }
 
-    return outputPath;
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
 }
 
-static FlValue* GetAudioInfo(const std::string& path) {
-    gchar* uri = nullptr;
-    if (path.rfind("file://", 0) == 0) {
-        uri = g_strdup(path.c_str());
-    } else {
-        uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
-    }
-    if (!uri) {
-        throw std::runtime_error("Cannot convert path to URI");
+/// Encodes [inputPath] (optionally the range [startMs, endMs)) to an M4A
+/// file collected in memory and returns its bytes.  [expectedBytes] is a
+/// guess at the output size, charged to the scratch budget if scratch is
+/// needed; output beyond it is charged as it is written, and encoding
+/// fails if the budget runs out.
+static FlValue* EncodeToM4aBytes(const std::string& inputPath,
+                                 int64_t startMs, int64_t endMs,
+                                 uint64_t expectedBytes,
+                                 CancelToken* cancel, JobProgress* progress) {
+    // giostreamsink comes with gst-plugins-base's gio plugin; without it the
+    // muxer writes to scratch, which stays in memory within the budget.
+    GstElementFactory* streamSink = gst_element_factory_find("giostreamsink");
+    if (!streamSink) {
+        std::unique_ptr<ScratchFile> scratch = ScratchFile::Create(expectedBytes);
+        if (!scratch) throw std::runtime_error("Failed to create scratch file");
+        EncodeToM4a(inputPath, scratch->path(), startMs, endMs, cancel,
+                    progress, nullptr, scratch.get());
+        const uint8_t* data = scratch->Map();
+        if (!data) throw std::runtime_error("M4A encoding produced no output");
+        return fl_value_new_uint8_list(data, scratch->size());
     }
+    gst_object_unref(streamSink);
 
-    GError* error = nullptr;
-    GstDiscoverer* discoverer = gst_discoverer_new(5 * GST_SECOND, &error);
-    if (!discoverer) {
-        std::string msg = error ? error->message : "Unknown error";
-        if (error) g_error_free(error);
-        g_free(uri);
-        throw std::runtime_error("Failed to create discoverer: " + msg);
+    GOutputStream* stream = g_memory_output_stream_new_resizable();
+    try {
+        EncodeToM4a(inputPath, std::string(), startMs, endMs, cancel, progress,
+                    stream);
+    } catch (...) {
+        g_object_unref(stream);
+        throw;
     }
+    GMemoryOutputStream* memory = G_MEMORY_OUTPUT_STREAM(stream);
+    FlValue* result = fl_value_new_uint8_list(
+        static_cast<const uint8_t*>(g_memory_output_stream_get_data(memory)),
+        g_memory_output_stream_get_data_size(memory));
+    g_object_unref(stream);
+    return result;
+}
 
-    GstDiscovererInfo* info = gst_discoverer_discover_uri(discoverer, uri, &error);
-    g_free(uri);
+static std::string ConvertToM4a(const std::string& inputPath,
+                                const std::string& outputPath,
+                                CancelToken* cancel = nullptr,
+                                JobProgress* progress = nullptr) {
+    EncodeToM4a(inputPath, outputPath, -1, -1, cancel, progress);
+    return outputPath;
+}
 
-    if (!info || error) {
-        std::string msg = error ? error->message : "Unknown error";
-        if (error) g_error_free(error);
-        if (info) gst_discoverer_info_unref(info);
-        g_object_unref(discoverer);
-        throw std::runtime_error("Failed to discover audio info: " + msg);
-    }
+/// getAudioInfo results of local files, by path, size and mtime.
+static AudioInfoCache gInfoCache(kDefaultInfoCacheEntries);
 
+/// Extracts the getAudioInfo fields from discoverer results.
+static AudioInfoRecord ProbeRecord(GstDiscovererInfo* info) {
     GstClockTime duration = gst_discoverer_info_get_duration(info);
     int64_t durationMs = static_cast<int64_t>(duration / GST_MSECOND);
 
@@ -451,128 +1369,608 @@ static FlValue* GetAudioInfo(const std::string& path) {
         gst_discoverer_stream_info_list_free(audioStreams);
     }
 
-    gst_discoverer_info_unref(info);
-    g_object_unref(discoverer);
+    AudioInfoRecord record;
+    record.durationMs = durationMs;
+    record.sampleRate = sampleRate;
+    record.channels = channels;
+    record.bitRate = bitRate;
+    record.format = format;
+    return record;
+}
 
+/// Builds the map returned by getAudioInfo.
+static FlValue* AudioInfoMap(const AudioInfoRecord& record) {
     FlValue* map = fl_value_new_map();
     fl_value_set_string_take(map, "durationMs",
-        fl_value_new_int(static_cast<int64_t>(durationMs)));
+        fl_value_new_int(record.durationMs));
     fl_value_set_string_take(map, "sampleRate",
-        fl_value_new_int(sampleRate));
+        fl_value_new_int(record.sampleRate));
     fl_value_set_string_take(map, "channels",
-        fl_value_new_int(channels));
+        fl_value_new_int(record.channels));
     fl_value_set_string_take(map, "bitRate",
-        fl_value_new_int(bitRate));
+        fl_value_new_int(record.bitRate));
     fl_value_set_string_take(map, "format",
-        fl_value_new_string(format.c_str()));
+        fl_value_new_string(record.format.c_str()));
     return map;
 }
 
-static std::string TrimAudio(const std::string& inputPath,
-                             const std::string& outputPath,
-                             int64_t startMs, int64_t endMs) {
-    std::string ext = outputPath.substr(outputPath.find_last_of('.') + 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+/// Identifies the local file behind [path] for the metadata cache.  Returns
+/// false for in-memory inputs and files that cannot be stat'ed.
+static bool InfoCacheKey(const std::string& path, audio_decoder::FileKey* key) {
+    if (MemorySource::IsMemoryUri(path)) return false;
+    if (path.rfind("file://", 0) == 0) {
+        gchar* filename = g_filename_from_uri(path.c_str(), nullptr, nullptr);
+        if (!filename) return false;
+        bool found = audio_decoder::FileKey::ForPath(filename, key);
+        g_free(filename);
+        return found;
+    }
+    return audio_decoder::FileKey::ForPath(path, key);
+}
 
-    if (ext == "m4a") {
-        // Stream trimmed PCM to temp WAV, then encode to M4A
-        std::string tempWav = WriteTempFile({}, "wav");
-        StreamPcmToWav(inputPath, tempWav, startMs, endMs);
-
-        gchar* srcUri = g_filename_to_uri(tempWav.c_str(), nullptr, nullptr);
-        std::string pipeDesc =
-            std::string("uridecodebin uri=\"") + srcUri + "\" ! audioconvert ! "
-            "avenc_aac ! mp4mux ! filesink location=\"" + outputPath + "\"";
-        g_free(srcUri);
-
-        GError* error = nullptr;
-        GstElement* pipeline = gst_parse_launch(pipeDesc.c_str(), &error);
-        if (!pipeline || error) {
-            std::string msg = error ? error->message : "Unknown error";
-            if (error) g_error_free(error);
-            if (pipeline) gst_object_unref(pipeline);
-            std::remove(tempWav.c_str());
-            throw std::runtime_error("Failed to create M4A pipeline: " + msg);
-        }
+/// Answers a local file from the metadata cache or, failing that, from its
+/// headers, caching the result.  Returns false if the discoverer has to
+/// probe it.
+static bool QuickAudioInfo(bool cacheable, const audio_decoder::FileKey& key,
+                           AudioInfoRecord* record) {
+    if (!cacheable) return false;
+    if (gInfoCache.Lookup(key, record)) return true;
+    if (!HeaderProbe::ProbeFile(key.path, record)) return false;
+    gInfoCache.Insert(key, *record);
+    return true;
+}
+
+/// Answers [path] (a file path or URI) from the metadata cache or the file
+/// headers, or probes it on a pooled discoverer and caches the result.
+static FlValue* GetAudioInfo(const std::string& path) {
+    audio_decoder::FileKey key;
+    bool cacheable = InfoCacheKey(path, &key);
+    AudioInfoRecord record;
+    if (QuickAudioInfo(cacheable, key, &record)) {
+        gInfoCache.MaybeFlush();
+        return AudioInfoMap(record);
+    }
 
-        gst_element_set_state(pipeline, GST_STATE_PLAYING);
-        GstBus* bus = gst_element_get_bus(pipeline);
-        GstMessage* msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE,
-            static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
-
-        bool success = true;
-        std::string errMsg;
-        if (msg) {
-            if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
-                GError* err = nullptr;
-                gst_message_parse_error(msg, &err, nullptr);
-                errMsg = err ? err->message : "Unknown error";
-                if (err) g_error_free(err);
-                success = false;
+    std::string uri = PathToUri(path);
+    GstDiscovererInfo* info = nullptr;
+    try {
+        info = DiscovererPool::Instance().DiscoverSync(uri);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(
+            std::string("Failed to discover audio info: ") + e.what());
+    }
+    record = ProbeRecord(info);
+    gst_discoverer_info_unref(info);
+    if (cacheable) {
+        gInfoCache.Insert(key, record);
+        gInfoCache.MaybeFlush();
+    }
+    return AudioInfoMap(record);
+}
+
+/// Probes all [paths] that are neither cached nor answered by their headers
+/// at once, keeping every pooled discoverer busy, and returns one
+/// `{path, info, error}` entry per path, in order.  A path that cannot be
+/// probed gets an error instead of failing the call.
+static FlValue* GetAudioInfoBatch(const std::vector<std::string>& paths,
+                                  CancelToken* cancel) {
+    // Shared with the callbacks, which may outlive a cancelled call.
+    struct BatchState {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+        std::vector<FlValue*> infos;
+        std::vector<std::string> errors;
+        /// Set on cancel, so the pool drops the URIs it has not started.
+        std::atomic<bool> cancelled{false};
+        ~BatchState() {
+            for (FlValue* info : infos) {
+                if (info) fl_value_unref(info);
             }
-            gst_message_unref(msg);
         }
+    };
+    auto state = std::make_shared<BatchState>();
+    state->remaining = paths.size();
+    state->infos.assign(paths.size(), nullptr);
+    state->errors.resize(paths.size());
+    CancelToken::Hook wake = cancel
+        ? cancel->OnCancel([state]() {
+              state->cancelled = true;
+              std::lock_guard<std::mutex> lock(state->mutex);
+              state->done.notify_all();
+          })
+        : CancelToken::Hook();
+
+    for (size_t i = 0; i < paths.size() && !state->cancelled; i++) {
+        audio_decoder::FileKey key;
+        bool cacheable = InfoCacheKey(paths[i], &key);
+        AudioInfoRecord quick;
+        if (QuickAudioInfo(cacheable, key, &quick)) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->infos[i] = AudioInfoMap(quick);
+            state->remaining--;
+            continue;
+        }
+        std::string uri;
+        try {
+            uri = PathToUri(paths[i]);
+        } catch (const std::runtime_error& e) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->errors[i] = e.what();
+            state->remaining--;
+            continue;
+        }
+        DiscovererPool::Instance().Discover(uri,
+            [state, i, cacheable, key](GstDiscovererInfo* info,
+                                       const std::string& error) {
+                FlValue* map = nullptr;
+                if (info) {
+                    AudioInfoRecord record = ProbeRecord(info);
+                    if (cacheable) gInfoCache.Insert(key, record);
+                    map = AudioInfoMap(record);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->infos[i] = map;
+                    state->errors[i] = error;
+                    state->remaining--;
+                }
+                state->done.notify_all();
+            },
+            [state]() { return state->cancelled.load(); });
+    }
 
-        gst_object_unref(bus);
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(pipeline);
-        std::remove(tempWav.c_str());
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&]() {
+            return state->remaining == 0 || state->cancelled.load();
+        });
+    }
+    gInfoCache.Flush();
+    ThrowIfCancelled(cancel);
+
+    FlValue* results = fl_value_new_list();
+    for (size_t i = 0; i < paths.size(); i++) {
+        FlValue* entry = fl_value_new_map();
+        fl_value_set_string_take(entry, "path",
+                                 fl_value_new_string(paths[i].c_str()));
+        FlValue* info = state->infos[i];
+        fl_value_set_string_take(entry, "info",
+                                 info ? fl_value_ref(info) : fl_value_new_null());
+        fl_value_set_string_take(entry, "error", info
+            ? fl_value_new_null()
+            : fl_value_new_string(state->errors[i].c_str()));
+        fl_value_append_take(results, entry);
+    }
+    return results;
+}
 
-        if (!success) {
-            throw std::runtime_error("M4A encoding failed: " + errMsg);
-        }
+static std::string TrimAudio(const std::string& inputPath,
+                             const std::string& outputPath,
+                             int64_t startMs, int64_t endMs,
+                             CancelToken* cancel = nullptr,
+                             JobProgress* progress = nullptr) {
+    std::string ext = outputPath.substr(outputPath.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == "m4a") {
+        EncodeToM4a(inputPath, outputPath, startMs, endMs, cancel, progress);
     } else {
-        StreamPcmToWav(inputPath, outputPath, startMs, endMs);
+        StreamPcmToWav(inputPath, outputPath, startMs, endMs, -1, -1, -1,
+                       WavSampleFormat::kInteger, cancel, progress);
     }
 
     return outputPath;
 }
 
-static FlValue* GetWaveform(const std::string& path, int numberOfSamples) {
-    auto pcm = DecodeToPcm(path);
+/// Maps a negotiated analysis format to its reduction kernel format.
+static SampleFormat KernelSampleFormat(GstAudioFormat format) {
+    switch (format) {
+        case GST_AUDIO_FORMAT_F32LE: return SampleFormat::kF32;
+        case GST_AUDIO_FORMAT_S32LE: return SampleFormat::kS32;
+        case GST_AUDIO_FORMAT_S24LE: return SampleFormat::kS24;
+        default: return SampleFormat::kS16;
+    }
+}
 
-    FlValue* list = fl_value_new_list();
+/// Computes the waveform while the file is decoding: each chunk is folded
+/// into the accumulator's bins and released, so memory stays proportional to
+/// [numberOfSamples] however long the input is.  The analysis profile has the
+/// pipeline downmix to mono and decimate before the samples reach us.
+static std::vector<double> DecodeWaveform(const std::string& path,
+                                          int numberOfSamples,
+                                          int64_t startMs, int64_t endMs,
+                                          CancelToken* cancel) {
+    WaveformAccumulator accumulator(numberOfSamples);
+    SampleFormat format = SampleFormat::kS16;
+    size_t sampleBytes = 2;
+    DecodeOptions options = AnalysisDecodeOptions();
+    options.startMs = startMs;
+    options.endMs = endMs;
+    options.cancel = cancel;
+    DecodeToPcmStream(path, options,
+        [&](const PcmChunk& chunk) {
+            accumulator.Add(chunk.data(), chunk.size() / sampleBytes, format);
+        },
+        [&](const PcmInfo& info, int64_t expectedBytes) {
+            format = KernelSampleFormat(info.format);
+            sampleBytes = audio_decoder::BytesPerSample(format);
+            if (expectedBytes > 0) {
+                accumulator.SetExpectedSamples(expectedBytes / sampleBytes);
+            }
+        });
+    return accumulator.Finish();
+}
 
-    if (pcm.data.empty()) {
-        for (int i = 0; i < numberOfSamples; i++) {
-            fl_value_append_take(list, fl_value_new_float(0.0));
-        }
-        return list;
+/// Directory holding waveform pyramid sidecars, created on first use.
+static std::string WaveformCacheDir() {
+    std::string dir = std::string(g_get_user_cache_dir()) +
+                      "/audio_decoder/waveforms";
+    g_mkdir_with_parents(dir.c_str(), 0700);
+    return dir;
+}
+
+/// Returns the pyramid for [key], mapping its sidecar if it is current or,
+/// with [build], decoding the whole file once to build (and store) it
+/// otherwise.  Returns null on a miss without [build].
+static std::unique_ptr<WaveformPyramid> LoadWaveformPyramid(
+        const PyramidKey& key, bool build, CancelToken* cancel) {
+    std::string file = WaveformCacheDir() + "/" + key.SidecarName();
+    auto pyramid = WaveformPyramid::Open(file, key);
+    {
+        std::lock_guard<std::mutex> lock(gWaveformCacheMutex);
+        (pyramid ? gWaveformCacheStats.hits : gWaveformCacheStats.misses)++;
     }
+    if (pyramid || !build) return pyramid;
+
+    DecodeOptions options = AnalysisDecodeOptions();
+    options.cancel = cancel;
+    audio_decoder::WaveformPyramidBuilder builder;
+    SampleFormat format = SampleFormat::kS16;
+    size_t sampleBytes = 2;
+    uint32_t sampleRate = 0;
+    auto onFormat = [&](const PcmInfo& info) {
+        format = KernelSampleFormat(info.format);
+        sampleBytes = audio_decoder::BytesPerSample(format);
+        sampleRate = info.sampleRate;
+    };
 
-    const int16_t* samples = reinterpret_cast<const int16_t*>(pcm.data.data());
-    size_t totalSamples = pcm.data.size() / 2;
-    size_t samplesPerWindow =
-        std::max(static_cast<size_t>(1), totalSamples / numberOfSamples);
+    // Segments start on base-bin boundaries, so the bins each segment
+    // builds concatenate into exactly the bins of a serial decode.
+    std::vector<audio_decoder::WaveformPyramidBuilder> segmentBuilders;
+    SegmentCallbacks callbacks;
+    callbacks.onPlan = [&](const SegmentPlan& plan) {
+        onFormat(plan.info);
+        segmentBuilders.resize(plan.segments());
+    };
+    callbacks.onChunk = [&](size_t segment, const PcmChunk& chunk) {
+        segmentBuilders[segment].Add(chunk.data(), chunk.size() / sampleBytes,
+                                     format);
+    };
+    if (DecodeSegmented(key.path, options,
+                        audio_decoder::kPyramidBaseBinSamples, callbacks)) {
+        for (const auto& segment : segmentBuilders) builder.Append(segment);
+    } else {
+        DecodeToPcmStream(key.path, options,
+            [&](const PcmChunk& chunk) {
+                builder.Add(chunk.data(), chunk.size() / sampleBytes, format);
+            },
+            [&](const PcmInfo& info, int64_t) { onFormat(info); });
+    }
 
-    std::vector<double> waveform;
-    double maxRms = 0;
+    std::vector<uint8_t> image = builder.Serialize(key, sampleRate);
+    if (!WaveformPyramid::WriteImage(file, image)) {
+        std::lock_guard<std::mutex> lock(gWaveformCacheMutex);
+        gWaveformCacheStats.writeFailures++;
+    }
+    return WaveformPyramid::FromImage(std::move(image));
+}
 
-    for (int i = 0; i < numberOfSamples; i++) {
-        size_t start = static_cast<size_t>(i) * totalSamples / numberOfSamples;
-        size_t end = std::min(start + samplesPerWindow, totalSamples);
-        if (start >= totalSamples) break;
+/// Estimates the analysis samples in each of [numberOfSamples] windows over
+/// [startMs, endMs) of [path] from cached or header metadata, without
+/// decoding.  Returns 0 if the length is not known that cheaply.
+static uint64_t EstimatedWindowSamples(const std::string& path,
+                                       int numberOfSamples, int64_t startMs,
+                                       int64_t endMs, int analysisRate) {
+    audio_decoder::FileKey fileKey;
+    bool cacheable = InfoCacheKey(path, &fileKey);
+    AudioInfoRecord record;
+    bool known = QuickAudioInfo(cacheable, fileKey, &record) &&
+                 record.durationMs > 0;
+    int64_t rate = analysisRate;
+    if (known && record.sampleRate > 0) {
+        rate = std::min<int64_t>(rate, record.sampleRate);
+    }
+    int64_t from = std::max<int64_t>(startMs, 0);
+    int64_t to = endMs;
+    if (known) to = to >= 0 ? std::min(to, record.durationMs) : record.durationMs;
+    if (to <= from) return 0;
+    return static_cast<uint64_t>((to - from) * rate / 1000 / numberOfSamples);
+}
 
-        double sumSquares = 0;
-        for (size_t j = start; j < end; j++) {
-            double s = static_cast<double>(samples[j]);
-            sumSquares += s * s;
+/// Returns [numberOfSamples] normalized RMS values for [path], optionally
+/// limited to [startMs, endMs).  Local files are answered from a cached
+/// min/max/RMS pyramid whenever the windows are at least one pyramid bin
+/// wide, so repeated requests at other zoom levels or ranges do not decode
+/// again.  Finer windows, URIs and [useCache] = false decode directly; a
+/// missing pyramid is only built for a request it can answer, so a fine
+/// request never decodes the file twice.
+static FlValue* GetWaveform(const std::string& path, int numberOfSamples,
+                            int64_t startMs = -1, int64_t endMs = -1,
+                            bool useCache = true,
+                            CancelToken* cancel = nullptr) {
+    DecoderConfig config = CurrentConfig();
+    std::vector<double> waveform;
+
+    PyramidKey key;
+    if (useCache && config.waveformCache && numberOfSamples > 0 &&
+        PyramidKey::ForFile(path, config.analysisSampleRate, &key)) {
+        bool build = WaveformPyramid::Resolves(EstimatedWindowSamples(
+            path, numberOfSamples, startMs, endMs, config.analysisSampleRate));
+        auto pyramid = LoadWaveformPyramid(key, build, cancel);
+        if (pyramid && pyramid->samples() > 0) {
+            uint64_t rate = pyramid->sampleRate();
+            uint64_t start = startMs > 0 ? startMs * rate / 1000 : 0;
+            uint64_t end = endMs >= 0 ? endMs * rate / 1000 : pyramid->samples();
+            end = std::min(end, pyramid->samples());
+            if (start < end &&
+                WaveformPyramid::Resolves((end - start) / numberOfSamples)) {
+                waveform = pyramid->Rms(start, end, numberOfSamples);
+            }
         }
-        double rms = std::sqrt(sumSquares / (end - start));
-        waveform.push_back(rms);
-        if (rms > maxRms) maxRms = rms;
     }
+    if (waveform.empty()) {
+        waveform = DecodeWaveform(path, numberOfSamples, startMs, endMs,
+                                  cancel);
+    }
+
+    FlValue* list = fl_value_new_list();
+    for (double value : waveform) {
+        fl_value_append_take(list, fl_value_new_float(value));
+    }
+    return list;
+}
 
-    for (size_t i = 0; i < waveform.size(); i++) {
-        double normalized = (maxRms > 0) ? waveform[i] / maxRms : 0.0;
-        fl_value_append_take(list, fl_value_new_float(normalized));
+/// Reports the native counters that show how much work the caches and pools
+/// are saving.  Each section is keyed by the subsystem it describes.
+static FlValue* GetDecoderStats() {
+    FlValue* pools = fl_value_new_map();
+    uint64_t hits = 0, misses = 0;
+    for (const auto& entry : DecodePipelinePool::Instance().Stats()) {
+        const auto& stats = entry.second;
+        hits += stats.hits;
+        misses += stats.misses;
+        FlValue* pool = fl_value_new_map();
+        fl_value_set_string_take(pool, "hits",
+            fl_value_new_int(static_cast<int64_t>(stats.hits)));
+        fl_value_set_string_take(pool, "misses",
+            fl_value_new_int(static_cast<int64_t>(stats.misses)));
+        fl_value_set_string_take(pool, "discarded",
+            fl_value_new_int(static_cast<int64_t>(stats.discarded)));
+        fl_value_set_string_take(pool, "idle",
+            fl_value_new_int(static_cast<int64_t>(stats.idle)));
+        fl_value_set_string_take(pools, entry.first.c_str(), pool);
     }
 
-    while (fl_value_get_length(list) < static_cast<size_t>(numberOfSamples)) {
-        fl_value_append_take(list, fl_value_new_float(0.0));
+    FlValue* pipelinePool = fl_value_new_map();
+    fl_value_set_string_take(pipelinePool, "hits",
+        fl_value_new_int(static_cast<int64_t>(hits)));
+    fl_value_set_string_take(pipelinePool, "misses",
+        fl_value_new_int(static_cast<int64_t>(misses)));
+    fl_value_set_string_take(pipelinePool, "pools", pools);
+
+    DecoderConfig config = CurrentConfig();
+    DecodeQueueLimits limits = config.queueLimits;
+    DecodeQueueStats queueStats;
+    {
+        std::lock_guard<std::mutex> lock(gQueueStatsMutex);
+        queueStats = gQueueStats;
+    }
+    FlValue* decodeQueue = fl_value_new_map();
+    fl_value_set_string_take(decodeQueue, "maxBuffers",
+        fl_value_new_int(limits.maxBuffers));
+    fl_value_set_string_take(decodeQueue, "maxBytes",
+        fl_value_new_int(static_cast<int64_t>(limits.maxBytes)));
+    fl_value_set_string_take(decodeQueue, "jobs",
+        fl_value_new_int(static_cast<int64_t>(queueStats.jobs)));
+    fl_value_set_string_take(decodeQueue, "overruns",
+        fl_value_new_int(static_cast<int64_t>(queueStats.overruns)));
+    fl_value_set_string_take(decodeQueue, "peakBuffers",
+        fl_value_new_int(queueStats.peakBuffers));
+    fl_value_set_string_take(decodeQueue, "peakBytes",
+        fl_value_new_int(static_cast<int64_t>(queueStats.peakBytes)));
+
+    FlValue* analysis = fl_value_new_map();
+    fl_value_set_string_take(analysis, "sampleRate",
+        fl_value_new_int(config.analysisSampleRate));
+    fl_value_set_string_take(analysis, "channels", fl_value_new_int(1));
+    fl_value_set_string_take(analysis, "kernel", fl_value_new_string(
+        audio_decoder::KernelIsaName(audio_decoder::DetectKernelIsa())));
+
+    WaveformCacheStats cacheStats;
+    {
+        std::lock_guard<std::mutex> lock(gWaveformCacheMutex);
+        cacheStats = gWaveformCacheStats;
     }
+    FlValue* waveformCache = fl_value_new_map();
+    fl_value_set_string_take(waveformCache, "enabled",
+        fl_value_new_bool(config.waveformCache));
+    fl_value_set_string_take(waveformCache, "hits",
+        fl_value_new_int(static_cast<int64_t>(cacheStats.hits)));
+    fl_value_set_string_take(waveformCache, "misses",
+        fl_value_new_int(static_cast<int64_t>(cacheStats.misses)));
+    fl_value_set_string_take(waveformCache, "writeFailures",
+        fl_value_new_int(static_cast<int64_t>(cacheStats.writeFailures)));
+
+    SegmentStats segmentStats;
+    {
+        std::lock_guard<std::mutex> lock(gSegmentStatsMutex);
+        segmentStats = gSegmentStats;
+    }
+    audio_decoder::WavWriterStats writerStats = WavFileWriter::Stats();
+    FlValue* wavWriter = fl_value_new_map();
+    fl_value_set_string_take(wavWriter, "files",
+        fl_value_new_int(static_cast<int64_t>(writerStats.files)));
+    fl_value_set_string_take(wavWriter, "bytes",
+        fl_value_new_int(static_cast<int64_t>(writerStats.bytes)));
+    fl_value_set_string_take(wavWriter, "writeCalls",
+        fl_value_new_int(static_cast<int64_t>(writerStats.writeCalls)));
+    fl_value_set_string_take(wavWriter, "writeCallsPerMB", fl_value_new_float(
+        writerStats.bytes > 0
+            ? writerStats.writeCalls * 1048576.0 / writerStats.bytes : 0.0));
+    fl_value_set_string_take(wavWriter, "writeMs",
+        fl_value_new_float(writerStats.writeMicros / 1000.0));
+    fl_value_set_string_take(wavWriter, "preallocatedBytes",
+        fl_value_new_int(static_cast<int64_t>(writerStats.preallocatedBytes)));
+    fl_value_set_string_take(wavWriter, "directFiles",
+        fl_value_new_int(static_cast<int64_t>(writerStats.directFiles)));
+
+    PassthroughStats passthroughStats;
+    {
+        std::lock_guard<std::mutex> lock(gPassthroughStatsMutex);
+        passthroughStats = gPassthroughStats;
+    }
+    FlValue* passthrough = fl_value_new_map();
+    fl_value_set_string_take(passthrough, "jobs",
+        fl_value_new_int(static_cast<int64_t>(passthroughStats.jobs)));
+    fl_value_set_string_take(passthrough, "bytes",
+        fl_value_new_int(static_cast<int64_t>(passthroughStats.bytes)));
+
+    FlValue* segmented = fl_value_new_map();
+    fl_value_set_string_take(segmented, "maxSegments",
+        fl_value_new_int(DecodeSegmentCount()));
+    fl_value_set_string_take(segmented, "jobs",
+        fl_value_new_int(static_cast<int64_t>(segmentStats.jobs)));
+    fl_value_set_string_take(segmented, "segments",
+        fl_value_new_int(static_cast<int64_t>(segmentStats.segments)));
+
+    audio_decoder::JobExecutorStats jobStats = JobExecutor::Instance().Stats();
+    uint64_t started = jobStats.completed + jobStats.running;
+    FlValue* executor = fl_value_new_map();
+    fl_value_set_string_take(executor, "workers",
+        fl_value_new_int(static_cast<int64_t>(jobStats.workers)));
+    fl_value_set_string_take(executor, "queued",
+        fl_value_new_int(static_cast<int64_t>(jobStats.queued)));
+    fl_value_set_string_take(executor, "peakQueued",
+        fl_value_new_int(static_cast<int64_t>(jobStats.peakQueued)));
+    fl_value_set_string_take(executor, "running",
+        fl_value_new_int(static_cast<int64_t>(jobStats.running)));
+    fl_value_set_string_take(executor, "submitted",
+        fl_value_new_int(static_cast<int64_t>(jobStats.submitted)));
+    fl_value_set_string_take(executor, "completed",
+        fl_value_new_int(static_cast<int64_t>(jobStats.completed)));
+    fl_value_set_string_take(executor, "steals",
+        fl_value_new_int(static_cast<int64_t>(jobStats.steals)));
+    fl_value_set_string_take(executor, "averageWaitMs", fl_value_new_float(
+        started > 0 ? jobStats.totalWaitUs / 1000.0 / started : 0.0));
+    fl_value_set_string_take(executor, "maxWaitMs",
+        fl_value_new_float(jobStats.maxWaitUs / 1000.0));
+
+    fl_value_set_string_take(executor, "cancellableJobs",
+        fl_value_new_int(static_cast<int64_t>(JobRegistry::Instance().active())));
+    fl_value_set_string_take(executor, "cancelled",
+        fl_value_new_int(static_cast<int64_t>(JobRegistry::Instance().cancelled())));
+
+    audio_decoder::MemorySourceStats memoryStats = MemorySource::Stats();
+    FlValue* memoryInput = fl_value_new_map();
+    fl_value_set_string_take(memoryInput, "inputs",
+        fl_value_new_int(static_cast<int64_t>(memoryStats.inputs)));
+    fl_value_set_string_take(memoryInput, "attached",
+        fl_value_new_int(static_cast<int64_t>(memoryStats.attached)));
+    fl_value_set_string_take(memoryInput, "bytesServed",
+        fl_value_new_int(static_cast<int64_t>(memoryStats.bytesServed)));
+
+    audio_decoder::ScratchStats scratchStats = ScratchFile::Stats();
+    FlValue* scratch = fl_value_new_map();
+    fl_value_set_string_take(scratch, "memoryFiles",
+        fl_value_new_int(static_cast<int64_t>(scratchStats.memoryFiles)));
+    fl_value_set_string_take(scratch, "diskFiles",
+        fl_value_new_int(static_cast<int64_t>(scratchStats.diskFiles)));
+    fl_value_set_string_take(scratch, "spilled",
+        fl_value_new_int(static_cast<int64_t>(scratchStats.spilled)));
+    fl_value_set_string_take(scratch, "memoryBytes",
+        fl_value_new_int(static_cast<int64_t>(scratchStats.memoryBytes)));
+    fl_value_set_string_take(scratch, "peakMemoryBytes",
+        fl_value_new_int(static_cast<int64_t>(scratchStats.peakMemoryBytes)));
+
+    audio_decoder::PcmStreamStats pcmStats = PcmStream::Stats();
+    FlValue* pcmStream = fl_value_new_map();
+    fl_value_set_string_take(pcmStream, "streams",
+        fl_value_new_int(static_cast<int64_t>(pcmStats.streams)));
+    fl_value_set_string_take(pcmStream, "chunks",
+        fl_value_new_int(static_cast<int64_t>(pcmStats.chunks)));
+    fl_value_set_string_take(pcmStream, "bytes",
+        fl_value_new_int(static_cast<int64_t>(pcmStats.bytes)));
+    fl_value_set_string_take(pcmStream, "stalls",
+        fl_value_new_int(static_cast<int64_t>(pcmStats.stalls)));
+    fl_value_set_string_take(pcmStream, "timeouts",
+        fl_value_new_int(static_cast<int64_t>(pcmStats.timeouts)));
+
+    audio_decoder::DiscovererPoolStats discovererStats =
+        DiscovererPool::Instance().Stats();
+    FlValue* infoProbe = fl_value_new_map();
+    fl_value_set_string_take(infoProbe, "timeoutMs",
+        fl_value_new_int(CurrentConfig().infoTimeoutMs));
+    fl_value_set_string_take(infoProbe, "discoverers",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.discoverers)));
+    fl_value_set_string_take(infoProbe, "discovered",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.discovered)));
+    fl_value_set_string_take(infoProbe, "failed",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.failed)));
+    fl_value_set_string_take(infoProbe, "timeouts",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.timeouts)));
+    fl_value_set_string_take(infoProbe, "cancelled",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.cancelled)));
+    fl_value_set_string_take(infoProbe, "inFlight",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.inFlight)));
+    fl_value_set_string_take(infoProbe, "peakInFlight",
+        fl_value_new_int(static_cast<int64_t>(discovererStats.peakInFlight)));
+
+    audio_decoder::HeaderProbeStats headerStats = HeaderProbe::Stats();
+    FlValue* headerProbe = fl_value_new_map();
+    fl_value_set_string_take(headerProbe, "recognized",
+        fl_value_new_int(static_cast<int64_t>(headerStats.recognized)));
+    fl_value_set_string_take(headerProbe, "unrecognized",
+        fl_value_new_int(static_cast<int64_t>(headerStats.unrecognized)));
+    fl_value_set_string_take(headerProbe, "averageMicros", fl_value_new_float(
+        headerStats.recognized > 0
+            ? static_cast<double>(headerStats.totalMicros) / headerStats.recognized
+            : 0.0));
+
+    audio_decoder::InfoCacheStats infoStats = gInfoCache.Stats();
+    FlValue* infoCache = fl_value_new_map();
+    fl_value_set_string_take(infoCache, "entries",
+        fl_value_new_int(static_cast<int64_t>(infoStats.entries)));
+    fl_value_set_string_take(infoCache, "capacity",
+        fl_value_new_int(static_cast<int64_t>(infoStats.capacity)));
+    fl_value_set_string_take(infoCache, "hits",
+        fl_value_new_int(static_cast<int64_t>(infoStats.hits)));
+    fl_value_set_string_take(infoCache, "misses",
+        fl_value_new_int(static_cast<int64_t>(infoStats.misses)));
+    fl_value_set_string_take(infoCache, "stale",
+        fl_value_new_int(static_cast<int64_t>(infoStats.stale)));
+    fl_value_set_string_take(infoCache, "evictions",
+        fl_value_new_int(static_cast<int64_t>(infoStats.evictions)));
+    uint64_t lookups = infoStats.hits + infoStats.misses;
+    fl_value_set_string_take(infoCache, "hitRate", fl_value_new_float(
+        lookups > 0 ? static_cast<double>(infoStats.hits) / lookups : 0.0));
 
-    return list;
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "pipelinePool", pipelinePool);
+    fl_value_set_string_take(map, "decodeQueue", decodeQueue);
+    fl_value_set_string_take(map, "analysis", analysis);
+    fl_value_set_string_take(map, "waveformCache", waveformCache);
+    fl_value_set_string_take(map, "segmentedDecode", segmented);
+    fl_value_set_string_take(map, "wavPassthrough", passthrough);
+    fl_value_set_string_take(map, "wavWriter", wavWriter);
+    fl_value_set_string_take(map, "executor", executor);
+    fl_value_set_string_take(map, "memoryInput", memoryInput);
+    fl_value_set_string_take(map, "scratch", scratch);
+    fl_value_set_string_take(map, "pcmStream", pcmStream);
+    fl_value_set_string_take(map, "infoProbe", infoProbe);
+    fl_value_set_string_take(map, "infoCache", infoCache);
+    fl_value_set_string_take(map, "headerProbe", headerProbe);
+    return map;
 }
 
 // ---------------------------------------------------------------------------
@@ -586,6 +1984,7 @@ static FlValue* GetWaveform(const std::string& path, int numberOfSamples) {
 struct _AudioDecoderPlugin {
     GObject parent_instance;
     FlMethodChannel* channel;
+    FlEventChannel* events;
 };
 
 G_DEFINE_TYPE(AudioDecoderPlugin, audio_decoder_plugin, g_object_get_type())
@@ -603,6 +2002,332 @@ static void send_error(FlMethodCall* method_call, const char* code,
     fl_method_call_respond(method_call, response, nullptr);
 }
 
+// ---------------------------------------------------------------------------
+// Progress events
+// ---------------------------------------------------------------------------
+
+/// The `audio_decoder/events` channel while Dart listens to it.  Only
+/// touched on the main thread, except for the listening flag.
+static FlEventChannel* gEventChannel = nullptr;
+static std::atomic<bool> gEventsListening{false};
+
+static gboolean send_event_on_main(gpointer data) {
+    if (gEventChannel && gEventsListening.load()) {
+        fl_event_channel_send(gEventChannel, static_cast<FlValue*>(data),
+                              nullptr, nullptr);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/// Sends [event] (taking ownership) from any thread; events are delivered
+/// in order on the main thread.
+static void PostEvent(FlValue* event) {
+    g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT, send_event_on_main,
+                               event, reinterpret_cast<GDestroyNotify>(fl_value_unref));
+}
+
+struct PendingResponse {
+    FlMethodCall* method_call;
+    FlMethodResponse* response;
+};
+
+static gboolean send_response_on_main(gpointer data) {
+    auto* pending = static_cast<PendingResponse*>(data);
+    fl_method_call_respond(pending->method_call, pending->response, nullptr);
+    return G_SOURCE_REMOVE;
+}
+
+static void free_pending_response(gpointer data) {
+    auto* pending = static_cast<PendingResponse*>(data);
+    g_object_unref(pending->response);
+    g_object_unref(pending->method_call);
+    delete pending;
+}
+
+/// Responds to [method_call] with [response] (taking ownership) from any
+/// thread.  The response joins the same main-loop queue as PostEvent, so
+/// Dart receives every event a job posted before it returned ahead of the
+/// result.
+static void PostResponse(FlMethodCall* method_call,
+                         FlMethodResponse* response) {
+    auto* pending = new PendingResponse{
+        FL_METHOD_CALL(g_object_ref(method_call)), response};
+    g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT,
+                               send_response_on_main, pending,
+                               free_pending_response);
+}
+
+static void PostProgressEvent(const std::string& jobId,
+                              const audio_decoder::ProgressSnapshot& snapshot) {
+    if (!gEventsListening.load()) return;
+    FlValue* event = fl_value_new_map();
+    fl_value_set_string_take(event, "type", fl_value_new_string("progress"));
+    fl_value_set_string_take(event, "jobId", fl_value_new_string(jobId.c_str()));
+    fl_value_set_string_take(event, "positionMs",
+        fl_value_new_int(static_cast<int64_t>(snapshot.positionNs / GST_MSECOND)));
+    fl_value_set_string_take(event, "durationMs", fl_value_new_int(
+        snapshot.durationNs > 0
+            ? static_cast<int64_t>(snapshot.durationNs / GST_MSECOND) : -1));
+    fl_value_set_string_take(event, "bytesWritten",
+        fl_value_new_int(static_cast<int64_t>(snapshot.bytesWritten)));
+    fl_value_set_string_take(event, "realTimeFactor",
+        fl_value_new_float(snapshot.realTimeFactor));
+    fl_value_set_string_take(event, "done", fl_value_new_bool(snapshot.done));
+    PostEvent(event);
+}
+
+static FlMethodErrorResponse* events_listen_cb(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+    gEventsListening = true;
+    return nullptr;
+}
+
+static FlMethodErrorResponse* events_cancel_cb(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+    gEventsListening = false;
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Batch conversion
+// ---------------------------------------------------------------------------
+
+struct BatchItem {
+    std::string inputPath;
+    std::string outputPath;
+    bool m4a = false;
+    int sampleRate = -1;
+    int channels = -1;
+    int bitDepth = -1;
+    WavSampleFormat sampleFormat = WavSampleFormat::kInteger;
+};
+
+/// Starts reading the head of [path] into the page cache in the background.
+static void PrefetchInput(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, kBatchReadAheadBytes, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+static FlValue* BatchItemResult(size_t index, const BatchItem& item,
+                                const std::string* error) {
+    FlValue* result = fl_value_new_map();
+    fl_value_set_string_take(result, "index",
+                             fl_value_new_int(static_cast<int64_t>(index)));
+    fl_value_set_string_take(result, "inputPath",
+                             fl_value_new_string(item.inputPath.c_str()));
+    fl_value_set_string_take(result, "outputPath",
+                             fl_value_new_string(item.outputPath.c_str()));
+    fl_value_set_string_take(result, "error",
+        error ? fl_value_new_string(error->c_str()) : fl_value_new_null());
+    return result;
+}
+
+/// Converts every item, spreading them over the executor's workers; items
+/// decode through the shared pipeline pool like single calls do.  A failing
+/// item does not stop the others.  With a [jobId], each item's result is
+/// also sent as a `batchItem` event as soon as it is done.
+static FlValue* ConvertBatch(const std::vector<BatchItem>& items,
+                             const std::string& jobId, CancelToken* cancel) {
+    std::vector<std::string> errors(items.size());
+    std::vector<uint8_t> failed(items.size(), 0);
+
+    // Items start roughly in order, one per worker, so the inputs due next
+    // are those [lanes] places past the one starting.
+    size_t lanes = std::max<size_t>(1, JobExecutor::Instance().Stats().workers)
+                   + kBatchReadAheadItems;
+    for (size_t i = 0; i < std::min(lanes, items.size()); i++) {
+        PrefetchInput(items[i].inputPath);
+    }
+
+    JobExecutor::Instance().ParallelFor(items.size(), [&](size_t index) {
+        if (index + lanes < items.size()) {
+            PrefetchInput(items[index + lanes].inputPath);
+        }
+        const BatchItem& item = items[index];
+        try {
+            ThrowIfCancelled(cancel);
+            if (item.m4a) {
+                ConvertToM4a(item.inputPath, item.outputPath, cancel);
+            } else {
+                ConvertToWav(item.inputPath, item.outputPath, item.sampleRate,
+                             item.channels, item.bitDepth, item.sampleFormat,
+                             cancel);
+            }
+        } catch (const std::exception& e) {
+            errors[index] = e.what();
+            failed[index] = 1;
+        }
+        if (!jobId.empty() && gEventsListening.load()) {
+            FlValue* event = BatchItemResult(
+                index, item, failed[index] ? &errors[index] : nullptr);
+            fl_value_set_string_take(event, "type",
+                                     fl_value_new_string("batchItem"));
+            fl_value_set_string_take(event, "jobId",
+                                     fl_value_new_string(jobId.c_str()));
+            PostEvent(event);
+        }
+    });
+    ThrowIfCancelled(cancel);
+
+    FlValue* results = fl_value_new_list();
+    int64_t failures = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (failed[i]) failures++;
+        fl_value_append_take(results, BatchItemResult(
+            i, items[i], failed[i] ? &errors[i] : nullptr));
+    }
+    FlValue* result = fl_value_new_map();
+    fl_value_set_string_take(result, "items", results);
+    fl_value_set_string_take(result, "failed", fl_value_new_int(failures));
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// PCM streaming
+// ---------------------------------------------------------------------------
+
+/// Streams started by `decodeStream`, by job ID, so that `requestPcmChunks`
+/// can grant them credits.  Only touched on the main thread, except for
+/// the removal when a stream's job is destroyed.
+static std::mutex gPcmStreamsMutex;
+static std::map<std::string, std::shared_ptr<PcmStream>> gPcmStreams;
+
+static FlValue* NewPcmEvent(const char* type, const std::string& jobId) {
+    FlValue* event = fl_value_new_map();
+    fl_value_set_string_take(event, "type", fl_value_new_string(type));
+    fl_value_set_string_take(event, "jobId", fl_value_new_string(jobId.c_str()));
+    return event;
+}
+
+/// Throws the reason [stream] stopped accepting chunks.
+[[noreturn]] static void ThrowIfStreamClosed(const PcmStream& stream,
+                                             CancelToken* cancel) {
+    ThrowIfCancelled(cancel);
+    if (stream.timedOut()) {
+        throw std::runtime_error(
+            "PCM stream listener stayed paused past the stream pause timeout");
+    }
+    throw std::runtime_error("PCM stream was closed");
+}
+
+/// Decodes [inputPath] through [stream], whose sink sends `pcm` events.
+/// The chunks are preceded by a `pcmFormat` event and followed by a
+/// `pcmEnd` event.  A cancel also wakes a decode waiting for credit, and a
+/// decode left waiting past the stream's credit timeout fails.
+static FlValue* DecodeStream(const std::string& inputPath,
+                             const DecodeOptions& options,
+                             const std::string& jobId, PcmStream& stream) {
+    CancelToken::Hook closeHook = options.cancel
+        ? options.cancel->OnCancel([&stream]() { stream.Close(); })
+        : CancelToken::Hook();
+    PcmInfo info = DecodeToPcmStream(inputPath, options,
+        [&](const PcmChunk& chunk) {
+            if (!stream.Push(chunk.data(), chunk.size())) {
+                ThrowIfStreamClosed(stream, options.cancel);
+            }
+        },
+        [&](const PcmInfo& format, int64_t) {
+            stream.SetFrameSize(format.channels * format.bitsPerSample / 8);
+            FlValue* event = NewPcmEvent("pcmFormat", jobId);
+            fl_value_set_string_take(event, "sampleRate",
+                                     fl_value_new_int(format.sampleRate));
+            fl_value_set_string_take(event, "channels",
+                                     fl_value_new_int(format.channels));
+            fl_value_set_string_take(event, "bitsPerSample",
+                                     fl_value_new_int(format.bitsPerSample));
+            fl_value_set_string_take(event, "float", fl_value_new_bool(
+                format.format == GST_AUDIO_FORMAT_F32LE));
+            PostEvent(event);
+        });
+    if (!stream.Flush()) ThrowIfStreamClosed(stream, options.cancel);
+    if (info.sampleRate == 0) throw std::runtime_error("No audio data decoded");
+    PostEvent(NewPcmEvent("pcmEnd", jobId));
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Jobs
+// ---------------------------------------------------------------------------
+
+/// What a job started by SubmitJob can observe and report to.
+struct JobHandle {
+    /// Empty unless the call passed a `jobId`.
+    const std::string& jobId;
+    CancelToken* cancel;
+    /// Set only for calls with a `jobId`, since events are keyed by it.
+    JobProgress* progress;
+};
+
+/// Runs [job] on the executor and responds with the value it returns, or
+/// with [errorCode] if it throws.  A `jobId` argument registers the job so
+/// that `cancel` can stop it and progress events name it; a cancelled job
+/// responds with CANCELLED.  Jobs that can wait on Dart for as long as it
+/// likes pass [ownThread] to run outside the executor, so that they never
+/// hold a worker that queued calls need; their callers bound how many run
+/// at once.
+static void SubmitJob(FlMethodCall* method_call, const char* errorCode,
+                      std::function<FlValue*(const JobHandle&)> job,
+                      bool ownThread = false) {
+    FlValue* args = fl_method_call_get_args(method_call);
+    FlValue* idVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+        ? fl_value_lookup_string(args, "jobId") : nullptr;
+    std::string jobId;
+    if (idVal && fl_value_get_type(idVal) == FL_VALUE_TYPE_STRING)
+        jobId = fl_value_get_string(idVal);
+    std::shared_ptr<CancelToken> token = JobRegistry::Instance().Register(jobId);
+    if (!token) {
+        send_error(method_call, "INVALID_ARGUMENTS",
+                   ("Job " + jobId + " is already running").c_str());
+        return;
+    }
+
+    g_object_ref(method_call);
+    std::function<void()> run = [method_call, errorCode, jobId, token,
+                                 job = std::move(job)]() mutable {
+        std::unique_ptr<JobProgress> progress;
+        if (!jobId.empty()) {
+            progress = std::make_unique<JobProgress>(
+                [jobId](const audio_decoder::ProgressSnapshot& snapshot) {
+                    PostProgressEvent(jobId, snapshot);
+                },
+                std::chrono::milliseconds(CurrentConfig().progressIntervalMs));
+        }
+        g_autoptr(FlValue) result = nullptr;
+        const char* code = nullptr;
+        std::string message;
+        try {
+            // Jobs cancelled while queued never start.
+            token->ThrowIfCancelled();
+            result = job(JobHandle{jobId, token.get(), progress.get()});
+        } catch (const JobCancelledError& e) {
+            code = "CANCELLED";
+            message = e.what();
+        } catch (const std::exception& e) {
+            code = errorCode;
+            message = e.what();
+        }
+        // The final event is queued before the result, and the ID and
+        // whatever the job holds are free again once Dart sees the result.
+        job = nullptr;
+        if (progress) progress->Finish();
+        JobRegistry::Instance().Unregister(jobId);
+        PostResponse(method_call, code
+            ? FL_METHOD_RESPONSE(fl_method_error_response_new(
+                  code, message.c_str(), nullptr))
+            : FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+        g_object_unref(method_call);
+    };
+    if (ownThread) {
+        std::thread(std::move(run)).detach();
+    } else {
+        JobExecutor::Instance().Submit(std::move(run));
+    }
+}
+
 static void handle_method_call(AudioDecoderPlugin* self,
                                FlMethodCall* method_call) {
     const gchar* method = fl_method_call_get_name(method_call);
@@ -634,18 +2359,12 @@ static void handle_method_call(AudioDecoderPlugin* self,
         FlValue* bdVal = fl_value_lookup_string(args, "bitDepth");
         if (bdVal && fl_value_get_type(bdVal) == FL_VALUE_TYPE_INT)
             targetBitDepth = static_cast<int>(fl_value_get_int(bdVal));
+        WavSampleFormat sampleFormat = SampleFormatArg(args);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputPath, outputPath, targetSampleRate, targetChannels, targetBitDepth]() {
-            try {
-                std::string result = ConvertToWav(inputPath, outputPath, targetSampleRate, targetChannels, targetBitDepth);
-                g_autoptr(FlValue) val = fl_value_new_string(result.c_str());
-                send_success(method_call, val);
-            } catch (const std::exception& e) {
-                send_error(method_call, "CONVERSION_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "CONVERSION_ERROR", [inputPath, outputPath, targetSampleRate, targetChannels, targetBitDepth, sampleFormat](const JobHandle& job) {
+            std::string result = ConvertToWav(inputPath, outputPath, targetSampleRate, targetChannels, targetBitDepth, sampleFormat, job.cancel, job.progress);
+            return fl_value_new_string(result.c_str());
+        });
 
     // ---- convertToM4a ----
     } else if (strcmp(method, "convertToM4a") == 0) {
@@ -663,17 +2382,10 @@ static void handle_method_call(AudioDecoderPlugin* self,
         std::string inputPath = fl_value_get_string(inputVal);
         std::string outputPath = fl_value_get_string(outputVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputPath, outputPath]() {
-            try {
-                std::string result = ConvertToM4a(inputPath, outputPath);
-                g_autoptr(FlValue) val = fl_value_new_string(result.c_str());
-                send_success(method_call, val);
-            } catch (const std::exception& e) {
-                send_error(method_call, "CONVERSION_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "CONVERSION_ERROR", [inputPath, outputPath](const JobHandle& job) {
+            std::string result = ConvertToM4a(inputPath, outputPath, job.cancel, job.progress);
+            return fl_value_new_string(result.c_str());
+        });
 
     // ---- getAudioInfo ----
     } else if (strcmp(method, "getAudioInfo") == 0) {
@@ -688,16 +2400,31 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         std::string path = fl_value_get_string(pathVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, path]() {
-            try {
-                g_autoptr(FlValue) info = GetAudioInfo(path);
-                send_success(method_call, info);
-            } catch (const std::exception& e) {
-                send_error(method_call, "INFO_ERROR", e.what());
+        SubmitJob(method_call, "INFO_ERROR", [path](const JobHandle&) {
+            return GetAudioInfo(path);
+        });
+
+    // ---- getAudioInfoBatch ----
+    } else if (strcmp(method, "getAudioInfoBatch") == 0) {
+        FlValue* pathsVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "paths") : nullptr;
+        if (!pathsVal || fl_value_get_type(pathsVal) != FL_VALUE_TYPE_LIST) {
+            send_error(method_call, "INVALID_ARGUMENTS", "paths list is required");
+            return;
+        }
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < fl_value_get_length(pathsVal); i++) {
+            FlValue* pathVal = fl_value_get_list_value(pathsVal, i);
+            if (fl_value_get_type(pathVal) != FL_VALUE_TYPE_STRING) {
+                send_error(method_call, "INVALID_ARGUMENTS", "paths must be strings");
+                return;
             }
-            g_object_unref(method_call);
-        }).detach();
+            paths.push_back(fl_value_get_string(pathVal));
+        }
+
+        SubmitJob(method_call, "INFO_ERROR", [paths](const JobHandle& job) {
+            return GetAudioInfoBatch(paths, job.cancel);
+        });
 
     // ---- trimAudio ----
     } else if (strcmp(method, "trimAudio") == 0) {
@@ -719,18 +2446,12 @@ static void handle_method_call(AudioDecoderPlugin* self,
         int64_t startMs = fl_value_get_int(startVal);
         int64_t endMs = fl_value_get_int(endVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputPath, outputPath, startMs, endMs]() {
-            try {
-                std::string result =
-                    TrimAudio(inputPath, outputPath, startMs, endMs);
-                g_autoptr(FlValue) val = fl_value_new_string(result.c_str());
-                send_success(method_call, val);
-            } catch (const std::exception& e) {
-                send_error(method_call, "TRIM_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "TRIM_ERROR", [inputPath, outputPath, startMs, endMs](const JobHandle& job) {
+            std::string result =
+                TrimAudio(inputPath, outputPath, startMs, endMs, job.cancel,
+                          job.progress);
+            return fl_value_new_string(result.c_str());
+        });
 
     // ---- getWaveform ----
     } else if (strcmp(method, "getWaveform") == 0) {
@@ -747,17 +2468,18 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         std::string path = fl_value_get_string(pathVal);
         int numberOfSamples = static_cast<int>(fl_value_get_int(samplesVal));
+        int64_t startMs = -1, endMs = -1;
+        FlValue* startVal = fl_value_lookup_string(args, "startMs");
+        if (startVal && fl_value_get_type(startVal) == FL_VALUE_TYPE_INT)
+            startMs = fl_value_get_int(startVal);
+        FlValue* endVal = fl_value_lookup_string(args, "endMs");
+        if (endVal && fl_value_get_type(endVal) == FL_VALUE_TYPE_INT)
+            endMs = fl_value_get_int(endVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, path, numberOfSamples]() {
-            try {
-                g_autoptr(FlValue) waveform = GetWaveform(path, numberOfSamples);
-                send_success(method_call, waveform);
-            } catch (const std::exception& e) {
-                send_error(method_call, "WAVEFORM_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "WAVEFORM_ERROR", [path, numberOfSamples, startMs, endMs](const JobHandle& job) {
+            return GetWaveform(path, numberOfSamples, startMs, endMs, true,
+                               job.cancel);
+        });
 
     // ---- convertToWavBytes ----
     } else if (strcmp(method, "convertToWavBytes") == 0) {
@@ -774,7 +2496,6 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         const uint8_t* rawData = fl_value_get_uint8_list(dataVal);
         size_t dataLen = fl_value_get_length(dataVal);
-        std::vector<uint8_t> inputData(rawData, rawData + dataLen);
         std::string formatHint = fl_value_get_string(hintVal);
 
         int targetSampleRate = -1, targetChannels = -1, targetBitDepth = -1;
@@ -787,38 +2508,20 @@ static void handle_method_call(AudioDecoderPlugin* self,
         FlValue* bdVal = fl_value_lookup_string(args, "bitDepth");
         if (bdVal && fl_value_get_type(bdVal) == FL_VALUE_TYPE_INT)
             targetBitDepth = static_cast<int>(fl_value_get_int(bdVal));
+        WavSampleFormat sampleFormat = SampleFormatArg(args);
 
         bool includeHeader = true;
         FlValue* headerVal = fl_value_lookup_string(args, "includeHeader");
         if (headerVal && fl_value_get_type(headerVal) == FL_VALUE_TYPE_BOOL)
             includeHeader = fl_value_get_bool(headerVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputData = std::move(inputData), formatHint, targetSampleRate, targetChannels, targetBitDepth, includeHeader]() {
-            try {
-                std::string tempInput = WriteTempFile(inputData, formatHint);
-                std::string tempOutput = WriteTempFile({}, "wav");
-                try {
-                    ConvertToWav(tempInput, tempOutput, targetSampleRate, targetChannels, targetBitDepth);
-                    auto outputBytes = ReadAndDeleteFile(tempOutput);
-                    std::remove(tempInput.c_str());
-                    // Strip the WAV header to return raw PCM.
-                    if (!includeHeader && outputBytes.size() >= kWavHeaderSize) {
-                        outputBytes.erase(outputBytes.begin(), outputBytes.begin() + kWavHeaderSize);
-                    }
-                    g_autoptr(FlValue) val = fl_value_new_uint8_list(
-                        outputBytes.data(), outputBytes.size());
-                    send_success(method_call, val);
-                } catch (...) {
-                    std::remove(tempInput.c_str());
-                    std::remove(tempOutput.c_str());
-                    throw;
-                }
-            } catch (const std::exception& e) {
-                send_error(method_call, "CONVERSION_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "CONVERSION_ERROR", [method_call, rawData, dataLen, formatHint, targetSampleRate, targetChannels, targetBitDepth, sampleFormat, includeHeader](const JobHandle& job) {
+            MemorySource input(rawData, dataLen, G_OBJECT(method_call), formatHint);
+            return DecodeToWavBytes(input.uri(), -1, -1, targetSampleRate,
+                                    targetChannels, targetBitDepth,
+                                    sampleFormat, includeHeader, job.cancel,
+                                    job.progress);
+        });
 
     // ---- convertToM4aBytes ----
     } else if (strcmp(method, "convertToM4aBytes") == 0) {
@@ -835,31 +2538,13 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         const uint8_t* rawData = fl_value_get_uint8_list(dataVal);
         size_t dataLen = fl_value_get_length(dataVal);
-        std::vector<uint8_t> inputData(rawData, rawData + dataLen);
         std::string formatHint = fl_value_get_string(hintVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputData = std::move(inputData), formatHint]() {
-            try {
-                std::string tempInput = WriteTempFile(inputData, formatHint);
-                std::string tempOutput = WriteTempFile({}, "m4a");
-                try {
-                    ConvertToM4a(tempInput, tempOutput);
-                    auto outputBytes = ReadAndDeleteFile(tempOutput);
-                    std::remove(tempInput.c_str());
-                    g_autoptr(FlValue) val = fl_value_new_uint8_list(
-                        outputBytes.data(), outputBytes.size());
-                    send_success(method_call, val);
-                } catch (...) {
-                    std::remove(tempInput.c_str());
-                    std::remove(tempOutput.c_str());
-                    throw;
-                }
-            } catch (const std::exception& e) {
-                send_error(method_call, "CONVERSION_ERROR", e.what());
-            }
-            g_object_unref(method_call);
-        }).detach();
+        SubmitJob(method_call, "CONVERSION_ERROR", [method_call, rawData, dataLen, formatHint](const JobHandle& job) {
+            MemorySource input(rawData, dataLen, G_OBJECT(method_call), formatHint);
+            return EncodeToM4aBytes(input.uri(), -1, -1, dataLen, job.cancel,
+                                    job.progress);
+        });
 
     // ---- getAudioInfoBytes ----
     } else if (strcmp(method, "getAudioInfoBytes") == 0) {
@@ -876,26 +2561,16 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         const uint8_t* rawData = fl_value_get_uint8_list(dataVal);
         size_t dataLen = fl_value_get_length(dataVal);
-        std::vector<uint8_t> inputData(rawData, rawData + dataLen);
         std::string formatHint = fl_value_get_string(hintVal);
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputData = std::move(inputData), formatHint]() {
-            try {
-                std::string tempInput = WriteTempFile(inputData, formatHint);
-                try {
-                    g_autoptr(FlValue) info = GetAudioInfo(tempInput);
-                    std::remove(tempInput.c_str());
-                    send_success(method_call, info);
-                } catch (...) {
-                    std::remove(tempInput.c_str());
-                    throw;
-                }
-            } catch (const std::exception& e) {
-                send_error(method_call, "INFO_ERROR", e.what());
+        SubmitJob(method_call, "INFO_ERROR", [method_call, rawData, dataLen, formatHint](const JobHandle&) {
+            AudioInfoRecord record;
+            if (HeaderProbe::ProbeMemory(rawData, dataLen, &record)) {
+                return AudioInfoMap(record);
             }
-            g_object_unref(method_call);
-        }).detach();
+            MemorySource input(rawData, dataLen, G_OBJECT(method_call), formatHint);
+            return GetAudioInfo(input.uri());
+        });
 
     // ---- trimAudioBytes ----
     } else if (strcmp(method, "trimAudioBytes") == 0) {
@@ -914,7 +2589,6 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         const uint8_t* rawData = fl_value_get_uint8_list(dataVal);
         size_t dataLen = fl_value_get_length(dataVal);
-        std::vector<uint8_t> inputData(rawData, rawData + dataLen);
         std::string formatHint = fl_value_get_string(hintVal);
         int64_t startMs = fl_value_get_int(startVal);
         int64_t endMs = fl_value_get_int(endVal);
@@ -924,29 +2598,17 @@ static void handle_method_call(AudioDecoderPlugin* self,
             (fmtVal && fl_value_get_type(fmtVal) == FL_VALUE_TYPE_STRING)
                 ? fl_value_get_string(fmtVal) : "wav";
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputData = std::move(inputData), formatHint,
-                     startMs, endMs, outputFormat]() {
-            try {
-                std::string tempInput = WriteTempFile(inputData, formatHint);
-                std::string tempOutput = WriteTempFile({}, outputFormat);
-                try {
-                    TrimAudio(tempInput, tempOutput, startMs, endMs);
-                    auto outputBytes = ReadAndDeleteFile(tempOutput);
-                    std::remove(tempInput.c_str());
-                    g_autoptr(FlValue) val = fl_value_new_uint8_list(
-                        outputBytes.data(), outputBytes.size());
-                    send_success(method_call, val);
-                } catch (...) {
-                    std::remove(tempInput.c_str());
-                    std::remove(tempOutput.c_str());
-                    throw;
-                }
-            } catch (const std::exception& e) {
-                send_error(method_call, "TRIM_ERROR", e.what());
+        SubmitJob(method_call, "TRIM_ERROR", [method_call, rawData, dataLen, formatHint,
+                     startMs, endMs, outputFormat](const JobHandle& job) {
+            MemorySource input(rawData, dataLen, G_OBJECT(method_call), formatHint);
+            if (outputFormat == "m4a") {
+                return EncodeToM4aBytes(input.uri(), startMs, endMs, dataLen,
+                                        job.cancel, job.progress);
             }
-            g_object_unref(method_call);
-        }).detach();
+            return DecodeToWavBytes(input.uri(), startMs, endMs, -1, -1, -1,
+                                    WavSampleFormat::kInteger, true,
+                                    job.cancel, job.progress);
+        });
 
     // ---- getWaveformBytes ----
     } else if (strcmp(method, "getWaveformBytes") == 0) {
@@ -964,29 +2626,264 @@ static void handle_method_call(AudioDecoderPlugin* self,
         }
         const uint8_t* rawData = fl_value_get_uint8_list(dataVal);
         size_t dataLen = fl_value_get_length(dataVal);
-        std::vector<uint8_t> inputData(rawData, rawData + dataLen);
         std::string formatHint = fl_value_get_string(hintVal);
         int numberOfSamples = static_cast<int>(fl_value_get_int(samplesVal));
 
-        g_object_ref(method_call);
-        std::thread([method_call, inputData = std::move(inputData), formatHint,
-                     numberOfSamples]() {
-            try {
-                std::string tempInput = WriteTempFile(inputData, formatHint);
-                try {
-                    g_autoptr(FlValue) waveform =
-                        GetWaveform(tempInput, numberOfSamples);
-                    std::remove(tempInput.c_str());
-                    send_success(method_call, waveform);
-                } catch (...) {
-                    std::remove(tempInput.c_str());
-                    throw;
-                }
-            } catch (const std::exception& e) {
-                send_error(method_call, "WAVEFORM_ERROR", e.what());
+        SubmitJob(method_call, "WAVEFORM_ERROR", [method_call, rawData, dataLen, formatHint,
+                     numberOfSamples](const JobHandle& job) {
+            MemorySource input(rawData, dataLen, G_OBJECT(method_call), formatHint);
+            // In-memory input has no file to key a sidecar on.
+            return GetWaveform(input.uri(), numberOfSamples, -1, -1, false,
+                               job.cancel);
+        });
+
+    // ---- convertBatch ----
+    } else if (strcmp(method, "convertBatch") == 0) {
+        FlValue* itemsVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "items") : nullptr;
+        if (!itemsVal || fl_value_get_type(itemsVal) != FL_VALUE_TYPE_LIST) {
+            send_error(method_call, "INVALID_ARGUMENTS", "items list is required");
+            return;
+        }
+        std::vector<BatchItem> items;
+        for (size_t i = 0; i < fl_value_get_length(itemsVal); i++) {
+            FlValue* itemVal = fl_value_get_list_value(itemsVal, i);
+            FlValue* inputVal = fl_value_get_type(itemVal) == FL_VALUE_TYPE_MAP
+                ? fl_value_lookup_string(itemVal, "inputPath") : nullptr;
+            FlValue* outputVal = inputVal
+                ? fl_value_lookup_string(itemVal, "outputPath") : nullptr;
+            if (!inputVal || !outputVal ||
+                fl_value_get_type(inputVal) != FL_VALUE_TYPE_STRING ||
+                fl_value_get_type(outputVal) != FL_VALUE_TYPE_STRING) {
+                send_error(method_call, "INVALID_ARGUMENTS",
+                           "Every item needs inputPath and outputPath");
+                return;
             }
-            g_object_unref(method_call);
-        }).detach();
+            BatchItem item;
+            item.inputPath = fl_value_get_string(inputVal);
+            item.outputPath = fl_value_get_string(outputVal);
+            FlValue* formatVal = fl_value_lookup_string(itemVal, "format");
+            item.m4a = formatVal && fl_value_get_type(formatVal) == FL_VALUE_TYPE_STRING &&
+                       strcmp(fl_value_get_string(formatVal), "m4a") == 0;
+            FlValue* srVal = fl_value_lookup_string(itemVal, "sampleRate");
+            if (srVal && fl_value_get_type(srVal) == FL_VALUE_TYPE_INT)
+                item.sampleRate = static_cast<int>(fl_value_get_int(srVal));
+            FlValue* chVal = fl_value_lookup_string(itemVal, "channels");
+            if (chVal && fl_value_get_type(chVal) == FL_VALUE_TYPE_INT)
+                item.channels = static_cast<int>(fl_value_get_int(chVal));
+            FlValue* bdVal = fl_value_lookup_string(itemVal, "bitDepth");
+            if (bdVal && fl_value_get_type(bdVal) == FL_VALUE_TYPE_INT)
+                item.bitDepth = static_cast<int>(fl_value_get_int(bdVal));
+            item.sampleFormat = SampleFormatArg(itemVal);
+            items.push_back(std::move(item));
+        }
+
+        SubmitJob(method_call, "CONVERSION_ERROR", [items = std::move(items)](const JobHandle& job) {
+            return ConvertBatch(items, job.jobId, job.cancel);
+        });
+
+    // ---- decodeStream ----
+    } else if (strcmp(method, "decodeStream") == 0) {
+        if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+            send_error(method_call, "INVALID_ARGUMENTS", "Arguments map is required");
+            return;
+        }
+        FlValue* inputVal = fl_value_lookup_string(args, "inputPath");
+        FlValue* idVal = fl_value_lookup_string(args, "jobId");
+        if (!inputVal || fl_value_get_type(inputVal) != FL_VALUE_TYPE_STRING ||
+            !idVal || fl_value_get_type(idVal) != FL_VALUE_TYPE_STRING) {
+            send_error(method_call, "INVALID_ARGUMENTS",
+                       "inputPath and jobId are required");
+            return;
+        }
+        std::string inputPath = fl_value_get_string(inputVal);
+        std::string jobId = fl_value_get_string(idVal);
+
+        DecodeOptions options;
+        FlValue* srVal = fl_value_lookup_string(args, "sampleRate");
+        if (srVal && fl_value_get_type(srVal) == FL_VALUE_TYPE_INT)
+            options.sampleRate = static_cast<int>(fl_value_get_int(srVal));
+        FlValue* chVal = fl_value_lookup_string(args, "channels");
+        if (chVal && fl_value_get_type(chVal) == FL_VALUE_TYPE_INT)
+            options.channels = static_cast<int>(fl_value_get_int(chVal));
+        FlValue* formatVal = fl_value_lookup_string(args, "format");
+        if (formatVal && fl_value_get_type(formatVal) == FL_VALUE_TYPE_STRING)
+            options.floatSamples = strcmp(fl_value_get_string(formatVal), "f32") == 0;
+        FlValue* startVal = fl_value_lookup_string(args, "startMs");
+        if (startVal && fl_value_get_type(startVal) == FL_VALUE_TYPE_INT)
+            options.startMs = fl_value_get_int(startVal);
+        FlValue* endVal = fl_value_lookup_string(args, "endMs");
+        if (endVal && fl_value_get_type(endVal) == FL_VALUE_TYPE_INT)
+            options.endMs = fl_value_get_int(endVal);
+        size_t chunkBytes = kDefaultPcmChunkBytes;
+        FlValue* chunkVal = fl_value_lookup_string(args, "chunkBytes");
+        if (chunkVal && fl_value_get_type(chunkVal) == FL_VALUE_TYPE_INT &&
+            fl_value_get_int(chunkVal) > 0)
+            chunkBytes = static_cast<size_t>(fl_value_get_int(chunkVal));
+
+        auto stream = std::make_shared<PcmStream>(chunkBytes,
+            std::chrono::milliseconds(CurrentConfig().streamPauseTimeoutMs),
+            [jobId](const uint8_t* data, size_t size, uint64_t frameOffset) {
+                FlValue* event = NewPcmEvent("pcm", jobId);
+                fl_value_set_string_take(event, "data",
+                                         fl_value_new_uint8_list(data, size));
+                fl_value_set_string_take(event, "frameOffset",
+                    fl_value_new_int(static_cast<int64_t>(frameOffset)));
+                PostEvent(event);
+            });
+        FlValue* creditsVal = fl_value_lookup_string(args, "credits");
+        if (creditsVal && fl_value_get_type(creditsVal) == FL_VALUE_TYPE_INT)
+            stream->Grant(static_cast<uint64_t>(
+                std::max<int64_t>(0, fl_value_get_int(creditsVal))));
+        {
+            std::lock_guard<std::mutex> lock(gPcmStreamsMutex);
+            if (gPcmStreams.size() >= kMaxPcmStreams) {
+                send_error(method_call, "DECODE_ERROR",
+                           ("At most " + std::to_string(kMaxPcmStreams) +
+                            " decode streams can run at once").c_str());
+                return;
+            }
+            if (!gPcmStreams.emplace(jobId, stream).second) {
+                send_error(method_call, "INVALID_ARGUMENTS",
+                           ("Job " + jobId + " is already running").c_str());
+                return;
+            }
+        }
+        // Unregisters the stream once the job is gone, whether it ran or
+        // SubmitJob turned it down.
+        std::shared_ptr<void> registration(nullptr,
+            [jobId, key = stream.get()](void*) {
+                std::lock_guard<std::mutex> lock(gPcmStreamsMutex);
+                auto it = gPcmStreams.find(jobId);
+                if (it != gPcmStreams.end() && it->second.get() == key)
+                    gPcmStreams.erase(it);
+            });
+
+        // The decode blocks while the listener is paused, so it gets its own
+        // thread rather than one of the maxConcurrentJobs workers; the
+        // kMaxPcmStreams check above bounds those threads.
+        SubmitJob(method_call, "DECODE_ERROR", [inputPath, options, jobId, stream, registration](const JobHandle& job) {
+            DecodeOptions jobOptions = options;
+            jobOptions.cancel = job.cancel;
+            jobOptions.progress = job.progress;
+            return DecodeStream(inputPath, jobOptions, jobId, *stream);
+        }, true);
+
+    // ---- requestPcmChunks ----
+    } else if (strcmp(method, "requestPcmChunks") == 0) {
+        FlValue* idVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "jobId") : nullptr;
+        FlValue* countVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "count") : nullptr;
+        if (!idVal || fl_value_get_type(idVal) != FL_VALUE_TYPE_STRING ||
+            !countVal || fl_value_get_type(countVal) != FL_VALUE_TYPE_INT) {
+            send_error(method_call, "INVALID_ARGUMENTS", "jobId and count are required");
+            return;
+        }
+        std::shared_ptr<PcmStream> stream;
+        {
+            std::lock_guard<std::mutex> lock(gPcmStreamsMutex);
+            auto it = gPcmStreams.find(fl_value_get_string(idVal));
+            if (it != gPcmStreams.end()) stream = it->second;
+        }
+        if (stream) {
+            stream->Grant(static_cast<uint64_t>(
+                std::max<int64_t>(0, fl_value_get_int(countVal))));
+        }
+        g_autoptr(FlValue) found = fl_value_new_bool(stream != nullptr);
+        send_success(method_call, found);
+
+    // ---- cancel ----
+    } else if (strcmp(method, "cancel") == 0) {
+        FlValue* idVal = fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "jobId") : nullptr;
+        if (!idVal || fl_value_get_type(idVal) != FL_VALUE_TYPE_STRING) {
+            send_error(method_call, "INVALID_ARGUMENTS", "jobId is required");
+            return;
+        }
+        g_autoptr(FlValue) found = fl_value_new_bool(
+            JobRegistry::Instance().Cancel(fl_value_get_string(idVal)));
+        send_success(method_call, found);
+
+    // ---- configure ----
+    } else if (strcmp(method, "configure") == 0) {
+        if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+            send_error(method_call, "INVALID_ARGUMENTS", "Arguments map is required");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(gConfigMutex);
+            FlValue* buffersVal = fl_value_lookup_string(args, "maxQueuedBuffers");
+            if (buffersVal && fl_value_get_type(buffersVal) == FL_VALUE_TYPE_INT)
+                gConfig.queueLimits.maxBuffers = static_cast<guint>(
+                    std::max<int64_t>(0, fl_value_get_int(buffersVal)));
+            FlValue* bytesVal = fl_value_lookup_string(args, "maxQueuedBytes");
+            if (bytesVal && fl_value_get_type(bytesVal) == FL_VALUE_TYPE_INT)
+                gConfig.queueLimits.maxBytes = static_cast<guint64>(
+                    std::max<int64_t>(0, fl_value_get_int(bytesVal)));
+            FlValue* rateVal = fl_value_lookup_string(args, "waveformSampleRate");
+            if (rateVal && fl_value_get_type(rateVal) == FL_VALUE_TYPE_INT &&
+                fl_value_get_int(rateVal) > 0)
+                gConfig.analysisSampleRate =
+                    static_cast<int>(fl_value_get_int(rateVal));
+            FlValue* segmentsVal = fl_value_lookup_string(args, "decodeSegments");
+            if (segmentsVal && fl_value_get_type(segmentsVal) == FL_VALUE_TYPE_INT)
+                gConfig.decodeSegments = static_cast<int>(
+                    std::max<int64_t>(0, fl_value_get_int(segmentsVal)));
+            FlValue* cacheVal = fl_value_lookup_string(args, "waveformCache");
+            if (cacheVal && fl_value_get_type(cacheVal) == FL_VALUE_TYPE_BOOL)
+                gConfig.waveformCache = fl_value_get_bool(cacheVal);
+            FlValue* intervalVal = fl_value_lookup_string(args, "progressIntervalMs");
+            if (intervalVal && fl_value_get_type(intervalVal) == FL_VALUE_TYPE_INT)
+                gConfig.progressIntervalMs = static_cast<int>(
+                    std::max<int64_t>(0, fl_value_get_int(intervalVal)));
+            FlValue* jobsVal = fl_value_lookup_string(args, "maxConcurrentJobs");
+            if (jobsVal && fl_value_get_type(jobsVal) == FL_VALUE_TYPE_INT) {
+                gConfig.maxConcurrentJobs = static_cast<int>(
+                    std::max<int64_t>(0, fl_value_get_int(jobsVal)));
+                JobExecutor::Instance().SetWorkerCount(
+                    static_cast<size_t>(gConfig.maxConcurrentJobs));
+            }
+            FlValue* scratchDirVal = fl_value_lookup_string(args, "scratchDirectory");
+            if (scratchDirVal && fl_value_get_type(scratchDirVal) == FL_VALUE_TYPE_STRING)
+                gConfig.scratch.spillDirectory = fl_value_get_string(scratchDirVal);
+            FlValue* scratchBytesVal = fl_value_lookup_string(args, "scratchMemoryBytes");
+            if (scratchBytesVal && fl_value_get_type(scratchBytesVal) == FL_VALUE_TYPE_INT)
+                gConfig.scratch.memoryBudget = static_cast<uint64_t>(
+                    std::max<int64_t>(0, fl_value_get_int(scratchBytesVal)));
+            ScratchFile::Configure(gConfig.scratch);
+            FlValue* preallocateVal = fl_value_lookup_string(args, "wavPreallocate");
+            if (preallocateVal && fl_value_get_type(preallocateVal) == FL_VALUE_TYPE_BOOL)
+                gConfig.wavWriter.preallocate = fl_value_get_bool(preallocateVal);
+            FlValue* directIoVal = fl_value_lookup_string(args, "wavDirectIo");
+            if (directIoVal && fl_value_get_type(directIoVal) == FL_VALUE_TYPE_BOOL)
+                gConfig.wavWriter.directIo = fl_value_get_bool(directIoVal);
+            WavFileWriter::Configure(gConfig.wavWriter);
+            FlValue* cacheEntriesVal = fl_value_lookup_string(args, "infoCacheEntries");
+            if (cacheEntriesVal && fl_value_get_type(cacheEntriesVal) == FL_VALUE_TYPE_INT)
+                gInfoCache.SetCapacity(static_cast<size_t>(
+                    std::max<int64_t>(0, fl_value_get_int(cacheEntriesVal))));
+            FlValue* cacheFileVal = fl_value_lookup_string(args, "infoCacheFile");
+            if (cacheFileVal && fl_value_get_type(cacheFileVal) == FL_VALUE_TYPE_STRING)
+                gInfoCache.SetIndexFile(fl_value_get_string(cacheFileVal));
+            FlValue* pauseVal = fl_value_lookup_string(args, "streamPauseTimeoutMs");
+            if (pauseVal && fl_value_get_type(pauseVal) == FL_VALUE_TYPE_INT)
+                gConfig.streamPauseTimeoutMs = static_cast<int>(
+                    std::max<int64_t>(0, fl_value_get_int(pauseVal)));
+            FlValue* infoTimeoutVal = fl_value_lookup_string(args, "infoTimeoutMs");
+            if (infoTimeoutVal && fl_value_get_type(infoTimeoutVal) == FL_VALUE_TYPE_INT &&
+                fl_value_get_int(infoTimeoutVal) > 0) {
+                gConfig.infoTimeoutMs = static_cast<int>(fl_value_get_int(infoTimeoutVal));
+                DiscovererPool::Instance().SetTimeout(
+                    static_cast<GstClockTime>(gConfig.infoTimeoutMs) * GST_MSECOND);
+            }
+        }
+        send_success(method_call, nullptr);
+
+    // ---- getDecoderStats ----
+    } else if (strcmp(method, "getDecoderStats") == 0) {
+        g_autoptr(FlValue) stats = GetDecoderStats();
+        send_success(method_call, stats);
 
     } else {
         g_autoptr(FlMethodResponse) response =
@@ -1002,6 +2899,13 @@ static void handle_method_call(AudioDecoderPlugin* self,
 static void audio_decoder_plugin_dispose(GObject* object) {
     AudioDecoderPlugin* self = AUDIO_DECODER_PLUGIN(object);
     g_clear_object(&self->channel);
+    if (gEventChannel == self->events) {
+        gEventsListening = false;
+        gEventChannel = nullptr;
+    }
+    g_clear_object(&self->events);
+    DecodePipelinePool::Instance().Clear();
+    gInfoCache.Flush();
     G_OBJECT_CLASS(audio_decoder_plugin_parent_class)->dispose(object);
 }
 
@@ -1032,5 +2936,13 @@ void audio_decoder_plugin_register_with_registrar(
     fl_method_channel_set_method_call_handler(
         plugin->channel, method_call_cb, g_object_ref(plugin), g_object_unref);
 
+    // Progress of jobs started with a jobId.
+    plugin->events = fl_event_channel_new(
+        fl_plugin_registrar_get_messenger(registrar), "audio_decoder/events",
+        FL_METHOD_CODEC(codec));
+    fl_event_channel_set_stream_handlers(plugin->events, events_listen_cb,
+                                         events_cancel_cb, nullptr, nullptr);
+    gEventChannel = plugin->events;
+
     g_object_unref(plugin);
 }
@@ -0,0 +1,234 @@
+#include "decode_pipeline_pool.h"
+
+#include "memory_source.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace audio_decoder {
+
+// ---------------------------------------------------------------------------
+// Lease
+// ---------------------------------------------------------------------------
+
+DecodePipelinePool::Lease::~Lease() {
+    if (pool_ && pipeline_) {
+        pool_->Release(std::move(pipeline_), reusable_);
+    }
+}
+
+DecodePipelinePool::Lease& DecodePipelinePool::Lease::operator=(
+        Lease&& other) noexcept {
+    if (this != &other) {
+        if (pool_ && pipeline_) {
+            pool_->Release(std::move(pipeline_), reusable_);
+        }
+        pool_ = other.pool_;
+        pipeline_ = std::move(other.pipeline_);
+        reusable_ = other.reusable_;
+    }
+    return *this;
+}
+
+// ---------------------------------------------------------------------------
+// Pipeline construction
+// ---------------------------------------------------------------------------
+
+/// Links the first audio pad exposed by uridecodebin to audioconvert.
+static void OnDecodedPadAdded(GstElement* /*decodebin*/, GstPad* pad,
+                              gpointer userData) {
+    GstElement* convert = static_cast<GstElement*>(userData);
+    GstPad* sinkPad = gst_element_get_static_pad(convert, "sink");
+    if (!sinkPad) return;
+
+    if (!gst_pad_is_linked(sinkPad)) {
+        GstCaps* caps = gst_pad_get_current_caps(pad);
+        if (!caps) caps = gst_pad_query_caps(pad, nullptr);
+        bool isAudio = false;
+        if (caps && gst_caps_get_size(caps) > 0) {
+            const gchar* name =
+                gst_structure_get_name(gst_caps_get_structure(caps, 0));
+            isAudio = g_str_has_prefix(name, "audio/");
+        }
+        if (caps) gst_caps_unref(caps);
+        if (isAudio) {
+            gst_pad_link(pad, sinkPad);
+        }
+    }
+    gst_object_unref(sinkPad);
+}
+
+void LinkDecodedAudioPads(GstElement* decodebin, GstElement* convert) {
+    g_signal_connect(decodebin, "pad-added", G_CALLBACK(OnDecodedPadAdded),
+                     convert);
+}
+
+/// Counts the moments the queue is full and the decoder has to wait.
+static void OnQueueOverrun(GstElement* /*queue*/, gpointer userData) {
+    static_cast<DecodePipeline*>(userData)->overruns++;
+}
+
+void SetQueueLimits(DecodePipeline* pipeline, const DecodeQueueLimits& limits) {
+    // Byte and buffer limits are enforced by the queue; appsink keeps at most
+    // one extra sample so it does not become a second unbounded buffer.
+    g_object_set(pipeline->queue,
+                 "max-size-buffers", limits.maxBuffers,
+                 "max-size-bytes", static_cast<guint>(
+                     std::min<guint64>(limits.maxBytes, G_MAXUINT)),
+                 nullptr);
+    g_object_set(pipeline->sink, "max-buffers", limits.bounded() ? 1u : 0u,
+                 "drop", FALSE, nullptr);
+}
+
+std::unique_ptr<DecodePipeline> DecodePipelinePool::Build(
+        const std::string& caps) {
+    auto result = std::make_unique<DecodePipeline>();
+    result->caps = caps;
+
+    GstElement* pipeline = gst_pipeline_new(nullptr);
+    GstElement* source = gst_element_factory_make("uridecodebin", nullptr);
+    GstElement* convert = gst_element_factory_make("audioconvert", nullptr);
+    GstElement* resample = gst_element_factory_make("audioresample", nullptr);
+    GstElement* filter = gst_element_factory_make("capsfilter", nullptr);
+    GstElement* queue = gst_element_factory_make("queue", nullptr);
+    GstElement* sink = gst_element_factory_make("appsink", nullptr);
+
+    if (!pipeline || !source || !convert || !resample || !filter || !queue ||
+            !sink) {
+        for (GstElement* e : {source, convert, resample, filter, queue, sink}) {
+            if (e) gst_object_unref(e);
+        }
+        if (pipeline) gst_object_unref(pipeline);
+        throw std::runtime_error(
+            "Failed to create pipeline: missing GStreamer element");
+    }
+
+    GstCaps* filterCaps = gst_caps_from_string(caps.c_str());
+    if (!filterCaps) {
+        for (GstElement* e : {source, convert, resample, filter, queue, sink}) {
+            gst_object_unref(e);
+        }
+        gst_object_unref(pipeline);
+        throw std::runtime_error("Failed to create pipeline: invalid caps " + caps);
+    }
+    g_object_set(filter, "caps", filterCaps, nullptr);
+    gst_caps_unref(filterCaps);
+
+    g_object_set(sink, "emit-signals", FALSE, "sync", FALSE,
+                 "max-buffers", 0, nullptr);
+    g_object_set(queue, "max-size-buffers", 0, "max-size-bytes", 0,
+                 "max-size-time", static_cast<guint64>(0), "leaky", 0, nullptr);
+    g_signal_connect(queue, "overrun", G_CALLBACK(OnQueueOverrun),
+                     result.get());
+
+    gst_bin_add_many(GST_BIN(pipeline), source, convert, resample, filter,
+                     queue, sink, nullptr);
+    if (!gst_element_link_many(convert, resample, filter, queue, sink,
+                               nullptr)) {
+        gst_object_unref(pipeline);
+        throw std::runtime_error("Failed to link decode pipeline");
+    }
+    LinkDecodedAudioPads(source, convert);
+    g_signal_connect(source, "source-setup",
+                     G_CALLBACK(MemorySource::OnSourceSetup), nullptr);
+
+    result->pipeline = pipeline;
+    result->source = source;
+    result->convert = convert;
+    result->queue = queue;
+    result->sink = sink;
+    return result;
+}
+
+void DecodePipelinePool::Destroy(DecodePipeline* pipeline) {
+    if (!pipeline || !pipeline->pipeline) return;
+    gst_element_set_state(pipeline->pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline->pipeline);
+    pipeline->pipeline = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Pool
+// ---------------------------------------------------------------------------
+
+DecodePipelinePool& DecodePipelinePool::Instance() {
+    static DecodePipelinePool* instance = new DecodePipelinePool();
+    return *instance;
+}
+
+DecodePipelinePool::Lease DecodePipelinePool::Acquire(const std::string& caps) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& idle = idle_[caps];
+        if (!idle.empty()) {
+            std::unique_ptr<DecodePipeline> pipeline = std::move(idle.back());
+            idle.pop_back();
+            stats_[caps].hits++;
+            return Lease(this, std::move(pipeline));
+        }
+        stats_[caps].misses++;
+    }
+    return Lease(this, Build(caps));
+}
+
+void DecodePipelinePool::Release(std::unique_ptr<DecodePipeline> pipeline,
+                                 bool reusable) {
+    if (reusable) {
+        // READY drops uridecodebin's source and decoders, unlinking its pads,
+        // so the next user can set a new URI and autoplug from scratch.
+        if (gst_element_set_state(pipeline->pipeline, GST_STATE_READY) ==
+                GST_STATE_CHANGE_FAILURE) {
+            reusable = false;
+        }
+    }
+
+    if (reusable) {
+        // Errors can leave elements in a state that READY does not clear,
+        // so only pipelines that finished cleanly go back into the pool.
+        GstBus* bus = gst_element_get_bus(pipeline->pipeline);
+        GstMessage* error = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+        if (error) {
+            gst_message_unref(error);
+            reusable = false;
+        }
+        // Drop whatever the previous run left on the bus.
+        gst_bus_set_flushing(bus, TRUE);
+        gst_bus_set_flushing(bus, FALSE);
+        gst_object_unref(bus);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& idle = idle_[pipeline->caps];
+        if (reusable && idle.size() < kMaxIdlePerCaps) {
+            idle.push_back(std::move(pipeline));
+            return;
+        }
+        stats_[pipeline->caps].discarded++;
+    }
+    Destroy(pipeline.get());
+}
+
+std::map<std::string, PipelinePoolStats> DecodePipelinePool::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, PipelinePoolStats> result = stats_;
+    for (const auto& entry : idle_) {
+        result[entry.first].idle = entry.second.size();
+    }
+    return result;
+}
+
+void DecodePipelinePool::Clear() {
+    std::map<std::string, std::vector<std::unique_ptr<DecodePipeline>>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle.swap(idle_);
+    }
+    for (auto& entry : idle) {
+        for (auto& pipeline : entry.second) {
+            Destroy(pipeline.get());
+        }
+    }
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,124 @@
+#ifndef FLUTTER_PLUGIN_DECODE_PIPELINE_POOL_H_
+#define FLUTTER_PLUGIN_DECODE_PIPELINE_POOL_H_
+
+#include <gst/gst.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audio_decoder {
+
+/// A decode pipeline assembled element by element:
+///
+///   uridecodebin ! audioconvert ! audioresample ! capsfilter ! queue ! appsink
+///
+/// uridecodebin's source pads are linked to audioconvert as streams are
+/// autoplugged, so the same pipeline can be pointed at a new URI once it has
+/// been brought back to READY.  The queue in front of appsink bounds how far
+/// the streaming thread may decode ahead of the consumer (see SetQueueLimits).
+struct DecodePipeline {
+    GstElement* pipeline = nullptr;
+    GstElement* source = nullptr;   // uridecodebin
+    GstElement* convert = nullptr;  // audioconvert
+    GstElement* queue = nullptr;    // queue
+    GstElement* sink = nullptr;     // appsink
+    std::string caps;
+
+    /// Times the queue filled up and blocked the streaming thread.
+    std::atomic<uint64_t> overruns{0};
+};
+
+/// Links the first audio pad that [decodebin] (a uridecodebin) exposes to the
+/// sink pad of [convert].  Used by every pipeline that autoplugs its input.
+void LinkDecodedAudioPads(GstElement* decodebin, GstElement* convert);
+
+/// Limits on decoded data held between the decoder and the consumer.
+/// A value of 0 leaves that dimension unbounded; both 0 restores the old
+/// unbounded appsink behaviour.
+struct DecodeQueueLimits {
+    guint maxBuffers = 0;
+    guint64 maxBytes = 0;
+
+    bool bounded() const { return maxBuffers > 0 || maxBytes > 0; }
+};
+
+/// Applies [limits] to a pipeline's queue and appsink.  The queue never
+/// leaks, so a full queue blocks the decoder instead of dropping data.
+void SetQueueLimits(DecodePipeline* pipeline, const DecodeQueueLimits& limits);
+
+/// Hit/miss counters for the pipelines sharing one output caps string.
+struct PipelinePoolStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t discarded = 0;
+    size_t idle = 0;
+};
+
+/// Process-wide pool of pre-built decode pipelines keyed by output caps.
+///
+/// Acquire() hands out an idle pipeline for the requested caps (a hit) or
+/// builds a new one (a miss).  When the lease goes out of scope the pipeline
+/// is reset to READY and parked for the next caller, unless it reported an
+/// error or was explicitly discarded, in which case it is torn down.
+class DecodePipelinePool {
+ public:
+    class Lease {
+     public:
+        Lease() = default;
+        Lease(DecodePipelinePool* pool, std::unique_ptr<DecodePipeline> pipeline)
+            : pool_(pool), pipeline_(std::move(pipeline)) {}
+        ~Lease();
+
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        DecodePipeline* operator->() const { return pipeline_.get(); }
+        explicit operator bool() const { return pipeline_ != nullptr; }
+
+        /// Prevents the pipeline from being returned to the pool.
+        void Discard() { reusable_ = false; }
+
+     private:
+        DecodePipelinePool* pool_ = nullptr;
+        std::unique_ptr<DecodePipeline> pipeline_;
+        bool reusable_ = true;
+    };
+
+    static DecodePipelinePool& Instance();
+
+    /// Returns a READY pipeline whose capsfilter is set to [caps].
+    /// Throws std::runtime_error if a required element is missing.
+    Lease Acquire(const std::string& caps);
+
+    /// Snapshot of the counters for every caps key seen so far.
+    std::map<std::string, PipelinePoolStats> Stats() const;
+
+    /// Tears down all idle pipelines.
+    void Clear();
+
+ private:
+    /// Idle pipelines kept per caps key; extras are destroyed on release.
+    static constexpr size_t kMaxIdlePerCaps = 4;
+
+    DecodePipelinePool() = default;
+
+    void Release(std::unique_ptr<DecodePipeline> pipeline, bool reusable);
+
+    static std::unique_ptr<DecodePipeline> Build(const std::string& caps);
+    static void Destroy(DecodePipeline* pipeline);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<std::unique_ptr<DecodePipeline>>> idle_;
+    std::map<std::string, PipelinePoolStats> stats_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_DECODE_PIPELINE_POOL_H_
@@ -0,0 +1,216 @@
+#include "discoverer_pool.h"
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+#include "memory_source.h"
+
+namespace audio_decoder {
+
+static constexpr GstClockTime kDefaultTimeout = 5 * GST_SECOND;
+
+DiscovererPool& DiscovererPool::Instance() {
+    // Intentionally leaked, like the loop thread it owns.
+    static DiscovererPool* instance = new DiscovererPool();
+    return *instance;
+}
+
+DiscovererPool::DiscovererPool()
+    : context_(g_main_context_new()),
+      loop_(g_main_loop_new(context_, FALSE)),
+      maxSlots_(std::max(1u, std::thread::hardware_concurrency())),
+      timeout_(kDefaultTimeout) {
+    // Async discoverers deliver their results on the thread-default context
+    // of the thread that starts them, which is this one.
+    thread_ = std::thread([this]() {
+        g_main_context_push_thread_default(context_);
+        g_main_loop_run(loop_);
+        g_main_context_pop_thread_default(context_);
+    });
+    thread_.detach();
+}
+
+void DiscovererPool::Discover(const std::string& uri, Callback done,
+                              Cancelled cancelled) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.inFlight++;
+        stats_.peakInFlight = std::max(stats_.peakInFlight, stats_.inFlight);
+    }
+    auto* request = new Request{uri, std::move(done), std::move(cancelled)};
+    g_main_context_invoke_full(context_, G_PRIORITY_DEFAULT, DispatchOnLoop,
+                               request, nullptr);
+}
+
+GstDiscovererInfo* DiscovererPool::DiscoverSync(const std::string& uri) {
+    std::promise<GstDiscovererInfo*> result;
+    Discover(uri, [&result](GstDiscovererInfo* info, const std::string& error) {
+        if (info) {
+            result.set_value(gst_discoverer_info_ref(info));
+        } else {
+            result.set_exception(
+                std::make_exception_ptr(std::runtime_error(error)));
+        }
+    });
+    return result.get_future().get();
+}
+
+void DiscovererPool::SetTimeout(GstClockTime timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ = timeout;
+    for (auto& slot : slots_) {
+        g_object_set(slot->discoverer, "timeout", timeout, nullptr);
+    }
+}
+
+DiscovererPoolStats DiscovererPool::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+gboolean DiscovererPool::DispatchOnLoop(gpointer data) {
+    std::unique_ptr<Request> request(static_cast<Request*>(data));
+    Instance().Dispatch(std::move(*request));
+    return G_SOURCE_REMOVE;
+}
+
+void DiscovererPool::Dispatch(Request request) {
+    queue_.push_back(std::move(request));
+    StartQueued();
+}
+
+void DiscovererPool::StartQueued() {
+    while (!queue_.empty()) {
+        Request request = std::move(queue_.front());
+        queue_.pop_front();
+        if (request.cancelled && request.cancelled()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.inFlight--;
+                stats_.cancelled++;
+            }
+            request.done(nullptr, "Cancelled");
+            continue;
+        }
+
+        Slot* slot = nullptr;
+        bool grow = false, none = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& candidate : slots_) {
+                if (!candidate->busy) {
+                    slot = candidate.get();
+                    break;
+                }
+            }
+            grow = !slot && slots_.size() < maxSlots_;
+            none = slots_.empty();
+        }
+        if (grow) slot = CreateSlot();
+        if (!slot && none) {
+            Finish(std::move(request), nullptr, "Failed to create discoverer",
+                   GST_DISCOVERER_ERROR);
+            continue;
+        }
+        if (!slot) {
+            // Every discoverer is busy; the next result starts this one.
+            queue_.push_front(std::move(request));
+            return;
+        }
+
+        std::string uri = request.uri;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slot->busy = true;
+            slot->current = std::move(request);
+        }
+        if (!gst_discoverer_discover_uri_async(slot->discoverer, uri.c_str())) {
+            Request failed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                slot->busy = false;
+                failed = std::move(slot->current);
+            }
+            Finish(std::move(failed), nullptr, "Failed to queue " + uri,
+                   GST_DISCOVERER_ERROR);
+        }
+    }
+}
+
+void DiscovererPool::Finish(Request request, GstDiscovererInfo* info,
+                            const std::string& error,
+                            GstDiscovererResult result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.inFlight--;
+        if (info) stats_.discovered++;
+        else stats_.failed++;
+        if (result == GST_DISCOVERER_TIMEOUT) stats_.timeouts++;
+    }
+    request.done(info, error);
+}
+
+DiscovererPool::Slot* DiscovererPool::CreateSlot() {
+    GstClockTime timeout;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timeout = timeout_;
+    }
+    GstDiscoverer* discoverer = gst_discoverer_new(timeout, nullptr);
+    if (!discoverer) return nullptr;
+    auto slot = std::make_unique<Slot>();
+    slot->pool = this;
+    slot->discoverer = discoverer;
+    g_signal_connect(discoverer, "discovered", G_CALLBACK(OnDiscovered),
+                     slot.get());
+    g_signal_connect(discoverer, "source-setup", G_CALLBACK(OnSourceSetup),
+                     slot.get());
+    gst_discoverer_start(discoverer);
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.push_back(std::move(slot));
+    stats_.discoverers++;
+    return slots_.back().get();
+}
+
+void DiscovererPool::OnDiscovered(GstDiscoverer* discoverer,
+                                  GstDiscovererInfo* info, GError* error,
+                                  gpointer data) {
+    auto* slot = static_cast<Slot*>(data);
+    DiscovererPool* pool = slot->pool;
+    GstDiscovererResult result =
+        info ? gst_discoverer_info_get_result(info) : GST_DISCOVERER_ERROR;
+    bool failed = error || !info || result == GST_DISCOVERER_TIMEOUT;
+
+    Request request;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        if (!slot->busy) return;
+        slot->busy = false;
+        request = std::move(slot->current);
+    }
+
+    if (!failed) {
+        pool->Finish(std::move(request), info, std::string(), result);
+    } else {
+        pool->Finish(std::move(request), nullptr,
+                     error ? error->message
+                           : result == GST_DISCOVERER_TIMEOUT
+                                 ? "Timed out" : "Unknown error",
+                     result);
+    }
+    pool->StartQueued();
+}
+
+void DiscovererPool::OnSourceSetup(GstDiscoverer* discoverer,
+                                   GstElement* source, gpointer data) {
+    auto* slot = static_cast<Slot*>(data);
+    std::string uri;
+    {
+        std::lock_guard<std::mutex> lock(slot->pool->mutex_);
+        if (slot->busy) uri = slot->current.uri;
+    }
+    if (MemorySource::IsMemoryUri(uri)) MemorySource::Attach(uri, source);
+}
+
+}  // namespace audio_decoder
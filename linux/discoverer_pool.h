@@ -0,0 +1,117 @@
+#ifndef FLUTTER_PLUGIN_DISCOVERER_POOL_H_
+#define FLUTTER_PLUGIN_DISCOVERER_POOL_H_
+
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace audio_decoder {
+
+struct DiscovererPoolStats {
+    /// Discoverers created; they are kept for the life of the process.
+    uint64_t discoverers = 0;
+    uint64_t discovered = 0;
+    uint64_t failed = 0;
+    uint64_t timeouts = 0;
+    /// Requests dropped unprobed because their caller had given up.
+    uint64_t cancelled = 0;
+    /// URIs queued or being probed, now and at most.
+    size_t inFlight = 0;
+    size_t peakInFlight = 0;
+};
+
+/// Long-lived GstDiscoverers running in async mode on a private main loop.
+///
+/// Setting up a discoverer costs more than probing a typical local file, so
+/// discoverers are created on demand, up to one per core, and reused for
+/// every later request.  Each one is given a single URI at a time and the
+/// rest wait in the pool's queue, so a batch keeps all of them working and
+/// requests given up on while queued are never probed.
+/// `appsrc://` URIs of live MemorySources are fed like in the decode
+/// pipelines.
+class DiscovererPool {
+ public:
+    /// Receives [info] (NULL on failure, then [error] says why).  Runs on the
+    /// pool's thread and must not block; [info] is only valid during the
+    /// call.
+    using Callback = std::function<void(GstDiscovererInfo* info,
+                                        const std::string& error)>;
+
+    static DiscovererPool& Instance();
+
+    /// Returns true once the caller no longer wants the result.
+    using Cancelled = std::function<bool()>;
+
+    /// Queues [uri] and returns at once.  If [cancelled] returns true when
+    /// the request reaches the front of the queue, [done] gets a
+    /// "Cancelled" error without the URI being probed.
+    void Discover(const std::string& uri, Callback done,
+                  Cancelled cancelled = nullptr);
+
+    /// Probes [uri] and waits for the result.  Returns a new reference;
+    /// throws std::runtime_error on failure.
+    GstDiscovererInfo* DiscoverSync(const std::string& uri);
+
+    /// Time allowed for one URI, applied to all discoverers.
+    void SetTimeout(GstClockTime timeout);
+
+    DiscovererPoolStats Stats() const;
+
+ private:
+    struct Request {
+        std::string uri;
+        Callback done;
+        Cancelled cancelled;
+    };
+    struct Slot {
+        DiscovererPool* pool;
+        GstDiscoverer* discoverer;
+        bool busy = false;
+        /// The request being probed while [busy].
+        Request current;
+    };
+
+    DiscovererPool();
+
+    /// Pool thread: queues [request] and starts what idle discoverers can.
+    void Dispatch(Request request);
+    /// Pool thread: hands queued requests to idle discoverers, creating
+    /// them up to the limit, and drops cancelled ones on the way.
+    void StartQueued();
+    /// Completes [request] with [info] or [error] and counts the outcome.
+    void Finish(Request request, GstDiscovererInfo* info,
+                const std::string& error, GstDiscovererResult result);
+    Slot* CreateSlot();
+
+    static gboolean DispatchOnLoop(gpointer data);
+    static void OnDiscovered(GstDiscoverer* discoverer, GstDiscovererInfo* info,
+                             GError* error, gpointer slot);
+    static void OnSourceSetup(GstDiscoverer* discoverer, GstElement* source,
+                              gpointer slot);
+
+    GMainContext* context_;
+    GMainLoop* loop_;
+    std::thread thread_;
+    const size_t maxSlots_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    /// Requests waiting for an idle discoverer; only touched on the pool
+    /// thread.
+    std::deque<Request> queue_;
+    GstClockTime timeout_;
+    DiscovererPoolStats stats_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_DISCOVERER_POOL_H_
@@ -0,0 +1,656 @@
+#include "header_probe.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace audio_decoder {
+
+static std::atomic<uint64_t> gRecognized{0};
+static std::atomic<uint64_t> gUnrecognized{0};
+static std::atomic<uint64_t> gTotalMicros{0};
+
+/// Bytes read up front; every recognized header starts within them.
+static constexpr size_t kHeadBytes = 4096;
+/// How far past an ID3v2 tag the first MP3 frame is searched for.
+static constexpr size_t kMp3SyncWindow = 4096;
+/// Bound on the chunks, blocks and boxes walked in one file.
+static constexpr int kMaxSteps = 256;
+
+namespace {
+
+/// Random access to the input being probed.
+class Reader {
+ public:
+    virtual ~Reader() = default;
+    virtual uint64_t size() const = 0;
+    /// Copies up to [n] bytes at [offset] to [out]; returns how many.
+    virtual size_t ReadAt(uint64_t offset, uint8_t* out, size_t n) const = 0;
+
+    bool ReadExact(uint64_t offset, uint8_t* out, size_t n) const {
+        return ReadAt(offset, out, n) == n;
+    }
+};
+
+class FileReader : public Reader {
+ public:
+    FileReader(int fd, uint64_t size) : fd_(fd), size_(size) {}
+    uint64_t size() const override { return size_; }
+    size_t ReadAt(uint64_t offset, uint8_t* out, size_t n) const override {
+        size_t done = 0;
+        while (done < n) {
+            ssize_t got = pread(fd_, out + done, n - done,
+                                static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) break;
+            done += static_cast<size_t>(got);
+        }
+        return done;
+    }
+
+ private:
+    int fd_;
+    uint64_t size_;
+};
+
+class MemoryReader : public Reader {
+ public:
+    MemoryReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    uint64_t size() const override { return size_; }
+    size_t ReadAt(uint64_t offset, uint8_t* out, size_t n) const override {
+        if (offset >= size_) return 0;
+        size_t count = static_cast<size_t>(
+            std::min<uint64_t>(n, size_ - offset));
+        memcpy(out, data_ + offset, count);
+        return count;
+    }
+
+ private:
+    const uint8_t* data_;
+    size_t size_;
+};
+
+uint16_t Le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+uint32_t Le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+uint64_t Le64(const uint8_t* p) {
+    return Le32(p) | static_cast<uint64_t>(Le32(p + 4)) << 32;
+}
+uint16_t Be16(const uint8_t* p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+uint32_t Be24(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 16 |
+           static_cast<uint32_t>(p[1]) << 8 | p[2];
+}
+uint32_t Be32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | Be24(p + 1);
+}
+uint64_t Be64(const uint8_t* p) {
+    return static_cast<uint64_t>(Be32(p)) << 32 | Be32(p + 4);
+}
+
+bool Tag(const uint8_t* p, const char* fourcc) {
+    return memcmp(p, fourcc, 4) == 0;
+}
+
+int32_t ClampBitRate(double bitsPerSecond) {
+    if (!(bitsPerSecond > 0)) return 0;
+    return static_cast<int32_t>(std::min(bitsPerSecond, 2147483647.0));
+}
+
+bool Finish(AudioInfoRecord* record, const char* format, uint32_t sampleRate,
+            uint32_t channels, uint64_t frames, double bitRate) {
+    if (sampleRate == 0 || channels == 0) return false;
+    record->durationMs = static_cast<int64_t>(frames * 1000 / sampleRate);
+    record->sampleRate = static_cast<int32_t>(sampleRate);
+    record->channels = static_cast<int32_t>(channels);
+    record->bitRate = ClampBitRate(bitRate);
+    record->format = format;
+    return true;
+}
+
+// ---- WAV / RF64 ----
+
+/// Reads the format and data chunk of a WAV file; [formatTag] is that of
+/// the subformat for WAVE_FORMAT_EXTENSIBLE.
+bool ParseWav(const Reader& in, bool rf64, uint16_t* formatTag,
+              WavLayout* layout) {
+    uint64_t pos = 12;
+    uint64_t ds64DataSize = 0;
+    bool haveFormat = false;
+    for (int step = 0; step < kMaxSteps && pos + 8 <= in.size(); step++) {
+        uint8_t chunk[8];
+        if (!in.ReadExact(pos, chunk, 8)) return false;
+        uint32_t length = Le32(chunk + 4);
+        if (Tag(chunk, "fmt ")) {
+            uint8_t fmt[40] = {};
+            size_t want = std::min<uint32_t>(length, sizeof(fmt));
+            if (want < 16 || !in.ReadExact(pos + 8, fmt, want)) return false;
+            *formatTag = Le16(fmt);
+            layout->channels = Le16(fmt + 2);
+            layout->sampleRate = Le32(fmt + 4);
+            layout->blockAlign = Le16(fmt + 12);
+            layout->bitsPerSample = Le16(fmt + 14);
+            // WAVE_FORMAT_EXTENSIBLE: the real tag opens the subformat GUID.
+            if (*formatTag == 0xFFFE && want >= 26) *formatTag = Le16(fmt + 24);
+            haveFormat = true;
+        } else if (Tag(chunk, "ds64")) {
+            uint8_t ds64[16];
+            if (length < 16 || !in.ReadExact(pos + 8, ds64, 16)) return false;
+            ds64DataSize = Le64(ds64 + 8);
+        } else if (Tag(chunk, "data")) {
+            if (!haveFormat || layout->sampleRate == 0 ||
+                layout->blockAlign == 0) {
+                return false;
+            }
+            uint64_t dataSize = rf64 && length == 0xFFFFFFFF ? ds64DataSize
+                                                             : length;
+            // Writers that stream leave the size unset or too large.
+            layout->dataOffset = pos + 8;
+            layout->dataSize = std::min(dataSize, in.size() - (pos + 8));
+            return true;
+        }
+        pos += 8 + static_cast<uint64_t>(length) + (length & 1);
+    }
+    return false;
+}
+
+bool ProbeWav(const Reader& in, bool rf64, AudioInfoRecord* record) {
+    uint16_t formatTag = 0;
+    WavLayout layout;
+    if (!ParseWav(in, rf64, &formatTag, &layout)) return false;
+    // Integer PCM and IEEE float decode to raw audio; anything else (ADPCM,
+    // MP3 in WAV, ...) is left to the discoverer.
+    if (formatTag != 1 && formatTag != 3) return false;
+    return Finish(record, "wav", layout.sampleRate, layout.channels,
+                  layout.dataSize / layout.blockAlign,
+                  static_cast<double>(layout.sampleRate) * layout.channels *
+                      layout.bitsPerSample);
+}
+
+// ---- AIFF / AIFC ----
+
+/// Converts an 80-bit IEEE 754 extended float, as AIFF stores rates.
+double Extended(const uint8_t* p) {
+    int exponent = Be16(p) & 0x7FFF;
+    uint64_t mantissa = Be64(p + 2);
+    if (exponent == 0 && mantissa == 0) return 0;
+    double value = std::ldexp(static_cast<double>(mantissa), exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+bool ProbeAiff(const Reader& in, bool aifc, AudioInfoRecord* record) {
+    uint64_t pos = 12;
+    for (int step = 0; step < kMaxSteps && pos + 8 <= in.size(); step++) {
+        uint8_t chunk[8];
+        if (!in.ReadExact(pos, chunk, 8)) return false;
+        uint32_t length = Be32(chunk + 4);
+        if (Tag(chunk, "COMM")) {
+            uint8_t comm[22];
+            size_t want = aifc ? 22 : 18;
+            if (length < want || !in.ReadExact(pos + 8, comm, want)) return false;
+            uint16_t channels = Be16(comm);
+            uint32_t frames = Be32(comm + 2);
+            uint16_t bits = Be16(comm + 6);
+            double rate = Extended(comm + 8);
+            if (aifc) {
+                const uint8_t* type = comm + 18;
+                // Uncompressed AIFC variants only.
+                if (!Tag(type, "NONE") && !Tag(type, "sowt") &&
+                    !Tag(type, "twos") && !Tag(type, "fl32") &&
+                    !Tag(type, "FL32") && !Tag(type, "fl64") &&
+                    !Tag(type, "FL64") && !Tag(type, "in24") &&
+                    !Tag(type, "in32")) {
+                    return false;
+                }
+            }
+            if (!(rate >= 1 && rate < 4294967296.0)) return false;
+            uint32_t sampleRate = static_cast<uint32_t>(std::lround(rate));
+            return Finish(record, "aiff", sampleRate, channels, frames,
+                          static_cast<double>(sampleRate) * channels * bits);
+        }
+        pos += 8 + static_cast<uint64_t>(length) + (length & 1);
+    }
+    return false;
+}
+
+// ---- FLAC ----
+
+bool ProbeFlac(const Reader& in, uint64_t start, AudioInfoRecord* record) {
+    uint64_t pos = start + 4;
+    uint32_t sampleRate = 0, channels = 0;
+    uint64_t totalSamples = 0;
+    for (int step = 0; step < kMaxSteps; step++) {
+        uint8_t header[4];
+        if (!in.ReadExact(pos, header, 4)) return false;
+        bool last = header[0] & 0x80;
+        uint32_t length = Be24(header + 1);
+        if (step == 0) {
+            // STREAMINFO always comes first.
+            uint8_t info[18];
+            if ((header[0] & 0x7F) != 0 || length < 34 ||
+                !in.ReadExact(pos + 4, info, sizeof(info))) {
+                return false;
+            }
+            uint64_t packed = Be64(info + 10);
+            sampleRate = static_cast<uint32_t>(packed >> 44);
+            channels = static_cast<uint32_t>((packed >> 41) & 0x7) + 1;
+            totalSamples = packed & 0xFFFFFFFFFULL;
+            // Streamed encoders may not know the length.
+            if (totalSamples == 0 || sampleRate == 0) return false;
+        }
+        pos += 4 + static_cast<uint64_t>(length);
+        if (last) {
+            if (pos > in.size()) return false;
+            double seconds = static_cast<double>(totalSamples) / sampleRate;
+            return Finish(record, "flac", sampleRate, channels, totalSamples,
+                          (in.size() - pos) * 8.0 / seconds);
+        }
+    }
+    return false;
+}
+
+// ---- MP3 ----
+
+struct MpegFrame {
+    bool mpeg1;
+    uint32_t bitRate;  // bits per second
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t samplesPerFrame;
+    uint32_t length;
+    uint32_t sideInfo;
+};
+
+/// Decodes an MPEG audio Layer III frame header.
+bool ParseMpegHeader(const uint8_t* p, MpegFrame* frame) {
+    static const uint16_t kBitRatesV1[16] = {
+        0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+    static const uint16_t kBitRatesV2[16] = {
+        0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+    static const uint32_t kSampleRates[3] = {44100, 48000, 32000};
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+    int version = (p[1] >> 3) & 0x3;  // 0: 2.5, 1: reserved, 2: 2, 3: 1
+    int layer = (p[1] >> 1) & 0x3;    // 1: Layer III
+    int bitRateIndex = p[2] >> 4;
+    int rateIndex = (p[2] >> 2) & 0x3;
+    if (version == 1 || layer != 1 || rateIndex == 3) return false;
+    frame->mpeg1 = version == 3;
+    uint32_t kbps = (frame->mpeg1 ? kBitRatesV1 : kBitRatesV2)[bitRateIndex];
+    if (kbps == 0) return false;  // free format or invalid
+    frame->bitRate = kbps * 1000;
+    frame->sampleRate = kSampleRates[rateIndex] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    bool mono = (p[3] >> 6) == 3;
+    frame->channels = mono ? 1 : 2;
+    frame->samplesPerFrame = frame->mpeg1 ? 1152 : 576;
+    frame->length = frame->samplesPerFrame / 8 * frame->bitRate /
+                    frame->sampleRate + ((p[2] >> 1) & 0x1);
+    frame->sideInfo = frame->mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+    return true;
+}
+
+bool ProbeMp3(const Reader& in, uint64_t start, AudioInfoRecord* record) {
+    // Find two consecutive frames with matching parameters, so a stray
+    // sync word in junk or a tag is not taken for audio.
+    uint8_t window[kMp3SyncWindow + 4];
+    size_t got = in.ReadAt(start, window, sizeof(window));
+    uint64_t frameStart = 0;
+    MpegFrame frame{};
+    bool synced = false;
+    for (size_t i = 0; i + 4 <= got && !synced; i++) {
+        if (window[i] != 0xFF || !ParseMpegHeader(window + i, &frame)) continue;
+        uint8_t next[4];
+        MpegFrame second{};
+        if (in.ReadExact(start + i + frame.length, next, 4) &&
+            ParseMpegHeader(next, &second) && second.mpeg1 == frame.mpeg1 &&
+            second.sampleRate == frame.sampleRate) {
+            frameStart = start + i;
+            synced = true;
+        }
+    }
+    if (!synced) return false;
+
+    uint8_t first[512] = {};
+    in.ReadAt(frameStart, first, sizeof(first));
+    uint64_t frames = 0, bytes = 0;
+    uint32_t delay = 0, padding = 0;
+    const uint8_t* xing = first + 4 + frame.sideInfo;
+    const uint8_t* vbri = first + 4 + 32;
+    if (Tag(xing, "Xing") || Tag(xing, "Info")) {
+        uint32_t flags = Be32(xing + 4);
+        const uint8_t* p = xing + 8;
+        if (flags & 0x1) { frames = Be32(p); p += 4; }
+        if (flags & 0x2) { bytes = Be32(p); p += 4; }
+        if (flags & 0x4) p += 100;  // seek table
+        if (flags & 0x8) p += 4;    // quality
+        // LAME (and FFmpeg's copy of it) record the encoder delay and
+        // padding, which are not part of the audio.
+        if (Tag(p, "LAME") || Tag(p, "Lavf") || Tag(p, "Lavc")) {
+            uint32_t gapless = Be24(p + 21);
+            delay = gapless >> 12;
+            padding = gapless & 0xFFF;
+        }
+    } else if (Tag(vbri, "VBRI")) {
+        bytes = Be32(vbri + 10);
+        frames = Be32(vbri + 14);
+    }
+
+    uint64_t samples;
+    double bitRate;
+    if (frames > 0) {
+        samples = frames * frame.samplesPerFrame;
+        samples = samples > delay + padding ? samples - delay - padding : 0;
+        if (samples == 0) return false;
+        if (bytes == 0) bytes = in.size() - frameStart;
+        bitRate = bytes * 8.0 * frame.sampleRate / samples;
+    } else {
+        // CBR: the length follows from the size of the audio data.
+        uint64_t end = in.size();
+        uint8_t tag[3];
+        if (end >= 128 && in.ReadExact(end - 128, tag, 3) &&
+            memcmp(tag, "TAG", 3) == 0) {
+            end -= 128;
+        }
+        if (end <= frameStart) return false;
+        samples = (end - frameStart) * 8 * frame.sampleRate / frame.bitRate;
+        bitRate = frame.bitRate;
+    }
+    return Finish(record, "mp3", frame.sampleRate, frame.channels, samples,
+                  bitRate);
+}
+
+/// Size of the ID3v2 tag at the start of [head], or 0.
+uint64_t Id3v2Size(const uint8_t* head, size_t size) {
+    if (size < 10 || memcmp(head, "ID3", 3) != 0) return 0;
+    const uint8_t* s = head + 6;
+    if ((s[0] | s[1] | s[2] | s[3]) & 0x80) return 0;
+    uint64_t length = static_cast<uint64_t>(s[0]) << 21 | s[1] << 14 |
+                      s[2] << 7 | s[3];
+    bool footer = head[5] & 0x10;
+    return 10 + length + (footer ? 10 : 0);
+}
+
+// ---- MP4 / M4A ----
+
+struct Box {
+    uint8_t type[4];
+    uint64_t body;  // first byte after the header
+    uint64_t end;
+};
+
+/// Reads the box header at [pos]; false if it does not fit in [limit].
+bool ReadBox(const Reader& in, uint64_t pos, uint64_t limit, Box* box) {
+    uint8_t header[16];
+    if (pos + 8 > limit || !in.ReadExact(pos, header, 8)) return false;
+    uint64_t size = Be32(header);
+    memcpy(box->type, header + 4, 4);
+    box->body = pos + 8;
+    if (size == 1) {
+        if (pos + 16 > limit || !in.ReadExact(pos + 8, header + 8, 8)) return false;
+        size = Be64(header + 8);
+        box->body = pos + 16;
+    } else if (size == 0) {
+        size = limit - pos;
+    }
+    if (size < box->body - pos || size > limit - pos) return false;
+    box->end = pos + size;
+    return true;
+}
+
+/// Finds the first [type] box among those in [begin, end).
+bool FindBox(const Reader& in, uint64_t begin, uint64_t end, const char* type,
+             Box* found) {
+    uint64_t pos = begin;
+    for (int step = 0; step < kMaxSteps; step++) {
+        Box box;
+        if (!ReadBox(in, pos, end, &box)) return false;
+        if (Tag(box.type, type)) {
+            *found = box;
+            return true;
+        }
+        pos = box.end;
+    }
+    return false;
+}
+
+bool FindPath(const Reader& in, Box parent, const char* const* path,
+              Box* found) {
+    for (; *path; path++) {
+        if (!FindBox(in, parent.body, parent.end, *path, &parent)) return false;
+    }
+    *found = parent;
+    return true;
+}
+
+/// Reads the length of an MPEG-4 descriptor at [p], advancing past it.
+uint32_t DescriptorLength(const uint8_t** p, const uint8_t* end) {
+    uint32_t length = 0;
+    for (int i = 0; i < 4 && *p < end; i++) {
+        uint8_t byte = *(*p)++;
+        length = length << 7 | (byte & 0x7F);
+        if (!(byte & 0x80)) break;
+    }
+    return length;
+}
+
+/// Reads the DecoderConfigDescriptor of an `esds` box.
+bool ParseEsds(const Reader& in, const Box& esds, uint8_t* objectType,
+               uint32_t* avgBitRate) {
+    uint8_t data[64] = {};
+    size_t size = in.ReadAt(esds.body, data,
+                            std::min<uint64_t>(sizeof(data), esds.end - esds.body));
+    const uint8_t* p = data + 4;  // version and flags
+    const uint8_t* end = data + size;
+    if (p >= end || *p++ != 0x03) return false;  // ES_Descriptor
+    DescriptorLength(&p, end);
+    if (p + 3 > end) return false;
+    uint8_t flags = p[2];
+    p += 3;
+    if (flags & 0x80) p += 2;
+    if (flags & 0x40) p += (p < end ? *p : 0) + 1;
+    if (flags & 0x20) p += 2;
+    if (p >= end || *p++ != 0x04) return false;  // DecoderConfigDescriptor
+    DescriptorLength(&p, end);
+    if (p + 13 > end) return false;
+    *objectType = p[0];
+    *avgBitRate = Be32(p + 9);
+    return true;
+}
+
+/// Probes the first sound track of an MP4 whose top-level boxes span the
+/// file.
+bool ProbeMp4(const Reader& in, AudioInfoRecord* record) {
+    Box moov;
+    if (!FindBox(in, 0, in.size(), "moov", &moov)) return false;
+    uint64_t pos = moov.body;
+    for (int step = 0; step < kMaxSteps; step++) {
+        Box trak;
+        if (!FindBox(in, pos, moov.end, "trak", &trak)) return false;
+        pos = trak.end;
+
+        static const char* const kHdlr[] = {"mdia", "hdlr", nullptr};
+        Box hdlr;
+        uint8_t handler[12];
+        if (!FindPath(in, trak, kHdlr, &hdlr) ||
+            !in.ReadExact(hdlr.body, handler, sizeof(handler)) ||
+            !Tag(handler + 8, "soun")) {
+            continue;
+        }
+
+        static const char* const kMdhd[] = {"mdia", "mdhd", nullptr};
+        Box mdhd;
+        uint8_t times[32];
+        if (!FindPath(in, trak, kMdhd, &mdhd) ||
+            !in.ReadExact(mdhd.body, times, 1)) {
+            return false;
+        }
+        uint32_t timescale;
+        uint64_t duration;
+        if (times[0] == 1) {
+            if (!in.ReadExact(mdhd.body, times, 32)) return false;
+            timescale = Be32(times + 20);
+            duration = Be64(times + 24);
+        } else {
+            if (!in.ReadExact(mdhd.body, times, 20)) return false;
+            timescale = Be32(times + 12);
+            duration = Be32(times + 16);
+        }
+        // Fragmented files keep their length in the fragments.
+        if (timescale == 0 || duration == 0 || duration == 0xFFFFFFFF) {
+            return false;
+        }
+
+        static const char* const kStsd[] = {"mdia", "minf", "stbl", "stsd", nullptr};
+        Box stsd, entry;
+        uint8_t fields[36];
+        if (!FindPath(in, trak, kStsd, &stsd) ||
+            !ReadBox(in, stsd.body + 8, stsd.end, &entry) ||
+            !in.ReadExact(entry.body - 8, fields, sizeof(fields))) {
+            return false;
+        }
+        uint16_t version = Be16(fields + 16);
+        if (version > 1) return false;
+        uint32_t channels = Be16(fields + 24);
+        uint32_t sampleRate = Be32(fields + 32) >> 16;
+        uint64_t children = entry.body - 8 + 36 + (version == 1 ? 16 : 0);
+        uint64_t frames = duration * sampleRate / timescale;
+
+        if (Tag(entry.type, "mp4a")) {
+            Box esds;
+            uint8_t objectType = 0;
+            uint32_t avgBitRate = 0;
+            if (!FindBox(in, children, entry.end, "esds", &esds) ||
+                !ParseEsds(in, esds, &objectType, &avgBitRate)) {
+                return false;
+            }
+            const char* format;
+            if (objectType == 0x40 || (objectType >= 0x66 && objectType <= 0x68)) {
+                format = "aac";
+            } else if (objectType == 0x69 || objectType == 0x6B) {
+                format = "mp3";
+            } else {
+                return false;
+            }
+            if (!Finish(record, format, sampleRate, channels, frames, avgBitRate)) {
+                return false;
+            }
+        } else if (Tag(entry.type, "alac")) {
+            Box config;
+            uint8_t alac[28];
+            if (!FindBox(in, children, entry.end, "alac", &config) ||
+                !in.ReadExact(config.body, alac, sizeof(alac))) {
+                return false;
+            }
+            // ALACSpecificConfig, after the version and flags.
+            channels = alac[4 + 9];
+            uint32_t avgBitRate = Be32(alac + 4 + 16);
+            sampleRate = Be32(alac + 4 + 20);
+            frames = duration * sampleRate / timescale;
+            if (!Finish(record, "alac", sampleRate, channels, frames, avgBitRate)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        record->durationMs = static_cast<int64_t>(duration * 1000 / timescale);
+        return true;
+    }
+    return false;
+}
+
+bool Probe(const Reader& in, AudioInfoRecord* record) {
+    uint8_t head[kHeadBytes];
+    size_t size = in.ReadAt(0, head, sizeof(head));
+    if (size < 12) return false;
+    if ((Tag(head, "RIFF") || Tag(head, "RF64")) && Tag(head + 8, "WAVE")) {
+        return ProbeWav(in, Tag(head, "RF64"), record);
+    }
+    if (Tag(head, "FORM") && (Tag(head + 8, "AIFF") || Tag(head + 8, "AIFC"))) {
+        return ProbeAiff(in, Tag(head + 8, "AIFC"), record);
+    }
+    if (Tag(head + 4, "ftyp")) return ProbeMp4(in, record);
+    // Other containers go to the discoverer before the MP3 scan, which could
+    // take a pair of sync words in their packets for MPEG frames.
+    if (Tag(head, "OggS") || Be32(head) == 0x1A45DFA3 ||  // EBML (WebM)
+        Tag(head, "RIFF") || Tag(head, "RF64") || Tag(head, "FORM")) {
+        return false;
+    }
+
+    uint64_t start = Id3v2Size(head, size);
+    uint8_t magic[4];
+    if (!in.ReadExact(start, magic, 4)) return false;
+    if (Tag(magic, "fLaC")) return ProbeFlac(in, start, record);
+    return ProbeMp3(in, start, record);
+}
+
+bool Count(bool recognized, std::chrono::steady_clock::time_point started) {
+    if (recognized) {
+        gRecognized++;
+        gTotalMicros += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count());
+    } else {
+        gUnrecognized++;
+    }
+    return recognized;
+}
+
+}  // namespace
+
+bool HeaderProbe::ProbeFile(const std::string& path, AudioInfoRecord* record) {
+    auto started = std::chrono::steady_clock::now();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return Count(false, started);
+    struct stat st;
+    bool recognized = false;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        FileReader reader(fd, static_cast<uint64_t>(st.st_size));
+        recognized = Probe(reader, record);
+    }
+    close(fd);
+    return Count(recognized, started);
+}
+
+bool HeaderProbe::ProbeMemory(const uint8_t* data, size_t size,
+                              AudioInfoRecord* record) {
+    auto started = std::chrono::steady_clock::now();
+    MemoryReader reader(data, size);
+    return Count(Probe(reader, record), started);
+}
+
+bool HeaderProbe::ReadPcmWavLayout(int fd, WavLayout* layout) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    FileReader reader(fd, static_cast<uint64_t>(st.st_size));
+    uint8_t head[12];
+    if (!reader.ReadExact(0, head, sizeof(head)) ||
+        !(Tag(head, "RIFF") || Tag(head, "RF64")) || !Tag(head + 8, "WAVE")) {
+        return false;
+    }
+    uint16_t formatTag = 0;
+    if (!ParseWav(reader, Tag(head, "RF64"), &formatTag, layout)) return false;
+    layout->floatSamples = formatTag == 3;
+    return (formatTag == 1 ||
+            (formatTag == 3 && (layout->bitsPerSample == 32 ||
+                                layout->bitsPerSample == 64))) &&
+           layout->blockAlign == layout->channels * layout->bitsPerSample / 8;
+}
+
+HeaderProbeStats HeaderProbe::Stats() {
+    HeaderProbeStats stats;
+    stats.recognized = gRecognized.load();
+    stats.unrecognized = gUnrecognized.load();
+    stats.totalMicros = gTotalMicros.load();
+    return stats;
+}
+
+}  // namespace audio_decoder
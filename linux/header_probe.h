@@ -0,0 +1,61 @@
+#ifndef FLUTTER_PLUGIN_HEADER_PROBE_H_
+#define FLUTTER_PLUGIN_HEADER_PROBE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "info_cache.h"
+
+namespace audio_decoder {
+
+struct HeaderProbeStats {
+    /// Inputs answered from their headers.
+    uint64_t recognized = 0;
+    /// Inputs left to the discoverer.
+    uint64_t unrecognized = 0;
+    /// Time spent in recognized probes.
+    uint64_t totalMicros = 0;
+};
+
+/// Where the samples of a PCM WAV file are and how they are laid out.
+struct WavLayout {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint16_t bitsPerSample = 0;
+    uint16_t blockAlign = 0;
+    /// IEEE float rather than integer samples.
+    bool floatSamples = false;
+    /// Byte range of the data chunk's samples, clamped to the file.
+    uint64_t dataOffset = 0;
+    uint64_t dataSize = 0;
+};
+
+/// Reads the getAudioInfo fields straight from container headers, without
+/// GStreamer, for the formats where a few KB at known offsets hold them all:
+/// PCM/float WAV (including RF64), AIFF/AIFC, FLAC (STREAMINFO), MP3 (Xing,
+/// Info, VBRI and LAME headers, or the frame rate of CBR files) and MP4/M4A
+/// with AAC or ALAC (mdhd and the sample description).
+///
+/// Each call returns false if the input is not one of these or its headers
+/// do not give a definite answer; the caller then probes it with the
+/// discoverer, which reports such inputs more fully.
+class HeaderProbe {
+ public:
+    /// Probes the regular file at [path] with a handful of preads.
+    static bool ProbeFile(const std::string& path, AudioInfoRecord* record);
+
+    /// Probes an input that is already in memory.
+    static bool ProbeMemory(const uint8_t* data, size_t size,
+                            AudioInfoRecord* record);
+
+    /// Reads the layout of the WAV (or RF64) file open at [fd].  Returns
+    /// false unless it holds little-endian integer or 32/64-bit float PCM.
+    static bool ReadPcmWavLayout(int fd, WavLayout* layout);
+
+    static HeaderProbeStats Stats();
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_HEADER_PROBE_H_
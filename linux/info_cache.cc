@@ -0,0 +1,181 @@
+#include "info_cache.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "scratch_file.h"
+
+namespace audio_decoder {
+
+static const char kIndexHeader[] = "audio_decoder info cache 1";
+/// Changed entries after which MaybeFlush rewrites the index.
+static constexpr size_t kFlushEvery = 64;
+
+bool FileKey::ForPath(const std::string& path, FileKey* key) {
+    char resolved[PATH_MAX];
+    if (!realpath(path.c_str(), resolved)) return false;
+    struct stat st;
+    if (stat(resolved, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    key->path = resolved;
+    key->size = static_cast<uint64_t>(st.st_size);
+    key->mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                   st.st_mtim.tv_nsec;
+    return true;
+}
+
+AudioInfoCache::AudioInfoCache(size_t capacity) : capacity_(capacity) {}
+
+bool AudioInfoCache::Lookup(const FileKey& key, AudioInfoRecord* record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key.path);
+    if (it == index_.end()) {
+        stats_.misses++;
+        return false;
+    }
+    const Entry& entry = *it->second;
+    if (entry.key.size != key.size || entry.key.mtimeNs != key.mtimeNs) {
+        entries_.erase(it->second);
+        index_.erase(it);
+        stats_.stale++;
+        stats_.misses++;
+        dirty_++;
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *record = entry.record;
+    stats_.hits++;
+    return true;
+}
+
+void AudioInfoCache::Insert(const FileKey& key, const AudioInfoRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) return;
+    InsertLocked(key, record);
+    dirty_++;
+    EvictLocked();
+}
+
+void AudioInfoCache::InsertLocked(const FileKey& key,
+                                  const AudioInfoRecord& record) {
+    auto it = index_.find(key.path);
+    if (it != index_.end()) {
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+    entries_.push_front(Entry{key, record});
+    index_[key.path] = entries_.begin();
+}
+
+void AudioInfoCache::EvictLocked() {
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key.path);
+        entries_.pop_back();
+        stats_.evictions++;
+        dirty_++;
+    }
+}
+
+void AudioInfoCache::SetCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    EvictLocked();
+}
+
+void AudioInfoCache::SetIndexFile(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file == indexFile_) return;
+    indexFile_ = file;
+    if (!indexFile_.empty()) LoadLocked();
+}
+
+bool AudioInfoCache::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (indexFile_.empty() || dirty_ == 0) return true;
+    return SaveLocked();
+}
+
+void AudioInfoCache::MaybeFlush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!indexFile_.empty() && dirty_ >= kFlushEvery) SaveLocked();
+}
+
+InfoCacheStats AudioInfoCache::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InfoCacheStats stats = stats_;
+    stats.entries = entries_.size();
+    stats.capacity = capacity_;
+    return stats;
+}
+
+// Index format: a header line, then one line per entry, most recently used
+// first:  size \t mtimeNs \t durationMs \t sampleRate \t channels \t
+// bitRate \t format \t path.  The path comes last so it may contain tabs.
+
+bool AudioInfoCache::LoadLocked() {
+    std::ifstream in(indexFile_);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kIndexHeader) return false;
+    // Entries are read most recent first; inserting them in reverse keeps
+    // that order.
+    std::vector<Entry> loaded;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        char tab;
+        if (!(fields >> entry.key.size >> entry.key.mtimeNs
+                     >> entry.record.durationMs >> entry.record.sampleRate
+                     >> entry.record.channels >> entry.record.bitRate)) {
+            continue;
+        }
+        fields.get(tab);
+        if (!std::getline(fields, entry.record.format, '\t') ||
+            !std::getline(fields, entry.key.path) || entry.key.path.empty()) {
+            continue;
+        }
+        loaded.push_back(std::move(entry));
+    }
+    for (auto it = loaded.rbegin(); it != loaded.rend(); ++it) {
+        if (index_.count(it->key.path) == 0) InsertLocked(it->key, it->record);
+    }
+    EvictLocked();
+    dirty_ = 0;
+    return true;
+}
+
+bool AudioInfoCache::SaveLocked() {
+    std::ostringstream out;
+    out << kIndexHeader << '\n';
+    for (const Entry& entry : entries_) {
+        if (entry.key.path.find('\n') != std::string::npos ||
+            entry.record.format.find_first_of("\t\n") != std::string::npos) {
+            continue;
+        }
+        out << entry.key.size << '\t' << entry.key.mtimeNs << '\t'
+            << entry.record.durationMs << '\t' << entry.record.sampleRate
+            << '\t' << entry.record.channels << '\t' << entry.record.bitRate
+            << '\t' << entry.record.format << '\t' << entry.key.path << '\n';
+    }
+    std::string data = out.str();
+
+    size_t slash = indexFile_.rfind('/');
+    std::string directory = slash == std::string::npos
+        ? "." : indexFile_.substr(0, std::max<size_t>(slash, 1));
+    std::unique_ptr<ScratchFile> file = ScratchFile::CreateIn(directory);
+    if (!file ||
+        !file->Write(reinterpret_cast<const uint8_t*>(data.data()),
+                     data.size()) ||
+        !file->Publish(indexFile_)) {
+        return false;
+    }
+    dirty_ = 0;
+    return true;
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,96 @@
+#ifndef FLUTTER_PLUGIN_INFO_CACHE_H_
+#define FLUTTER_PLUGIN_INFO_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace audio_decoder {
+
+/// The fields getAudioInfo reports for a file.
+struct AudioInfoRecord {
+    int64_t durationMs = 0;
+    int32_t sampleRate = 0;
+    int32_t channels = 0;
+    int32_t bitRate = 0;
+    std::string format;
+};
+
+/// What makes a cached record valid: the file's canonical path and the
+/// size and modification time it had when it was probed.
+struct FileKey {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+
+    /// Resolves [path] (symlinks, `..`) and stats it.  Returns false if the
+    /// file does not exist.
+    static bool ForPath(const std::string& path, FileKey* key);
+};
+
+struct InfoCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    /// Lookups that found the file changed since it was cached.
+    uint64_t stale = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t capacity = 0;
+};
+
+/// LRU cache of getAudioInfo results.
+///
+/// Entries are keyed by canonical path and hold the size and mtime the file
+/// had when it was probed; a lookup for a file that has since changed drops
+/// the entry.  With an index file the cache survives restarts: the file is
+/// read by SetIndexFile and rewritten (atomically) by Flush, which
+/// MaybeFlush calls once enough entries have changed.
+class AudioInfoCache {
+ public:
+    explicit AudioInfoCache(size_t capacity);
+
+    bool Lookup(const FileKey& key, AudioInfoRecord* record);
+    void Insert(const FileKey& key, const AudioInfoRecord& record);
+
+    /// Evicts the least recently used entries beyond [capacity]; 0 disables
+    /// the cache.
+    void SetCapacity(size_t capacity);
+
+    /// Uses [file] as the on-disk index, loading the entries it holds.  An
+    /// empty [file] keeps the cache in memory only.
+    void SetIndexFile(const std::string& file);
+
+    /// Writes the index file if entries changed since it was last written.
+    bool Flush();
+    /// Flushes once a batch of entries has changed.
+    void MaybeFlush();
+
+    InfoCacheStats Stats() const;
+
+ private:
+    struct Entry {
+        FileKey key;
+        AudioInfoRecord record;
+    };
+
+    void InsertLocked(const FileKey& key, const AudioInfoRecord& record);
+    void EvictLocked();
+    bool LoadLocked();
+    bool SaveLocked();
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    /// Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::string indexFile_;
+    size_t dirty_ = 0;
+    InfoCacheStats stats_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_INFO_CACHE_H_
@@ -0,0 +1,207 @@
+#include "job_executor.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace audio_decoder {
+
+namespace {
+
+/// Index of the worker running on this thread, or -1 off the pool.
+thread_local long tWorkerIndex = -1;
+
+size_t DefaultWorkerCount() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 4;
+}
+
+}  // namespace
+
+JobExecutor& JobExecutor::Instance() {
+    // Intentionally leaked: workers may still be finishing jobs while static
+    // destructors run at process exit.
+    static JobExecutor* instance = new JobExecutor();
+    return *instance;
+}
+
+JobExecutor::JobExecutor() {
+    workers_.reserve(kMaxWorkers);
+    for (size_t i = 0; i < kMaxWorkers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    SetWorkerCount(0);
+}
+
+JobExecutor::~JobExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+void JobExecutor::SetWorkerCount(size_t count) {
+    if (count == 0) count = DefaultWorkerCount();
+    count = std::min(count, kMaxWorkers);
+
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    // Threads are started on first use and never stopped; workers at or
+    // beyond the active count park, and their queued jobs get stolen.
+    for (size_t i = 0; i < count; i++) {
+        if (!workers_[i]->thread.joinable()) {
+            workers_[i]->thread = std::thread(&JobExecutor::WorkerLoop, this, i);
+        }
+    }
+    active_.store(count);
+    wake_.notify_all();
+}
+
+void JobExecutor::Submit(std::function<void()> job) {
+    size_t active = active_.load();
+    size_t target = tWorkerIndex >= 0 && static_cast<size_t>(tWorkerIndex) < active
+        ? static_cast<size_t>(tWorkerIndex)
+        : nextWorker_.fetch_add(1) % active;
+    submitted_.fetch_add(1);
+    Push(target, Job{std::move(job), std::chrono::steady_clock::now()});
+}
+
+void JobExecutor::Push(size_t worker, Job job) {
+    {
+        // Counted before it becomes visible, so a worker taking it at once
+        // cannot decrement the count below zero.
+        std::lock_guard<std::mutex> lock(workers_[worker]->mutex);
+        size_t queued = queued_.fetch_add(1) + 1;
+        size_t peak = peakQueued_.load();
+        while (peak < queued &&
+               !peakQueued_.compare_exchange_weak(peak, queued)) {
+        }
+        workers_[worker]->jobs.push_back(std::move(job));
+    }
+    {
+        // Taking the lock orders this with a worker's check-then-wait.
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+    }
+    // Parked workers share the condition variable, so a single wake-up
+    // could land on one of them and be lost.
+    wake_.notify_all();
+}
+
+bool JobExecutor::TakeJob(size_t self, Job* job) {
+    {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            *job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    // Steal the oldest job of another worker, including parked ones.
+    for (size_t offset = 1; offset < workers_.size(); offset++) {
+        Worker& victim = *workers_[(self + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            *job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued_.fetch_sub(1);
+            steals_.fetch_add(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobExecutor::RecordStart(const Job& job) {
+    uint64_t waitUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - job.queuedAt).count());
+    totalWaitUs_.fetch_add(waitUs);
+    uint64_t max = maxWaitUs_.load();
+    while (max < waitUs && !maxWaitUs_.compare_exchange_weak(max, waitUs)) {
+    }
+}
+
+void JobExecutor::WorkerLoop(size_t self) {
+    tWorkerIndex = static_cast<long>(self);
+    for (;;) {
+        Job job;
+        if (self < active_.load() && TakeJob(self, &job)) {
+            RecordStart(job);
+            running_.fetch_add(1);
+            // Jobs report their own errors; one escaping must not take the
+            // worker (and the process) down with it.
+            try {
+                job.run();
+            } catch (...) {
+            }
+            running_.fetch_sub(1);
+            completed_.fetch_add(1);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wake_.wait(lock, [&]() {
+            return stopping_ || (self < active_.load() && queued_.load() > 0);
+        });
+        if (stopping_) return;
+    }
+}
+
+void JobExecutor::ParallelFor(size_t count,
+                              const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+
+    struct Group {
+        std::vector<std::atomic<bool>> claimed;
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+        std::exception_ptr error;
+        explicit Group(size_t n) : claimed(n), remaining(n) {}
+    };
+    auto group = std::make_shared<Group>(count);
+
+    auto runPart = [group, &body](size_t index) {
+        if (group->claimed[index].exchange(true)) return;
+        std::exception_ptr error;
+        try {
+            body(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(group->mutex);
+        if (error && !group->error) group->error = error;
+        if (--group->remaining == 0) group->done.notify_all();
+    };
+
+    // Parts a worker has not claimed by the time the caller gets to them are
+    // run by the caller, and the queued job becomes a no-op.  The queued
+    // jobs must not touch [body] after that, hence runPart claims first.
+    for (size_t i = 1; i < count; i++) {
+        Submit([runPart, i]() { runPart(i); });
+    }
+    for (size_t i = 0; i < count; i++) runPart(i);
+
+    std::unique_lock<std::mutex> lock(group->mutex);
+    group->done.wait(lock, [&]() { return group->remaining == 0; });
+    if (group->error) std::rethrow_exception(group->error);
+}
+
+JobExecutorStats JobExecutor::Stats() const {
+    JobExecutorStats stats;
+    stats.workers = active_.load();
+    stats.queued = queued_.load();
+    stats.peakQueued = peakQueued_.load();
+    stats.running = running_.load();
+    stats.submitted = submitted_.load();
+    stats.completed = completed_.load();
+    stats.steals = steals_.load();
+    stats.totalWaitUs = totalWaitUs_.load();
+    stats.maxWaitUs = maxWaitUs_.load();
+    return stats;
+}
+
+}  // namespace audio_decoder
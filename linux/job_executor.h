@@ -0,0 +1,100 @@
+#ifndef FLUTTER_PLUGIN_JOB_EXECUTOR_H_
+#define FLUTTER_PLUGIN_JOB_EXECUTOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace audio_decoder {
+
+struct JobExecutorStats {
+    size_t workers = 0;
+    size_t queued = 0;
+    size_t peakQueued = 0;
+    size_t running = 0;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t steals = 0;
+    /// Time jobs spent queued before a worker picked them up.
+    uint64_t totalWaitUs = 0;
+    uint64_t maxWaitUs = 0;
+};
+
+/// Plugin-wide pool of worker threads that runs method-call jobs.
+///
+/// Each worker owns a deque: it pushes and pops work at the back and idle
+/// workers steal from the front of the others, so bursts of calls spread
+/// over a fixed number of threads instead of one OS thread per call.  The
+/// worker count defaults to the number of cores and can be changed at any
+/// time; extra workers park rather than exit.
+class JobExecutor {
+ public:
+    static JobExecutor& Instance();
+
+    /// Queues [job].  Never blocks; jobs wait in the queue while every worker
+    /// is busy.  Jobs submitted from a worker go to that worker's deque.
+    void Submit(std::function<void()> job);
+
+    /// Runs body(0) .. body(count - 1) concurrently and returns when all have
+    /// finished.  The calling thread runs every part no worker has started,
+    /// so nesting this inside a job cannot deadlock even with one worker.
+    /// The first exception thrown by a part is rethrown.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    /// Sets the number of active workers; 0 means one per core.
+    void SetWorkerCount(size_t count);
+
+    JobExecutorStats Stats() const;
+
+    /// Upper bound on workers, regardless of the configured count.
+    static constexpr size_t kMaxWorkers = 64;
+
+ private:
+    struct Job {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+
+    JobExecutor();
+    ~JobExecutor();
+
+    void Push(size_t worker, Job job);
+    bool TakeJob(size_t self, Job* job);
+    void WorkerLoop(size_t self);
+    void RecordStart(const Job& job);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> active_{0};
+    std::atomic<size_t> nextWorker_{0};
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> peakQueued_{0};
+    std::atomic<size_t> running_{0};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> steals_{0};
+    std::atomic<uint64_t> totalWaitUs_{0};
+    std::atomic<uint64_t> maxWaitUs_{0};
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_JOB_EXECUTOR_H_
@@ -0,0 +1,58 @@
+#include "job_progress.h"
+
+namespace audio_decoder {
+
+JobProgress::JobProgress(Sink sink, std::chrono::milliseconds interval)
+    : sink_(std::move(sink)),
+      interval_(interval),
+      started_(std::chrono::steady_clock::now()),
+      nextReport_((started_ + interval_).time_since_epoch().count()) {}
+
+void JobProgress::Advance(uint64_t mediaNs, uint64_t bytes) {
+    positionNs_.fetch_add(mediaNs);
+    bytes_.fetch_add(bytes);
+    MaybeReport();
+}
+
+void JobProgress::Set(uint64_t positionNs, uint64_t bytes) {
+    positionNs_.store(positionNs);
+    bytes_.store(bytes);
+    MaybeReport();
+}
+
+void JobProgress::MaybeReport() {
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t due = nextReport_.load();
+    // Only the thread that moves the deadline on reports; the rest return
+    // without waiting.
+    if (now < due || !nextReport_.compare_exchange_strong(
+                         due, now + interval_.count())) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    if (!finished_) sink_(Current());
+}
+
+void JobProgress::Finish() {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    if (finished_) return;
+    finished_ = true;
+    ProgressSnapshot snapshot = Current();
+    snapshot.done = true;
+    sink_(snapshot);
+}
+
+ProgressSnapshot JobProgress::Current() const {
+    ProgressSnapshot snapshot;
+    snapshot.positionNs = positionNs_.load();
+    snapshot.durationNs = durationNs_.load();
+    snapshot.bytesWritten = bytes_.load();
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - started_).count();
+    if (elapsed > 0) {
+        snapshot.realTimeFactor = snapshot.positionNs / 1e9 / elapsed;
+    }
+    return snapshot;
+}
+
+}  // namespace audio_decoder
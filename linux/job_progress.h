@@ -0,0 +1,64 @@
+#ifndef FLUTTER_PLUGIN_JOB_PROGRESS_H_
+#define FLUTTER_PLUGIN_JOB_PROGRESS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace audio_decoder {
+
+/// One progress report of a running job.
+struct ProgressSnapshot {
+    /// Media time processed so far, relative to the start of the job's range.
+    uint64_t positionNs = 0;
+    /// Length of the range being processed; 0 if unknown.
+    uint64_t durationNs = 0;
+    uint64_t bytesWritten = 0;
+    /// Media time processed per second of wall time.
+    double realTimeFactor = 0;
+    /// Set on the last report of a job only.
+    bool done = false;
+};
+
+/// Collects the progress of one job and forwards it to [sink] at most once
+/// per [interval].  Updates may come from several threads at once (parallel
+/// decode segments); reports are serialized.
+class JobProgress {
+ public:
+    using Sink = std::function<void(const ProgressSnapshot&)>;
+
+    JobProgress(Sink sink, std::chrono::milliseconds interval);
+
+    void SetDuration(uint64_t durationNs) { durationNs_ = durationNs; }
+
+    /// Adds [mediaNs] of processed media and [bytes] of output.
+    void Advance(uint64_t mediaNs, uint64_t bytes);
+
+    /// Replaces the totals, for producers that can only be polled (an
+    /// encoder's position and output file size).
+    void Set(uint64_t positionNs, uint64_t bytes);
+
+    /// Sends the final report.  Later updates are ignored.
+    void Finish();
+
+    ProgressSnapshot Current() const;
+
+ private:
+    void MaybeReport();
+
+    Sink sink_;
+    const std::chrono::steady_clock::duration interval_;
+    const std::chrono::steady_clock::time_point started_;
+    std::atomic<uint64_t> positionNs_{0};
+    std::atomic<uint64_t> durationNs_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<int64_t> nextReport_;
+    std::mutex sinkMutex_;
+    bool finished_ = false;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_JOB_PROGRESS_H_
@@ -0,0 +1,96 @@
+#include "job_registry.h"
+
+namespace audio_decoder {
+
+// ---------------------------------------------------------------------------
+// CancelToken
+// ---------------------------------------------------------------------------
+
+CancelToken::Hook::Hook(Hook&& other) noexcept
+    : token_(other.token_), id_(other.id_) {
+    other.token_ = nullptr;
+}
+
+CancelToken::Hook& CancelToken::Hook::operator=(Hook&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        token_ = other.token_;
+        id_ = other.id_;
+        other.token_ = nullptr;
+    }
+    return *this;
+}
+
+CancelToken::Hook::~Hook() {
+    Reset();
+}
+
+void CancelToken::Hook::Reset() {
+    if (!token_) return;
+    // Cancel() runs hooks under the same lock, so once this returns the
+    // hook has either run to completion or will never run.
+    std::lock_guard<std::mutex> lock(token_->mutex_);
+    token_->hooks_.erase(id_);
+    token_ = nullptr;
+}
+
+bool CancelToken::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_.exchange(true)) return false;
+    for (auto& entry : hooks_) entry.second();
+    hooks_.clear();
+    return true;
+}
+
+CancelToken::Hook CancelToken::OnCancel(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_.load()) {
+        hook();
+        return Hook();
+    }
+    uint64_t id = nextHook_++;
+    hooks_.emplace(id, std::move(hook));
+    return Hook(this, id);
+}
+
+// ---------------------------------------------------------------------------
+// JobRegistry
+// ---------------------------------------------------------------------------
+
+JobRegistry& JobRegistry::Instance() {
+    static JobRegistry instance;
+    return instance;
+}
+
+std::shared_ptr<CancelToken> JobRegistry::Register(const std::string& jobId) {
+    auto token = std::make_shared<CancelToken>();
+    if (jobId.empty()) return token;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!jobs_.emplace(jobId, token).second) return nullptr;
+    return token;
+}
+
+void JobRegistry::Unregister(const std::string& jobId) {
+    if (jobId.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.erase(jobId);
+}
+
+bool JobRegistry::Cancel(const std::string& jobId) {
+    std::shared_ptr<CancelToken> token;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(jobId);
+        if (it == jobs_.end()) return false;
+        token = it->second;
+    }
+    if (token->Cancel()) cancelled_.fetch_add(1);
+    return true;
+}
+
+size_t JobRegistry::active() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+}  // namespace audio_decoder
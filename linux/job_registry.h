@@ -0,0 +1,100 @@
+#ifndef FLUTTER_PLUGIN_JOB_REGISTRY_H_
+#define FLUTTER_PLUGIN_JOB_REGISTRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace audio_decoder {
+
+/// Thrown by a job that stopped early because it was cancelled.
+class JobCancelledError : public std::runtime_error {
+ public:
+    JobCancelledError() : std::runtime_error("Job was cancelled") {}
+};
+
+/// Cancellation state shared between a running job and `cancel` calls.
+///
+/// Jobs poll cancelled() between units of work.  Code that blocks (a pull
+/// from a pipeline, say) registers a hook that wakes it up; hooks run on the
+/// cancelling thread.
+class CancelToken {
+ public:
+    /// Keeps a hook registered; unregisters it on destruction, after which
+    /// the hook is guaranteed not to be running.
+    class Hook {
+     public:
+        Hook() = default;
+        Hook(Hook&& other) noexcept;
+        Hook& operator=(Hook&& other) noexcept;
+        ~Hook();
+
+        Hook(const Hook&) = delete;
+        Hook& operator=(const Hook&) = delete;
+
+     private:
+        friend class CancelToken;
+        Hook(CancelToken* token, uint64_t id) : token_(token), id_(id) {}
+        void Reset();
+
+        CancelToken* token_ = nullptr;
+        uint64_t id_ = 0;
+    };
+
+    bool cancelled() const { return cancelled_.load(); }
+
+    /// Throws JobCancelledError if the job has been cancelled.
+    void ThrowIfCancelled() const {
+        if (cancelled()) throw JobCancelledError();
+    }
+
+    /// Marks the job cancelled and runs the registered hooks.  Returns false
+    /// (and does nothing) if it already was.
+    bool Cancel();
+
+    /// Runs [hook] once if the job is cancelled while the returned Hook is
+    /// alive, or right away if it already is.
+    Hook OnCancel(std::function<void()> hook);
+
+ private:
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    uint64_t nextHook_ = 1;
+    std::map<uint64_t, std::function<void()>> hooks_;
+};
+
+/// Jobs that were started with an ID, so Dart can cancel them by that ID.
+class JobRegistry {
+ public:
+    static JobRegistry& Instance();
+
+    /// Returns a token for a new job.  An empty [jobId] gets a token nobody
+    /// else can reach.  Returns nullptr if [jobId] is already running.
+    std::shared_ptr<CancelToken> Register(const std::string& jobId);
+
+    void Unregister(const std::string& jobId);
+
+    /// Cancels the job registered as [jobId].  Returns false if there is
+    /// none (it already finished, or never existed).
+    bool Cancel(const std::string& jobId);
+
+    size_t active();
+    uint64_t cancelled() const { return cancelled_.load(); }
+
+ private:
+    JobRegistry() = default;
+
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<CancelToken>> jobs_;
+    std::atomic<uint64_t> cancelled_{0};
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_JOB_REGISTRY_H_
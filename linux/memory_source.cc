@@ -0,0 +1,120 @@
+#include "memory_source.h"
+
+#include <gst/app/gstappsrc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace audio_decoder {
+
+static const char kUriPrefix[] = "appsrc://audio-decoder/";
+
+static std::mutex gRegistryMutex;
+static std::map<std::string, MemorySource*> gRegistry;
+static uint64_t gNextId = 0;
+
+static std::atomic<uint64_t> gInputs{0};
+static std::atomic<uint64_t> gAttached{0};
+static std::atomic<uint64_t> gBytesServed{0};
+
+/// Read position of one appsrc.  Holds its own reference on the owner, so an
+/// appsrc that outlives its MemorySource still reads valid memory.
+struct MemoryReader {
+    const uint8_t* data;
+    size_t size;
+    GObject* owner;
+    uint64_t offset = 0;
+};
+
+static void DestroyReader(gpointer user_data) {
+    auto* reader = static_cast<MemoryReader*>(user_data);
+    g_object_unref(reader->owner);
+    delete reader;
+}
+
+static void OnNeedData(GstAppSrc* appsrc, guint length, gpointer user_data) {
+    auto* reader = static_cast<MemoryReader*>(user_data);
+    if (reader->offset >= reader->size) {
+        gst_app_src_end_of_stream(appsrc);
+        return;
+    }
+    size_t remaining = reader->size - reader->offset;
+    size_t count = length > 0 ? std::min<size_t>(length, remaining) : remaining;
+    GstBuffer* buffer = gst_buffer_new_wrapped_full(
+        GST_MEMORY_FLAG_READONLY, const_cast<uint8_t*>(reader->data),
+        reader->size, reader->offset, count, g_object_ref(reader->owner),
+        g_object_unref);
+    GST_BUFFER_OFFSET(buffer) = reader->offset;
+    reader->offset += count;
+    gBytesServed += count;
+    gst_app_src_push_buffer(appsrc, buffer);
+}
+
+static gboolean OnSeekData(GstAppSrc* appsrc, guint64 offset,
+                           gpointer user_data) {
+    auto* reader = static_cast<MemoryReader*>(user_data);
+    if (offset > reader->size) return FALSE;
+    reader->offset = offset;
+    return TRUE;
+}
+
+MemorySource::MemorySource(const uint8_t* data, size_t size, GObject* owner,
+                           const std::string& extension)
+    : data_(data), size_(size), owner_(owner) {
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    uri_ = kUriPrefix + std::to_string(gNextId++);
+    if (!extension.empty()) uri_ += "." + extension;
+    gRegistry[uri_] = this;
+    gInputs++;
+}
+
+MemorySource::~MemorySource() {
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    gRegistry.erase(uri_);
+}
+
+bool MemorySource::IsMemoryUri(const std::string& uri) {
+    return uri.rfind(kUriPrefix, 0) == 0;
+}
+
+bool MemorySource::Attach(const std::string& uri, GstElement* appsrc) {
+    if (!GST_IS_APP_SRC(appsrc)) return false;
+    MemoryReader* reader;
+    {
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        auto it = gRegistry.find(uri);
+        if (it == gRegistry.end()) return false;
+        const MemorySource* source = it->second;
+        reader = new MemoryReader{source->data_, source->size_,
+                                  G_OBJECT(g_object_ref(source->owner_))};
+    }
+    GstAppSrc* src = GST_APP_SRC(appsrc);
+    gst_app_src_set_stream_type(src, GST_APP_STREAM_TYPE_RANDOM_ACCESS);
+    gst_app_src_set_size(src, static_cast<gint64>(reader->size));
+    GstAppSrcCallbacks callbacks = {};
+    callbacks.need_data = OnNeedData;
+    callbacks.seek_data = OnSeekData;
+    gst_app_src_set_callbacks(src, &callbacks, reader, DestroyReader);
+    gAttached++;
+    return true;
+}
+
+void MemorySource::OnSourceSetup(GstElement* uridecodebin, GstElement* source,
+                                 gpointer user_data) {
+    gchar* uri = nullptr;
+    g_object_get(uridecodebin, "uri", &uri, nullptr);
+    if (uri && IsMemoryUri(uri)) Attach(uri, source);
+    g_free(uri);
+}
+
+MemorySourceStats MemorySource::Stats() {
+    MemorySourceStats stats;
+    stats.inputs = gInputs.load();
+    stats.attached = gAttached.load();
+    stats.bytesServed = gBytesServed.load();
+    return stats;
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,65 @@
+#ifndef FLUTTER_PLUGIN_MEMORY_SOURCE_H_
+#define FLUTTER_PLUGIN_MEMORY_SOURCE_H_
+
+#include <gst/gst.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace audio_decoder {
+
+struct MemorySourceStats {
+    /// Sources created and pipelines attached to them.
+    uint64_t inputs = 0;
+    uint64_t attached = 0;
+    /// Bytes handed to pipelines, counting re-reads after seeks.
+    uint64_t bytesServed = 0;
+};
+
+/// Audio data in memory that decode pipelines read through an `appsrc://`
+/// URI instead of a temporary file.
+///
+/// While the source exists its uri() can be given to any uridecodebin that
+/// has OnSourceSetup connected to its "source-setup" signal (the pooled
+/// decode pipelines do).  The appsrc is random access, so demuxers can seek,
+/// and each buffer it pushes wraps a slice of [data] without copying.  Every
+/// such buffer holds a reference on [owner], which must keep [data] alive.
+/// The `*Bytes` method handlers pass their FlMethodCall as [owner]: the call
+/// keeps its `inputData` argument alive, so the bytes are read in place for
+/// as long as the job or any buffer still needs them.
+class MemorySource {
+ public:
+    /// [extension] is appended to the URI as a typefinding hint.
+    MemorySource(const uint8_t* data, size_t size, GObject* owner,
+                 const std::string& extension);
+    ~MemorySource();
+
+    MemorySource(const MemorySource&) = delete;
+    MemorySource& operator=(const MemorySource&) = delete;
+
+    const std::string& uri() const { return uri_; }
+
+    static bool IsMemoryUri(const std::string& uri);
+
+    /// Feeds [appsrc] from the live source registered under [uri].  Returns
+    /// false if there is none or [appsrc] is not an appsrc.
+    static bool Attach(const std::string& uri, GstElement* appsrc);
+
+    /// "source-setup" handler for uridecodebin: attaches the source named by
+    /// the bin's current URI.  Other sources are left alone.
+    static void OnSourceSetup(GstElement* uridecodebin, GstElement* source,
+                              gpointer user_data);
+
+    static MemorySourceStats Stats();
+
+ private:
+    const uint8_t* data_;
+    size_t size_;
+    GObject* owner_;
+    std::string uri_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_MEMORY_SOURCE_H_
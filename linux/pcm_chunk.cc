@@ -0,0 +1,72 @@
+#include "pcm_chunk.h"
+
+#include <algorithm>
+
+namespace audio_decoder {
+
+namespace {
+
+/// Owns one reference to a GstBuffer and keeps it mapped for reading.
+class MappedBuffer {
+ public:
+    explicit MappedBuffer(GstBuffer* buffer) : buffer_(gst_buffer_ref(buffer)) {
+        mapped_ = gst_buffer_map(buffer_, &map_, GST_MAP_READ);
+    }
+    ~MappedBuffer() {
+        if (mapped_) gst_buffer_unmap(buffer_, &map_);
+        gst_buffer_unref(buffer_);
+    }
+
+    MappedBuffer(const MappedBuffer&) = delete;
+    MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+    bool mapped() const { return mapped_; }
+    const uint8_t* data() const { return map_.data; }
+    size_t size() const { return map_.size; }
+
+ private:
+    GstBuffer* buffer_;
+    GstMapInfo map_{};
+    bool mapped_ = false;
+};
+
+}  // namespace
+
+PcmChunk PcmChunk::Wrap(GstBuffer* buffer) {
+    auto mapped = std::make_shared<MappedBuffer>(buffer);
+    if (!mapped->mapped()) return PcmChunk();
+
+    PcmChunk chunk;
+    chunk.data_ = mapped->data();
+    chunk.size_ = mapped->size();
+    chunk.owner_ = std::move(mapped);
+    return chunk;
+}
+
+PcmChunk PcmChunk::FromBytes(std::vector<uint8_t> bytes) {
+    auto owned = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+    PcmChunk chunk;
+    chunk.data_ = owned->data();
+    chunk.size_ = owned->size();
+    chunk.owner_ = std::move(owned);
+    return chunk;
+}
+
+PcmChunk PcmChunk::Adopt(std::shared_ptr<const void> owner,
+                         const uint8_t* data, size_t size) {
+    PcmChunk chunk;
+    chunk.data_ = data;
+    chunk.size_ = size;
+    chunk.owner_ = std::move(owner);
+    return chunk;
+}
+
+PcmChunk PcmChunk::Slice(size_t offset, size_t length) const {
+    PcmChunk view = *this;
+    offset = std::min(offset, size_);
+    view.data_ = data_ + offset;
+    view.size_ = std::min(length, size_ - offset);
+    return view;
+}
+
+}  // namespace audio_decoder
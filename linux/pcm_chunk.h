@@ -0,0 +1,50 @@
+#ifndef FLUTTER_PLUGIN_PCM_CHUNK_H_
+#define FLUTTER_PLUGIN_PCM_CHUNK_H_
+
+#include <gst/gst.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace audio_decoder {
+
+/// A ref-counted, read-only view of decoded PCM.
+///
+/// A chunk keeps the GstBuffer it was created from referenced and mapped for
+/// as long as any copy of the chunk is alive, so consumers can hold on to
+/// decoded data without copying it.  Copying a chunk only bumps a reference
+/// count.
+class PcmChunk {
+ public:
+    PcmChunk() = default;
+
+    /// Maps [buffer] for reading and takes a reference on it.  Returns an
+    /// empty chunk if the buffer cannot be mapped.
+    static PcmChunk Wrap(GstBuffer* buffer);
+
+    /// Takes ownership of [bytes] (used for data produced outside GStreamer).
+    static PcmChunk FromBytes(std::vector<uint8_t> bytes);
+
+    /// Wraps [size] bytes at [data] that stay valid while [owner] is alive.
+    static PcmChunk Adopt(std::shared_ptr<const void> owner,
+                          const uint8_t* data, size_t size);
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// Returns a view of [length] bytes starting at [offset], sharing the
+    /// same underlying buffer.  The range is clamped to this chunk.
+    PcmChunk Slice(size_t offset, size_t length) const;
+
+ private:
+    std::shared_ptr<const void> owner_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_PCM_CHUNK_H_
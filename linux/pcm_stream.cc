@@ -0,0 +1,102 @@
+#include "pcm_stream.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace audio_decoder {
+
+static std::atomic<uint64_t> gStreams{0};
+static std::atomic<uint64_t> gChunks{0};
+static std::atomic<uint64_t> gBytes{0};
+static std::atomic<uint64_t> gStalls{0};
+static std::atomic<uint64_t> gTimeouts{0};
+
+PcmStream::PcmStream(size_t chunkBytes,
+                     std::chrono::milliseconds creditTimeout, Sink sink)
+    : requestedBytes_(std::max<size_t>(1, chunkBytes)),
+      creditTimeout_(creditTimeout),
+      chunkBytes_(requestedBytes_),
+      sink_(std::move(sink)) {
+    pending_.reserve(chunkBytes_);
+    gStreams++;
+}
+
+void PcmStream::SetFrameSize(uint32_t bytesPerFrame) {
+    bytesPerFrame_ = std::max<uint32_t>(1, bytesPerFrame);
+    chunkBytes_ = std::max<size_t>(
+        bytesPerFrame_, requestedBytes_ / bytesPerFrame_ * bytesPerFrame_);
+    pending_.reserve(chunkBytes_);
+}
+
+bool PcmStream::Push(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t count = std::min(size, chunkBytes_ - pending_.size());
+        pending_.insert(pending_.end(), data, data + count);
+        data += count;
+        size -= count;
+        if (pending_.size() == chunkBytes_ && !Send()) return false;
+    }
+    return true;
+}
+
+bool PcmStream::Flush() {
+    return pending_.empty() || Send();
+}
+
+bool PcmStream::Send() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (credits_ == 0 && !closed_) {
+            gStalls++;
+            auto ready = [this] { return credits_ > 0 || closed_; };
+            if (creditTimeout_.count() <= 0) {
+                credited_.wait(lock, ready);
+            } else if (!credited_.wait_for(lock, creditTimeout_, ready)) {
+                closed_ = true;
+                timedOut_ = true;
+                gTimeouts++;
+            }
+        }
+        if (closed_) return false;
+        credits_--;
+    }
+    sink_(pending_.data(), pending_.size(), bytesSent_ / bytesPerFrame_);
+    bytesSent_ += pending_.size();
+    gChunks++;
+    gBytes += pending_.size();
+    pending_.clear();
+    return true;
+}
+
+void PcmStream::Grant(uint64_t chunks) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        credits_ += chunks;
+    }
+    credited_.notify_all();
+}
+
+void PcmStream::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    credited_.notify_all();
+}
+
+bool PcmStream::timedOut() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timedOut_;
+}
+
+PcmStreamStats PcmStream::Stats() {
+    PcmStreamStats stats;
+    stats.streams = gStreams.load();
+    stats.chunks = gChunks.load();
+    stats.bytes = gBytes.load();
+    stats.stalls = gStalls.load();
+    stats.timeouts = gTimeouts.load();
+    return stats;
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,90 @@
+#ifndef FLUTTER_PLUGIN_PCM_STREAM_H_
+#define FLUTTER_PLUGIN_PCM_STREAM_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace audio_decoder {
+
+struct PcmStreamStats {
+    uint64_t streams = 0;
+    uint64_t chunks = 0;
+    uint64_t bytes = 0;
+    /// Times a decode waited because the receiver had no credit left.
+    uint64_t stalls = 0;
+    /// Streams closed because the receiver granted no credit in time.
+    uint64_t timeouts = 0;
+};
+
+/// Cuts decoded PCM into chunks of a fixed size and passes them to a sink
+/// no faster than the receiver asks for them.
+///
+/// The receiver grants credits, one per chunk it is ready for.  Sending a
+/// chunk takes a credit, and without one Push() blocks the decoding thread,
+/// which in turn lets the bounded decode queue stop the pipeline.  Memory
+/// in flight is therefore at most the granted chunks plus one being filled.
+/// A receiver that grants nothing for the credit timeout is taken to be
+/// gone, and the stream closes itself.
+class PcmStream {
+ public:
+    /// [data] is only valid during the call; [frameOffset] is the position
+    /// of its first frame in the stream.
+    using Sink = std::function<void(const uint8_t* data, size_t size,
+                                    uint64_t frameOffset)>;
+
+    /// A [creditTimeout] of zero waits for credit indefinitely.
+    PcmStream(size_t chunkBytes, std::chrono::milliseconds creditTimeout,
+              Sink sink);
+
+    PcmStream(const PcmStream&) = delete;
+    PcmStream& operator=(const PcmStream&) = delete;
+
+    /// Sets the frame size once the format is known.  Chunks are rounded
+    /// down to whole frames, so no frame is split across chunks.  Must be
+    /// called before the first Push.
+    void SetFrameSize(uint32_t bytesPerFrame);
+
+    /// Appends decoded data, sending every chunk that fills up.  Returns
+    /// false, leaving the rest unsent, once the stream is closed.
+    bool Push(const uint8_t* data, size_t size);
+
+    /// Sends the partly filled last chunk, if any.
+    bool Flush();
+
+    /// Allows [chunks] more chunks to be sent.
+    void Grant(uint64_t chunks);
+
+    /// Wakes a blocked Push and makes every later one fail.
+    void Close();
+
+    /// Whether the stream closed itself after waiting out the credit timeout.
+    bool timedOut() const;
+
+    static PcmStreamStats Stats();
+
+ private:
+    bool Send();
+
+    const size_t requestedBytes_;
+    const std::chrono::milliseconds creditTimeout_;
+    size_t chunkBytes_;
+    uint32_t bytesPerFrame_ = 1;
+    Sink sink_;
+    std::vector<uint8_t> pending_;
+    uint64_t bytesSent_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable credited_;
+    uint64_t credits_ = 0;
+    bool closed_ = false;
+    bool timedOut_ = false;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_PCM_STREAM_H_
@@ -0,0 +1,181 @@
+#include "scratch_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace audio_decoder {
+
+static std::mutex gScratchMutex;
+static ScratchConfig gScratchConfig;
+static ScratchStats gScratchStats;
+static std::atomic<uint64_t> gPublishCounter{0};
+
+static std::string SpillDirectory(const ScratchConfig& config) {
+    if (!config.spillDirectory.empty()) return config.spillDirectory;
+    const char* tmp = std::getenv("TMPDIR");
+    return tmp && *tmp ? tmp : "/tmp";
+}
+
+/// Opens a file in [directory] that has no name.  Where O_TMPFILE is not
+/// supported a named file is created instead and its path stored in [name].
+static int OpenUnnamed(const std::string& directory, std::string* name) {
+#ifdef O_TMPFILE
+    int fd = open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0644);
+    if (fd >= 0) return fd;
+#endif
+    std::string temp = directory + "/.audio_decoder.XXXXXX";
+    int named = mkostemp(&temp[0], O_CLOEXEC);
+    if (named >= 0) *name = temp;
+    return named;
+}
+
+std::unique_ptr<ScratchFile> ScratchFile::Create(uint64_t expectedBytes) {
+    bool memory = false;
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(gScratchMutex);
+        uint64_t budget = gScratchConfig.memoryBudget;
+        if (budget > 0 && gScratchStats.memoryBytes + expectedBytes <= budget) {
+            memory = true;
+            gScratchStats.memoryBytes += expectedBytes;
+            gScratchStats.peakMemoryBytes = std::max(
+                gScratchStats.peakMemoryBytes, gScratchStats.memoryBytes);
+        } else if (budget > 0) {
+            gScratchStats.spilled++;
+        }
+        directory = SpillDirectory(gScratchConfig);
+    }
+
+    if (memory) {
+        int fd = memfd_create("audio_decoder", MFD_CLOEXEC);
+        std::lock_guard<std::mutex> lock(gScratchMutex);
+        if (fd >= 0) {
+            gScratchStats.memoryFiles++;
+            return std::unique_ptr<ScratchFile>(
+                new ScratchFile(fd, true, expectedBytes));
+        }
+        gScratchStats.memoryBytes -= expectedBytes;
+    }
+
+    std::string name;
+    int fd = OpenUnnamed(directory, &name);
+    if (fd < 0) return nullptr;
+    if (!name.empty()) unlink(name.c_str());
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    gScratchStats.diskFiles++;
+    return std::unique_ptr<ScratchFile>(new ScratchFile(fd, false, 0));
+}
+
+std::unique_ptr<ScratchFile> ScratchFile::CreateIn(const std::string& directory) {
+    std::string name;
+    int fd = OpenUnnamed(directory, &name);
+    if (fd < 0) return nullptr;
+    std::unique_ptr<ScratchFile> file(new ScratchFile(fd, false, 0));
+    file->name_ = name;
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    gScratchStats.diskFiles++;
+    return file;
+}
+
+ScratchFile::~ScratchFile() {
+    if (map_) munmap(map_, mapSize_);
+    close(fd_);
+    if (!name_.empty()) unlink(name_.c_str());
+    if (reserved_ > 0) {
+        std::lock_guard<std::mutex> lock(gScratchMutex);
+        gScratchStats.memoryBytes -= reserved_;
+    }
+}
+
+std::string ScratchFile::path() const {
+    return "/proc/self/fd/" + std::to_string(fd_);
+}
+
+uint64_t ScratchFile::size() const {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return 0;
+    return static_cast<uint64_t>(st.st_size);
+}
+
+bool ScratchFile::Write(const uint8_t* data, size_t size) {
+    if (!Reserve(this->size() + size)) {
+        errno = ENOSPC;
+        return false;
+    }
+    while (size > 0) {
+        ssize_t n = write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ScratchFile::Reserve(uint64_t bytes) {
+    if (!memory_ || bytes <= reserved_) return true;
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    uint64_t memoryBytes = gScratchStats.memoryBytes - reserved_ + bytes;
+    if (memoryBytes > gScratchConfig.memoryBudget) return false;
+    gScratchStats.memoryBytes = memoryBytes;
+    gScratchStats.peakMemoryBytes =
+        std::max(gScratchStats.peakMemoryBytes, memoryBytes);
+    reserved_ = bytes;
+    return true;
+}
+
+const uint8_t* ScratchFile::Map() {
+    if (map_) return static_cast<const uint8_t*>(map_);
+    uint64_t bytes = size();
+    if (bytes == 0) return nullptr;
+    void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) return nullptr;
+    map_ = p;
+    mapSize_ = bytes;
+    return static_cast<const uint8_t*>(map_);
+}
+
+bool ScratchFile::Publish(const std::string& file) {
+    if (!name_.empty()) {
+        if (rename(name_.c_str(), file.c_str()) != 0) return false;
+        name_.clear();
+        return true;
+    }
+    if (memory_) return false;
+    // linkat() cannot replace an existing name, so link the file under a
+    // unique temporary name first and rename that over [file].
+    std::string temp = file + ".tmp" + std::to_string(getpid()) + "-" +
+                       std::to_string(gPublishCounter++);
+    if (linkat(AT_FDCWD, path().c_str(), AT_FDCWD, temp.c_str(),
+               AT_SYMLINK_FOLLOW) != 0) {
+        return false;
+    }
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ScratchFile::Configure(const ScratchConfig& config) {
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    gScratchConfig = config;
+}
+
+ScratchStats ScratchFile::Stats() {
+    std::lock_guard<std::mutex> lock(gScratchMutex);
+    return gScratchStats;
+}
+
+}  // namespace audio_decoder
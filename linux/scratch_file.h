@@ -0,0 +1,102 @@
+#ifndef FLUTTER_PLUGIN_SCRATCH_FILE_H_
+#define FLUTTER_PLUGIN_SCRATCH_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace audio_decoder {
+
+/// Where scratch files go.
+struct ScratchConfig {
+    /// Directory for scratch that does not fit the memory budget.  Empty
+    /// means $TMPDIR, or /tmp if that is unset.
+    std::string spillDirectory;
+    /// Bytes of memory-backed scratch that may be live at once; 0 keeps
+    /// all scratch on disk.
+    uint64_t memoryBudget = 64 * 1024 * 1024;
+};
+
+struct ScratchStats {
+    uint64_t memoryFiles = 0;
+    uint64_t diskFiles = 0;
+    /// Memory-backed files that did not fit the budget and went to disk.
+    uint64_t spilled = 0;
+    /// Budget currently reserved by live memory-backed files, and its peak.
+    uint64_t memoryBytes = 0;
+    uint64_t peakMemoryBytes = 0;
+};
+
+/// A file without a name, for data that has to pass through a file (an
+/// element that only writes to a location, say).
+///
+/// Scratch lives in a memfd while the memory budget allows, else in an
+/// O_TMPFILE file in the spill directory, so it never shows up in a
+/// directory listing and disappears with the last descriptor, even if the
+/// process dies.  Only on file systems without O_TMPFILE is a named file
+/// created, and it is unlinked at once.  GStreamer elements reach the file
+/// through path().
+class ScratchFile {
+ public:
+    /// Creates scratch for about [expectedBytes], charged to the memory
+    /// budget until the file is destroyed.  Returns nullptr on failure.
+    static std::unique_ptr<ScratchFile> Create(uint64_t expectedBytes);
+
+    /// Creates an unnamed file in [directory], to be given its final name
+    /// with Publish().  Returns nullptr on failure.
+    static std::unique_ptr<ScratchFile> CreateIn(const std::string& directory);
+
+    ~ScratchFile();
+
+    ScratchFile(const ScratchFile&) = delete;
+    ScratchFile& operator=(const ScratchFile&) = delete;
+
+    int fd() const { return fd_; }
+    bool inMemory() const { return memory_; }
+
+    /// `/proc/self/fd/N`, which reopens this file.
+    std::string path() const;
+
+    /// Current size; 0 on error.
+    uint64_t size() const;
+
+    /// Appends [size] bytes at the file offset.  Returns false on I/O errors
+    /// or when a memory-backed file would outgrow the memory budget.
+    bool Write(const uint8_t* data, size_t size);
+
+    /// Grows the budget charged by a memory-backed file to [bytes], for data
+    /// written through path() rather than Write().  Returns false, charging
+    /// nothing, when that does not fit the memory budget.  Disk-backed files
+    /// always fit.
+    bool Reserve(uint64_t bytes);
+
+    /// Maps the whole file read-only.  Returns nullptr for an empty file or
+    /// on error; the mapping lives until the file is destroyed.
+    const uint8_t* Map();
+
+    /// Links the file (created with CreateIn) at [file], atomically
+    /// replacing whatever is there.  Returns false on failure.
+    bool Publish(const std::string& file);
+
+    static void Configure(const ScratchConfig& config);
+    static ScratchStats Stats();
+
+ private:
+    ScratchFile(int fd, bool memory, uint64_t reserved)
+        : fd_(fd), memory_(memory), reserved_(reserved) {}
+
+    int fd_;
+    bool memory_;
+    /// Budget charged by a memory-backed file.
+    uint64_t reserved_;
+    /// Name of a CreateIn file on a file system without O_TMPFILE, until
+    /// it is published or destroyed.
+    std::string name_;
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_SCRATCH_FILE_H_
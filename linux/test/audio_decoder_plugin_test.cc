@@ -1,7 +1,33 @@
+#include <fcntl.h>
 #include <flutter_linux/flutter_linux.h>
 #include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "include/audio_decoder/audio_decoder_plugin.h"
+#include "header_probe.h"
+#include "info_cache.h"
+#include "job_executor.h"
+#include "job_progress.h"
+#include "job_registry.h"
+#include "memory_source.h"
+#include "pcm_chunk.h"
+#include "pcm_stream.h"
+#include "scratch_file.h"
+#include "wav_writer.h"
+#include "waveform_accumulator.h"
+#include "waveform_kernels.h"
+#include "waveform_pyramid.h"
 
 // These tests verify that the plugin registers correctly.
 // Full method call testing requires a running Flutter engine,
@@ -13,3 +39,891 @@ TEST(AudioDecoderPlugin, PluginRegistration) {
               reinterpret_cast<void*>(
                   audio_decoder_plugin_register_with_registrar));
 }
+
+// TempDir() ends with a separator.
+static std::string TempPath(const std::string& name) {
+    return testing::TempDir() + name;
+}
+
+static std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+                                std::istreambuf_iterator<char>());
+}
+
+TEST(WavFileWriter, WritesChunksAndFinalHeader) {
+    std::string path = TempPath("audio_decoder_writer_test.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        writer.Append(audio_decoder::PcmChunk::FromBytes({1, 2, 3, 4}));
+        writer.Append(audio_decoder::PcmChunk::FromBytes({5, 6}).Slice(0, 2));
+        EXPECT_EQ(writer.dataSize(), 6u);
+        writer.Finalize(8000, 1, 16);
+    }
+
+    std::vector<uint8_t> bytes = ReadFile(path);
+    ASSERT_EQ(bytes.size(), audio_decoder::kWavHeaderSize + 6);
+    EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + 4), "RIFF");
+    EXPECT_EQ(bytes[40], 6);  // data chunk size
+    EXPECT_EQ(bytes[24] | (bytes[25] << 8), 8000);
+    EXPECT_EQ(bytes[44], 1);
+    EXPECT_EQ(bytes[49], 6);
+    std::remove(path.c_str());
+}
+
+TEST(WavFileWriter, WritesOutOnceItHoldsMaxChunks) {
+    std::string path = TempPath("audio_decoder_held.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        uint64_t calls = audio_decoder::WavFileWriter::Stats().writeCalls;
+        // Small chunks never reach the byte threshold, so the chunk count
+        // alone must release the buffers they pin.
+        for (size_t i = 0; i < audio_decoder::WavFileWriter::kMaxHeldChunks; i++) {
+            EXPECT_EQ(audio_decoder::WavFileWriter::Stats().writeCalls, calls);
+            writer.Append(audio_decoder::PcmChunk::FromBytes({1, 2}));
+        }
+        EXPECT_GT(audio_decoder::WavFileWriter::Stats().writeCalls, calls);
+        writer.Finalize(8000, 1, 16);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(WavFileWriter, RemovesFileWhenNotFinalized) {
+    std::string path = TempPath("audio_decoder_abort_test.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        writer.Append(audio_decoder::PcmChunk::FromBytes({1, 2}));
+    }
+    EXPECT_FALSE(std::ifstream(path).good());
+}
+
+TEST(WavFileWriter, PlacesPositionedWritesInOrder) {
+    std::string path = TempPath("audio_decoder_positioned.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        // Segments finishing out of order still land at their offsets.
+        writer.WriteAt(2, {audio_decoder::PcmChunk::FromBytes({3, 4})});
+        writer.WriteAt(0, {audio_decoder::PcmChunk::FromBytes({1, 2})});
+        EXPECT_EQ(writer.dataSize(), 4u);
+        writer.Finalize(8000, 1, 16);
+    }
+    std::vector<uint8_t> bytes = ReadFile(path);
+    ASSERT_EQ(bytes.size(), audio_decoder::kWavHeaderSize + 4);
+    EXPECT_EQ(bytes[40], 4);
+    EXPECT_EQ(bytes[44], 1);
+    EXPECT_EQ(bytes[47], 4);
+    std::remove(path.c_str());
+}
+
+TEST(WavMemoryWriter, FillsHeaderInPlaceOrLeavesItOut) {
+    audio_decoder::WavMemoryWriter wav;
+    wav.Reserve(4);
+    wav.WriteAt(2, {audio_decoder::PcmChunk::FromBytes({3, 4})});
+    wav.WriteAt(0, {audio_decoder::PcmChunk::FromBytes({1, 2})});
+    EXPECT_EQ(wav.dataSize(), 4u);
+    wav.Finalize(8000, 1, 16);
+    const std::vector<uint8_t>& bytes = wav.bytes();
+    ASSERT_EQ(bytes.size(), audio_decoder::kWavHeaderSize + 4);
+    EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + 4), "RIFF");
+    EXPECT_EQ(bytes[40], 4);
+    EXPECT_EQ(bytes[44], 1);
+    EXPECT_EQ(bytes[47], 4);
+
+    audio_decoder::WavMemoryWriter pcm(false);
+    pcm.Append(audio_decoder::PcmChunk::FromBytes({1, 2, 3}));
+    pcm.Finalize(8000, 1, 8);
+    EXPECT_EQ(pcm.bytes(), (std::vector<uint8_t>{1, 2, 3}));
+}
+
+TEST(WaveformAccumulator, MatchesWholeBufferRms) {
+    std::vector<int16_t> samples(1024);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<int16_t>(i < 512 ? 100 : 400);
+    }
+    audio_decoder::WaveformAccumulator accumulator(4);
+    accumulator.SetExpectedSamples(samples.size());
+    // Uneven chunks, as delivered by the decoder.
+    accumulator.Add(samples.data(), 333);
+    accumulator.Add(samples.data() + 333, 691);
+
+    auto waveform = accumulator.Finish();
+    ASSERT_EQ(waveform.size(), 4u);
+    EXPECT_DOUBLE_EQ(waveform[0], 0.25);
+    EXPECT_DOUBLE_EQ(waveform[1], 0.25);
+    EXPECT_DOUBLE_EQ(waveform[2], 1.0);
+    EXPECT_DOUBLE_EQ(waveform[3], 1.0);
+}
+
+TEST(WaveformAccumulator, RebinsWithoutKnownLength) {
+    std::vector<int16_t> samples(100000, 1000);
+    audio_decoder::WaveformAccumulator accumulator(10);
+    for (size_t i = 0; i < samples.size(); i += 4096) {
+        accumulator.Add(samples.data() + i,
+                        std::min<size_t>(4096, samples.size() - i));
+    }
+    EXPECT_EQ(accumulator.samples(), 100000u);
+    for (double value : accumulator.Finish()) {
+        EXPECT_DOUBLE_EQ(value, 1.0);
+    }
+}
+
+TEST(WaveformAccumulator, PadsEmptyInputWithZeros) {
+    audio_decoder::WaveformAccumulator accumulator(3);
+    EXPECT_EQ(accumulator.Finish(), std::vector<double>(3, 0.0));
+}
+
+TEST(WaveformKernels, VectorKernelsMatchScalar) {
+    using audio_decoder::KernelIsa;
+    using audio_decoder::SampleFormat;
+    // Odd length so every kernel also runs its scalar tail; includes the
+    // extreme values of each integer format.
+    const size_t count = 1003;
+    for (SampleFormat format : {SampleFormat::kS16, SampleFormat::kS24,
+                                SampleFormat::kS32, SampleFormat::kF32}) {
+        size_t width = audio_decoder::BytesPerSample(format);
+        std::vector<uint8_t> data(count * width);
+        for (size_t i = 0; i < count; i++) {
+            double v = std::sin(i * 0.37) * (i % 7 == 0 ? 1.0 : 0.5);
+            if (i == 10) v = -1.0;
+            if (format == SampleFormat::kF32) {
+                float f = static_cast<float>(v);
+                std::memcpy(&data[i * width], &f, width);
+            } else {
+                int64_t full = int64_t{1} << (width * 8 - 1);
+                int64_t raw = std::min<int64_t>(static_cast<int64_t>(v * full),
+                                                full - 1);
+                std::memcpy(&data[i * width], &raw, width);  // little-endian
+            }
+        }
+
+        auto expected = audio_decoder::ReduceSamples(format, data.data(), count,
+                                                     KernelIsa::kScalar);
+        EXPECT_DOUBLE_EQ(expected.min, -1.0);
+        for (KernelIsa isa : {KernelIsa::kSse2, KernelIsa::kAvx2}) {
+            auto actual = audio_decoder::ReduceSamples(format, data.data(),
+                                                       count, isa);
+            EXPECT_EQ(actual.count, count);
+            EXPECT_NEAR(actual.sumSquares, expected.sumSquares,
+                        1e-9 * expected.sumSquares);
+            EXPECT_NEAR(actual.sumAbs, expected.sumAbs, 1e-9 * expected.sumAbs);
+            EXPECT_DOUBLE_EQ(actual.min, expected.min);
+            EXPECT_DOUBLE_EQ(actual.max, expected.max);
+        }
+    }
+}
+
+TEST(WaveformAccumulator, NormalizesAcrossSampleFormats) {
+    std::vector<float> samples(1024);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = i < 512 ? 0.125f : 0.5f;
+    }
+    audio_decoder::WaveformAccumulator accumulator(2);
+    accumulator.Add(samples.data(), samples.size(),
+                    audio_decoder::SampleFormat::kF32);
+    auto waveform = accumulator.Finish();
+    EXPECT_DOUBLE_EQ(waveform[0], 0.25);
+    EXPECT_DOUBLE_EQ(waveform[1], 1.0);
+}
+
+TEST(WaveformPyramid, AnswersAnyResolutionFromSidecar) {
+    // One quiet quarter, then three loud ones.
+    std::vector<int16_t> samples(32768);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<int16_t>(i < 8192 ? 1000 : 4000);
+    }
+    audio_decoder::WaveformPyramidBuilder builder;
+    builder.Add(samples.data(), 10000, audio_decoder::SampleFormat::kS16);
+    builder.Add(samples.data() + 10000, 22768,
+                audio_decoder::SampleFormat::kS16);
+
+    audio_decoder::PyramidKey key;
+    key.path = "/music/song.flac";
+    key.mtimeNs = 42;
+    key.size = 1234;
+    key.analysisRate = 8000;
+    std::string file = TempPath(key.SidecarName());
+    ASSERT_TRUE(audio_decoder::WaveformPyramid::WriteImage(
+        file, builder.Serialize(key, 8000)));
+
+    auto pyramid = audio_decoder::WaveformPyramid::Open(file, key);
+    ASSERT_NE(pyramid, nullptr);
+    EXPECT_EQ(pyramid->samples(), 32768u);
+    EXPECT_EQ(pyramid->sampleRate(), 8000u);
+
+    auto coarse = pyramid->Rms(0, 32768, 4);
+    ASSERT_EQ(coarse.size(), 4u);
+    EXPECT_NEAR(coarse[0], 0.25, 1e-6);
+    EXPECT_NEAR(coarse[3], 1.0, 1e-6);
+
+    // A sub-range at a finer resolution.
+    auto zoomed = pyramid->Rms(7680, 8960, 5);
+    EXPECT_NEAR(zoomed[0], 0.25, 1e-6);
+    EXPECT_NEAR(zoomed[1], 0.25, 1e-6);
+    EXPECT_NEAR(zoomed[2], 1.0, 1e-6);
+
+    // A changed source invalidates the sidecar.
+    key.mtimeNs = 43;
+    EXPECT_EQ(audio_decoder::WaveformPyramid::Open(file, key), nullptr);
+    std::remove(file.c_str());
+}
+
+TEST(WaveformPyramid, SegmentBuildersConcatenateToSerialBuild) {
+    std::vector<int16_t> samples(3 * audio_decoder::kPyramidBaseBinSamples + 100);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<int16_t>((i * 37) % 2000 - 1000);
+    }
+    const size_t split = 2 * audio_decoder::kPyramidBaseBinSamples;
+    audio_decoder::WaveformPyramidBuilder serial, first, second;
+    serial.Add(samples.data(), samples.size(), audio_decoder::SampleFormat::kS16);
+    first.Add(samples.data(), split, audio_decoder::SampleFormat::kS16);
+    second.Add(samples.data() + split, samples.size() - split,
+               audio_decoder::SampleFormat::kS16);
+    first.Append(second);
+
+    audio_decoder::PyramidKey key;
+    EXPECT_EQ(first.samples(), serial.samples());
+    EXPECT_EQ(first.Serialize(key, 8000), serial.Serialize(key, 8000));
+}
+
+TEST(JobExecutor, RunsEverySubmittedJob) {
+    auto& executor = audio_decoder::JobExecutor::Instance();
+    executor.SetWorkerCount(2);
+    std::atomic<int> ran{0};
+    std::atomic<size_t> maxQueued{0};
+    std::promise<void> done;
+    constexpr int kJobs = 100;
+    for (int i = 0; i < kJobs; i++) {
+        executor.Submit([&]() {
+            // A job taken as soon as it is queued must not drive the
+            // queued count below zero.
+            size_t queued = executor.Stats().queued;
+            size_t seen = maxQueued.load();
+            while (seen < queued && !maxQueued.compare_exchange_weak(seen, queued)) {
+            }
+            if (++ran == kJobs) done.set_value();
+        });
+    }
+    done.get_future().wait();
+    EXPECT_EQ(ran.load(), kJobs);
+    EXPECT_LE(maxQueued.load(), static_cast<size_t>(kJobs));
+    audio_decoder::JobExecutorStats stats = executor.Stats();
+    EXPECT_EQ(stats.workers, 2u);
+    EXPECT_GE(stats.submitted, static_cast<uint64_t>(kJobs));
+    executor.SetWorkerCount(0);
+}
+
+TEST(JobExecutor, NestedParallelForCompletesOnSingleWorker) {
+    auto& executor = audio_decoder::JobExecutor::Instance();
+    executor.SetWorkerCount(1);
+    std::vector<int> parts(8, 0);
+    std::promise<void> done;
+    executor.Submit([&]() {
+        executor.ParallelFor(parts.size(), [&](size_t i) { parts[i] = 1; });
+        done.set_value();
+    });
+    done.get_future().wait();
+    EXPECT_EQ(parts, std::vector<int>(8, 1));
+
+    EXPECT_THROW(executor.ParallelFor(3, [](size_t i) {
+                     if (i == 2) throw std::runtime_error("part failed");
+                 }),
+                 std::runtime_error);
+    executor.SetWorkerCount(0);
+}
+
+TEST(JobRegistry, CancelRunsHooksOfRegisteredJob) {
+    auto& registry = audio_decoder::JobRegistry::Instance();
+    auto token = registry.Register("registry-test");
+    ASSERT_NE(token, nullptr);
+    EXPECT_EQ(registry.Register("registry-test"), nullptr);
+
+    int fired = 0;
+    {
+        auto expired = token->OnCancel([&]() { fired += 10; });
+    }
+    auto hook = token->OnCancel([&]() { fired++; });
+    EXPECT_TRUE(registry.Cancel("registry-test"));
+    EXPECT_TRUE(token->cancelled());
+    EXPECT_THROW(token->ThrowIfCancelled(), audio_decoder::JobCancelledError);
+    EXPECT_EQ(fired, 1);
+
+    // Hooks added after the fact run right away.
+    auto late = token->OnCancel([&]() { fired++; });
+    EXPECT_EQ(fired, 2);
+
+    registry.Unregister("registry-test");
+    EXPECT_FALSE(registry.Cancel("registry-test"));
+}
+
+TEST(JobProgress, RateLimitsReportsAndFinishesOnce) {
+    std::vector<audio_decoder::ProgressSnapshot> reports;
+    audio_decoder::JobProgress progress(
+        [&](const audio_decoder::ProgressSnapshot& s) { reports.push_back(s); },
+        std::chrono::hours(1));
+    progress.SetDuration(4000);
+    // Nothing is due until the interval has passed.
+    for (int i = 0; i < 4; i++) progress.Advance(1000, 10);
+    EXPECT_TRUE(reports.empty());
+
+    progress.Finish();
+    progress.Finish();
+    progress.Advance(1000, 10);
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_TRUE(reports[0].done);
+    EXPECT_EQ(reports[0].positionNs, 4000u);
+    EXPECT_EQ(reports[0].durationNs, 4000u);
+    EXPECT_EQ(reports[0].bytesWritten, 40u);
+
+    audio_decoder::JobProgress unthrottled(
+        [&](const audio_decoder::ProgressSnapshot& s) { reports.push_back(s); },
+        std::chrono::milliseconds(0));
+    unthrottled.Set(500, 5);
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_FALSE(reports[1].done);
+    EXPECT_EQ(reports[1].positionNs, 500u);
+}
+
+TEST(MemorySource, RegistersUniqueUrisWhileAlive) {
+    const uint8_t data[4] = {1, 2, 3, 4};
+    uint64_t inputs = audio_decoder::MemorySource::Stats().inputs;
+    std::string first;
+    {
+        audio_decoder::MemorySource a(data, sizeof(data), nullptr, "mp3");
+        audio_decoder::MemorySource b(data, sizeof(data), nullptr, "");
+        first = a.uri();
+        EXPECT_NE(a.uri(), b.uri());
+        EXPECT_TRUE(audio_decoder::MemorySource::IsMemoryUri(a.uri()));
+        EXPECT_EQ(a.uri().substr(a.uri().size() - 4), ".mp3");
+    }
+    EXPECT_FALSE(audio_decoder::MemorySource::IsMemoryUri("file:///tmp/a.mp3"));
+    EXPECT_EQ(audio_decoder::MemorySource::Stats().inputs, inputs + 2);
+    // A source that is gone can no longer be attached.
+    EXPECT_FALSE(audio_decoder::MemorySource::Attach(first, nullptr));
+}
+
+TEST(PcmStream, CutsWholeFramesAndWaitsForCredit) {
+    std::vector<std::pair<size_t, uint64_t>> sent;
+    audio_decoder::PcmStream stream(10, std::chrono::milliseconds(0),
+        [&](const uint8_t*, size_t size, uint64_t frameOffset) {
+            sent.emplace_back(size, frameOffset);
+        });
+    stream.SetFrameSize(4);  // 10-byte chunks round down to 8.
+    stream.Grant(2);
+    const uint8_t data[20] = {};
+    ASSERT_TRUE(stream.Push(data, 16));
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1], std::make_pair(size_t{8}, uint64_t{2}));
+
+    // Out of credit: the next chunk is sent only once one is granted.
+    std::future<bool> pushed = std::async(std::launch::async,
+        [&] { return stream.Push(data, 12); });
+    EXPECT_EQ(pushed.wait_for(std::chrono::milliseconds(50)),
+              std::future_status::timeout);
+    stream.Grant(1);
+    EXPECT_TRUE(pushed.get());
+    EXPECT_EQ(sent.size(), 3u);
+
+    // Close wakes a waiting flush and fails it.
+    std::future<bool> flushed = std::async(std::launch::async,
+        [&] { return stream.Flush(); });
+    stream.Close();
+    EXPECT_FALSE(flushed.get());
+    EXPECT_EQ(sent.size(), 3u);
+}
+
+TEST(PcmStream, ClosesWhenNoCreditArrivesInTime) {
+    size_t sent = 0;
+    audio_decoder::PcmStream stream(4, std::chrono::milliseconds(20),
+        [&](const uint8_t*, size_t, uint64_t) { sent++; });
+    uint64_t timeouts = audio_decoder::PcmStream::Stats().timeouts;
+    stream.Grant(1);
+    const uint8_t data[8] = {};
+    EXPECT_FALSE(stream.Push(data, 8));
+    EXPECT_EQ(sent, 1u);
+    EXPECT_TRUE(stream.timedOut());
+    EXPECT_EQ(audio_decoder::PcmStream::Stats().timeouts, timeouts + 1);
+
+    // Credit granted after the timeout does not reopen the stream.
+    stream.Grant(1);
+    EXPECT_FALSE(stream.Flush());
+}
+
+TEST(ScratchFile, KeepsScratchInMemoryWithinBudget) {
+    audio_decoder::ScratchConfig config;
+    config.spillDirectory = testing::TempDir();
+    config.memoryBudget = 100;
+    audio_decoder::ScratchFile::Configure(config);
+    uint64_t spilled = audio_decoder::ScratchFile::Stats().spilled;
+    {
+        auto first = audio_decoder::ScratchFile::Create(60);
+        auto second = audio_decoder::ScratchFile::Create(60);
+        ASSERT_TRUE(first && second);
+        EXPECT_TRUE(first->inMemory());
+        EXPECT_FALSE(second->inMemory());
+        EXPECT_EQ(audio_decoder::ScratchFile::Stats().spilled, spilled + 1);
+        EXPECT_EQ(audio_decoder::ScratchFile::Stats().memoryBytes, 60u);
+
+        // Both are reachable by path, as a GStreamer sink would write them.
+        const char text[] = "scratch";
+        FILE* out = fopen(second->path().c_str(), "wb");
+        ASSERT_NE(out, nullptr);
+        fwrite(text, 1, 7, out);
+        fclose(out);
+        ASSERT_EQ(second->size(), 7u);
+        EXPECT_EQ(std::memcmp(second->Map(), text, 7), 0);
+    }
+    EXPECT_EQ(audio_decoder::ScratchFile::Stats().memoryBytes, 0u);
+    audio_decoder::ScratchFile::Configure(audio_decoder::ScratchConfig());
+}
+
+TEST(ScratchFile, WritesStayWithinMemoryBudget) {
+    audio_decoder::ScratchConfig config;
+    config.memoryBudget = 100;
+    audio_decoder::ScratchFile::Configure(config);
+    {
+        auto file = audio_decoder::ScratchFile::Create(10);
+        ASSERT_TRUE(file && file->inMemory());
+        // Outgrowing the estimate is charged while the budget allows it.
+        std::vector<uint8_t> data(80, 1);
+        EXPECT_TRUE(file->Write(data.data(), data.size()));
+        EXPECT_EQ(audio_decoder::ScratchFile::Stats().memoryBytes, 80u);
+        EXPECT_FALSE(file->Write(data.data(), data.size()));
+        EXPECT_EQ(file->size(), 80u);
+        EXPECT_FALSE(file->Reserve(101));
+        EXPECT_TRUE(file->Reserve(100));
+        EXPECT_EQ(audio_decoder::ScratchFile::Stats().memoryBytes, 100u);
+    }
+    EXPECT_EQ(audio_decoder::ScratchFile::Stats().memoryBytes, 0u);
+    audio_decoder::ScratchFile::Configure(audio_decoder::ScratchConfig());
+}
+
+TEST(ScratchFile, PublishReplacesFileAtomically) {
+    std::string path = TempPath("audio_decoder_publish.bin");
+    std::ofstream(path) << "old";
+    auto file = audio_decoder::ScratchFile::CreateIn(testing::TempDir());
+    ASSERT_TRUE(file);
+    const uint8_t data[3] = {'n', 'e', 'w'};
+    ASSERT_TRUE(file->Write(data, sizeof(data)));
+    ASSERT_TRUE(file->Publish(path));
+    std::vector<uint8_t> contents = ReadFile(path);
+    EXPECT_EQ(std::string(contents.begin(), contents.end()), "new");
+    std::remove(path.c_str());
+}
+
+TEST(AudioInfoCache, HitsUntilFileChangesAndEvictsLeastRecent) {
+    std::string path = TempPath("audio_decoder_info.wav");
+    std::string other = TempPath("audio_decoder_info2.wav");
+    std::ofstream(path) << "RIFF";
+    std::ofstream(other) << "RIFF";
+    audio_decoder::FileKey key, otherKey;
+    ASSERT_TRUE(audio_decoder::FileKey::ForPath(path, &key));
+    ASSERT_TRUE(audio_decoder::FileKey::ForPath(other, &otherKey));
+    EXPECT_FALSE(audio_decoder::FileKey::ForPath(path + ".missing", &key));
+
+    audio_decoder::AudioInfoCache cache(1);
+    audio_decoder::AudioInfoRecord record;
+    record.durationMs = 1500;
+    record.sampleRate = 44100;
+    record.channels = 2;
+    record.format = "wav";
+    audio_decoder::AudioInfoRecord found;
+    EXPECT_FALSE(cache.Lookup(key, &found));
+    cache.Insert(key, record);
+    ASSERT_TRUE(cache.Lookup(key, &found));
+    EXPECT_EQ(found.durationMs, 1500);
+    EXPECT_EQ(found.format, "wav");
+
+    // A changed file misses and drops its entry.
+    std::ofstream(path, std::ios::app) << "more";
+    audio_decoder::FileKey changed;
+    ASSERT_TRUE(audio_decoder::FileKey::ForPath(path, &changed));
+    EXPECT_FALSE(cache.Lookup(changed, &found));
+    EXPECT_EQ(cache.Stats().stale, 1u);
+    EXPECT_EQ(cache.Stats().entries, 0u);
+
+    cache.Insert(changed, record);
+    cache.Insert(otherKey, record);
+    EXPECT_EQ(cache.Stats().evictions, 1u);
+    EXPECT_FALSE(cache.Lookup(changed, &found));
+    EXPECT_TRUE(cache.Lookup(otherKey, &found));
+    EXPECT_EQ(cache.Stats().hits, 2u);
+    std::remove(path.c_str());
+    std::remove(other.c_str());
+}
+
+TEST(AudioInfoCache, IndexFileSurvivesRestart) {
+    std::string path = TempPath("audio_decoder_info.flac");
+    std::string index = TempPath("audio_decoder_info.idx");
+    std::ofstream(path) << "fLaC";
+    std::remove(index.c_str());
+    audio_decoder::FileKey key;
+    ASSERT_TRUE(audio_decoder::FileKey::ForPath(path, &key));
+    audio_decoder::AudioInfoRecord record;
+    record.durationMs = 42;
+    record.bitRate = 900000;
+    record.format = "Free Lossless Audio Codec (FLAC)";
+    {
+        audio_decoder::AudioInfoCache cache(16);
+        cache.SetIndexFile(index);
+        cache.Insert(key, record);
+        ASSERT_TRUE(cache.Flush());
+    }
+    audio_decoder::AudioInfoCache restarted(16);
+    restarted.SetIndexFile(index);
+    audio_decoder::AudioInfoRecord found;
+    ASSERT_TRUE(restarted.Lookup(key, &found));
+    EXPECT_EQ(found.durationMs, 42);
+    EXPECT_EQ(found.bitRate, 900000);
+    EXPECT_EQ(found.format, "Free Lossless Audio Codec (FLAC)");
+    std::remove(path.c_str());
+    std::remove(index.c_str());
+}
+
+static void PutBe(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+static void PutLe(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+static std::vector<uint8_t> Mp4Box(const char* type,
+                                   const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> box;
+    PutBe(box, body.size() + 8, 4);
+    box.insert(box.end(), type, type + 4);
+    box.insert(box.end(), body.begin(), body.end());
+    return box;
+}
+
+TEST(HeaderProbe, ReadsPcmWavAndAiffHeaders) {
+    // One second of 44.1 kHz stereo 16-bit PCM.
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F'};
+    PutLe(wav, 36 + 176400, 4);
+    wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    PutLe(wav, 16, 4);
+    PutLe(wav, 1, 2);
+    PutLe(wav, 2, 2);
+    PutLe(wav, 44100, 4);
+    PutLe(wav, 176400, 4);
+    PutLe(wav, 4, 2);
+    PutLe(wav, 16, 2);
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    PutLe(wav, 176400, 4);
+    wav.resize(wav.size() + 176400);
+
+    std::string path = TempPath("audio_decoder_probe.wav");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(wav.data()), wav.size());
+    }
+    audio_decoder::AudioInfoRecord record;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ProbeFile(path, &record));
+    EXPECT_EQ(record.format, "wav");
+    EXPECT_EQ(record.durationMs, 1000);
+    EXPECT_EQ(record.sampleRate, 44100);
+    EXPECT_EQ(record.channels, 2);
+    EXPECT_EQ(record.bitRate, 1411200);
+    std::remove(path.c_str());
+
+    // Half a second of 22.05 kHz mono; the rate is an 80-bit float.
+    std::vector<uint8_t> aiff = {'F', 'O', 'R', 'M'};
+    PutBe(aiff, 4 + 26, 4);
+    aiff.insert(aiff.end(), {'A', 'I', 'F', 'F', 'C', 'O', 'M', 'M'});
+    PutBe(aiff, 18, 4);
+    PutBe(aiff, 1, 2);
+    PutBe(aiff, 11025, 4);
+    PutBe(aiff, 16, 2);
+    PutBe(aiff, 16383 + 14, 2);
+    PutBe(aiff, 22050ULL << (63 - 14), 8);
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ProbeMemory(
+        aiff.data(), aiff.size(), &record));
+    EXPECT_EQ(record.format, "aiff");
+    EXPECT_EQ(record.durationMs, 500);
+    EXPECT_EQ(record.sampleRate, 22050);
+    EXPECT_EQ(record.channels, 1);
+}
+
+TEST(HeaderProbe, ReadsFlacStreamInfoAndMp3XingHeader) {
+    // Two seconds of 48 kHz stereo 24-bit audio, followed by 1000 bytes.
+    std::vector<uint8_t> flac = {'f', 'L', 'a', 'C', 0x80, 0, 0, 34};
+    flac.resize(flac.size() + 10);
+    PutBe(flac, 48000ULL << 44 | 1ULL << 41 | 23ULL << 36 | 96000, 8);
+    flac.resize(flac.size() + 16 + 1000);
+    audio_decoder::AudioInfoRecord record;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ProbeMemory(
+        flac.data(), flac.size(), &record));
+    EXPECT_EQ(record.format, "flac");
+    EXPECT_EQ(record.durationMs, 2000);
+    EXPECT_EQ(record.sampleRate, 48000);
+    EXPECT_EQ(record.channels, 2);
+    EXPECT_EQ(record.bitRate, 4000);
+
+    // An ID3v2 tag, then a 128 kbps MPEG-1 Layer III Xing frame with a LAME
+    // tag and the next frame.
+    std::vector<uint8_t> mp3 = {'I', 'D', '3', 3, 0, 0, 0, 0, 0, 10};
+    mp3.resize(20);
+    size_t frame = mp3.size();
+    mp3.insert(mp3.end(), {0xFF, 0xFB, 0x90, 0x44});
+    mp3.resize(frame + 36);
+    mp3.insert(mp3.end(), {'X', 'i', 'n', 'g'});
+    PutBe(mp3, 0x3, 4);
+    PutBe(mp3, 100, 4);
+    PutBe(mp3, 41700, 4);
+    mp3.insert(mp3.end(), {'L', 'A', 'M', 'E', '3', '.', '1', '0', '0'});
+    mp3.resize(frame + 52 + 21);
+    PutBe(mp3, 576 << 12 | 1000, 3);
+    mp3.resize(frame + 417);
+    mp3.insert(mp3.end(), {0xFF, 0xFB, 0x90, 0x44});
+    mp3.resize(frame + 417 * 2);
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ProbeMemory(
+        mp3.data(), mp3.size(), &record));
+    EXPECT_EQ(record.format, "mp3");
+    // 100 frames of 1152 samples less the encoder delay and padding.
+    EXPECT_EQ(record.durationMs, (100 * 1152 - 1576) * 1000 / 44100);
+    EXPECT_EQ(record.sampleRate, 44100);
+    EXPECT_EQ(record.channels, 2);
+    EXPECT_NEAR(record.bitRate, 129476, 1);
+}
+
+TEST(HeaderProbe, ReadsMp4SoundTrackAndRejectsOtherInput) {
+    std::vector<uint8_t> hdlr(8, 0);
+    hdlr.insert(hdlr.end(), {'s', 'o', 'u', 'n'});
+    hdlr.resize(hdlr.size() + 13);
+    std::vector<uint8_t> mdhd(12, 0);
+    PutBe(mdhd, 44100, 4);
+    PutBe(mdhd, 3 * 44100, 4);
+    PutBe(mdhd, 0, 4);
+    std::vector<uint8_t> esds = {0, 0, 0, 0, 0x03, 0x19, 0, 1, 0,
+                                 0x04, 0x11, 0x40, 0x15, 0, 0, 0};
+    PutBe(esds, 160000, 4);
+    PutBe(esds, 128000, 4);
+    std::vector<uint8_t> mp4a(6, 0);
+    PutBe(mp4a, 1, 2);
+    mp4a.resize(mp4a.size() + 8);
+    PutBe(mp4a, 2, 2);
+    PutBe(mp4a, 16, 2);
+    PutBe(mp4a, 0, 4);
+    PutBe(mp4a, 44100 << 16, 4);
+    std::vector<uint8_t> esdsBox = Mp4Box("esds", esds);
+    mp4a.insert(mp4a.end(), esdsBox.begin(), esdsBox.end());
+    std::vector<uint8_t> stsd = {0, 0, 0, 0, 0, 0, 0, 1};
+    std::vector<uint8_t> entry = Mp4Box("mp4a", mp4a);
+    stsd.insert(stsd.end(), entry.begin(), entry.end());
+    std::vector<uint8_t> minf = Mp4Box("stbl", Mp4Box("stsd", stsd));
+    std::vector<uint8_t> mdia = Mp4Box("hdlr", hdlr);
+    std::vector<uint8_t> mdhdBox = Mp4Box("mdhd", mdhd);
+    std::vector<uint8_t> minfBox = Mp4Box("minf", minf);
+    mdia.insert(mdia.end(), mdhdBox.begin(), mdhdBox.end());
+    mdia.insert(mdia.end(), minfBox.begin(), minfBox.end());
+
+    std::vector<uint8_t> m4a = Mp4Box("ftyp", {'M', '4', 'A', ' ', 0, 0, 0, 0});
+    std::vector<uint8_t> mdat = Mp4Box("mdat", std::vector<uint8_t>(100));
+    std::vector<uint8_t> moov = Mp4Box("moov", Mp4Box("trak", Mp4Box("mdia", mdia)));
+    // The movie box may follow the media data.
+    m4a.insert(m4a.end(), mdat.begin(), mdat.end());
+    m4a.insert(m4a.end(), moov.begin(), moov.end());
+    audio_decoder::AudioInfoRecord record;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ProbeMemory(
+        m4a.data(), m4a.size(), &record));
+    EXPECT_EQ(record.format, "aac");
+    EXPECT_EQ(record.durationMs, 3000);
+    EXPECT_EQ(record.sampleRate, 44100);
+    EXPECT_EQ(record.channels, 2);
+    EXPECT_EQ(record.bitRate, 128000);
+
+    // Other containers are not scanned for MPEG frames, even when their
+    // data holds two matching frame headers in a row.
+    uint64_t unrecognized = audio_decoder::HeaderProbe::Stats().unrecognized;
+    const std::vector<std::vector<uint8_t>> others = {
+        {'O', 'g', 'g', 'S', 0, 2, 0, 0, 0, 0, 0, 0},
+        {0x1A, 0x45, 0xDF, 0xA3, 0x9F, 0x42, 0x86, 0x81, 1, 0x42, 0xF7, 0x81},
+        {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'A', 'V', 'I', ' '},
+    };
+    for (std::vector<uint8_t> other : others) {
+        other.resize(100);
+        other.insert(other.end(), {0xFF, 0xFB, 0x90, 0x44});
+        other.resize(100 + 417);
+        other.insert(other.end(), {0xFF, 0xFB, 0x90, 0x44});
+        other.resize(4096);
+        EXPECT_FALSE(audio_decoder::HeaderProbe::ProbeMemory(
+            other.data(), other.size(), &record));
+    }
+    EXPECT_EQ(audio_decoder::HeaderProbe::Stats().unrecognized,
+              unrecognized + others.size());
+}
+
+TEST(WavFileWriter, CopiesPcmRangeFromMatchingWav) {
+    // 1000 stereo 16-bit frames behind a LIST chunk.
+    std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 0, 0, 0, 0,
+                                'W', 'A', 'V', 'E', 'f', 'm', 't', ' '};
+    PutLe(wav, 16, 4);
+    PutLe(wav, 1, 2);
+    PutLe(wav, 2, 2);
+    PutLe(wav, 8000, 4);
+    PutLe(wav, 32000, 4);
+    PutLe(wav, 4, 2);
+    PutLe(wav, 16, 2);
+    wav.insert(wav.end(), {'L', 'I', 'S', 'T', 3, 0, 0, 0, 'a', 'b', 'c', 0});
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    PutLe(wav, 4000, 4);
+    size_t dataOffset = wav.size();
+    for (int i = 0; i < 4000; i++) wav.push_back(static_cast<uint8_t>(i * 7));
+
+    std::string input = TempPath("audio_decoder_passthrough_in.wav");
+    std::string output = TempPath("audio_decoder_passthrough_out.wav");
+    {
+        std::ofstream out(input, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(wav.data()), wav.size());
+    }
+    int fd = open(input.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    audio_decoder::WavLayout layout;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ReadPcmWavLayout(fd, &layout));
+    EXPECT_EQ(layout.dataOffset, dataOffset);
+    EXPECT_EQ(layout.dataSize, 4000u);
+    EXPECT_EQ(layout.bitsPerSample, 16);
+
+    // Frames 100 to 600, behind a plain 44-byte header.
+    {
+        audio_decoder::WavFileWriter writer(output);
+        writer.CopyFrom(fd, layout.dataOffset + 100 * 4, 500 * 4);
+        EXPECT_EQ(writer.dataSize(), 2000u);
+        writer.Finalize(8000, 2, 16);
+    }
+    close(fd);
+    std::vector<uint8_t> copied = ReadFile(output);
+    ASSERT_EQ(copied.size(), audio_decoder::kWavHeaderSize + 2000);
+    uint8_t header[audio_decoder::kWavHeaderSize];
+    audio_decoder::FillWavHeader(header, 2000, 8000, 2, 16);
+    EXPECT_EQ(std::memcmp(copied.data(), header, sizeof(header)), 0);
+    EXPECT_TRUE(std::equal(copied.begin() + sizeof(header), copied.end(),
+                           wav.begin() + dataOffset + 400));
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(WavFileWriter, ReservesRf64HeaderForLargeOutput) {
+    std::string path = TempPath("audio_decoder_rf64.wav");
+    std::vector<uint8_t> pcm(4000, 0x5A);
+    {
+        audio_decoder::WavFileWriter writer(path);
+        // Announced near the WAV limit: the ds64 slot is kept from the start
+        // as a JUNK chunk, so the file stays a plain WAV while it fits.
+        writer.Reserve(audio_decoder::kMaxWavDataSize);
+        writer.Append(audio_decoder::PcmChunk::FromBytes(pcm));
+        writer.Finalize(8000, 2, 16);
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    audio_decoder::WavLayout layout;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ReadPcmWavLayout(fd, &layout));
+    EXPECT_EQ(layout.dataOffset, audio_decoder::kRf64HeaderSize);
+    EXPECT_EQ(layout.dataSize, pcm.size());
+    uint8_t junk[4];
+    ASSERT_EQ(pread(fd, junk, 4, 12), 4);
+    EXPECT_EQ(std::memcmp(junk, "JUNK", 4), 0);
+    close(fd);
+    std::remove(path.c_str());
+
+    // Past 4 GB the same header becomes RF64 with the sizes in ds64.
+    uint8_t header[audio_decoder::kRf64HeaderSize];
+    uint64_t dataSize = 5ULL << 30;
+    audio_decoder::FillRf64Header(header, dataSize, 48000, 2, 24);
+    EXPECT_EQ(std::memcmp(header, "RF64", 4), 0);
+    EXPECT_EQ(std::memcmp(header + 12, "ds64", 4), 0);
+    uint64_t ds64DataSize;
+    std::memcpy(&ds64DataSize, header + 28, 8);
+    EXPECT_EQ(ds64DataSize, dataSize);
+    uint64_t frames;
+    std::memcpy(&frames, header + 36, 8);
+    EXPECT_EQ(frames, dataSize / 6);
+    EXPECT_EQ(std::memcmp(header + 72, "data\xff\xff\xff\xff", 8), 0);
+}
+
+TEST(WavFileWriter, PreallocatesAndTruncatesWithDirectAppends) {
+    audio_decoder::WavWriterConfig config;
+    config.directIo = true;
+    config.directMinBytes = 1;
+    audio_decoder::WavFileWriter::Configure(config);
+    audio_decoder::WavWriterStats before = audio_decoder::WavFileWriter::Stats();
+
+    // More than one direct buffer, ending on an unaligned tail, in a file
+    // preallocated for twice as much.
+    std::vector<uint8_t> pcm(5 * 1024 * 1024 + 1234);
+    for (size_t i = 0; i < pcm.size(); i++) pcm[i] = static_cast<uint8_t>(i * 31);
+    std::string path = TempPath("audio_decoder_direct.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        writer.Reserve(pcm.size() * 2);
+        for (size_t offset = 0; offset < pcm.size(); offset += 100000) {
+            size_t size = std::min<size_t>(100000, pcm.size() - offset);
+            writer.Append(audio_decoder::PcmChunk::FromBytes(
+                std::vector<uint8_t>(pcm.begin() + offset,
+                                     pcm.begin() + offset + size)));
+        }
+        writer.Finalize(48000, 2, 16);
+    }
+    audio_decoder::WavFileWriter::Configure(audio_decoder::WavWriterConfig());
+
+    std::vector<uint8_t> written = ReadFile(path);
+    ASSERT_EQ(written.size(), audio_decoder::kWavHeaderSize + pcm.size());
+    uint8_t header[audio_decoder::kWavHeaderSize];
+    audio_decoder::FillWavHeader(header, static_cast<uint32_t>(pcm.size()),
+                                 48000, 2, 16);
+    EXPECT_EQ(std::memcmp(written.data(), header, sizeof(header)), 0);
+    EXPECT_TRUE(std::equal(pcm.begin(), pcm.end(),
+                           written.begin() + sizeof(header)));
+
+    audio_decoder::WavWriterStats after = audio_decoder::WavFileWriter::Stats();
+    EXPECT_EQ(after.files, before.files + 1);
+    EXPECT_GE(after.bytes - before.bytes, pcm.size());
+    EXPECT_GT(after.writeCalls, before.writeCalls);
+    std::remove(path.c_str());
+}
+
+TEST(WavFileWriter, WritesExtensibleHeaderForFloatSamples) {
+    // 100 stereo float frames.
+    std::vector<uint8_t> pcm(800);
+    for (size_t i = 0; i < pcm.size(); i++) pcm[i] = static_cast<uint8_t>(i * 13);
+    std::string path = TempPath("audio_decoder_float.wav");
+    {
+        audio_decoder::WavFileWriter writer(path);
+        writer.SetFloatSamples(true);
+        writer.Append(audio_decoder::PcmChunk::FromBytes(pcm));
+        // Too late to change the layout: the data is already in place.
+        writer.SetFloatSamples(false);
+        writer.Finalize(48000, 2, 32);
+    }
+    std::vector<uint8_t> wav = ReadFile(path);
+    ASSERT_EQ(wav.size(), audio_decoder::kWavFloatHeaderSize + pcm.size());
+    uint16_t formatTag, subformat;
+    std::memcpy(&formatTag, wav.data() + 20, 2);
+    std::memcpy(&subformat, wav.data() + 44, 2);
+    EXPECT_EQ(formatTag, 0xFFFE);
+    EXPECT_EQ(subformat, 3);
+    EXPECT_EQ(std::memcmp(wav.data() + 60, "fact", 4), 0);
+    uint32_t frames;
+    std::memcpy(&frames, wav.data() + 68, 4);
+    EXPECT_EQ(frames, 100u);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    audio_decoder::WavLayout layout;
+    ASSERT_TRUE(audio_decoder::HeaderProbe::ReadPcmWavLayout(fd, &layout));
+    close(fd);
+    EXPECT_TRUE(layout.floatSamples);
+    EXPECT_EQ(layout.dataOffset, audio_decoder::kWavFloatHeaderSize);
+    EXPECT_EQ(layout.dataSize, pcm.size());
+    EXPECT_TRUE(std::equal(pcm.begin(), pcm.end(),
+                           wav.begin() + audio_decoder::kWavFloatHeaderSize));
+    std::remove(path.c_str());
+
+    // In memory the header grows the same way, before any data.
+    audio_decoder::WavMemoryWriter memory;
+    memory.SetFloatSamples(true);
+    memory.Append(audio_decoder::PcmChunk::FromBytes(pcm));
+    memory.Finalize(48000, 2, 32);
+    ASSERT_EQ(memory.bytes().size(), wav.size());
+    EXPECT_TRUE(std::equal(wav.begin(), wav.end(), memory.bytes().begin()));
+}
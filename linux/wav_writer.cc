@@ -0,0 +1,521 @@
+#include "wav_writer.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace audio_decoder {
+
+/// O_DIRECT transfers must be aligned to the device's logical block size;
+/// a page covers every common device.
+static constexpr size_t kDirectAlign = 4096;
+static constexpr size_t kDirectBufferBytes = 4 * 1024 * 1024;
+
+static std::mutex gConfigMutex;
+static WavWriterConfig gConfig;
+
+static std::atomic<uint64_t> gFiles{0};
+static std::atomic<uint64_t> gBytes{0};
+static std::atomic<uint64_t> gWriteCalls{0};
+static std::atomic<uint64_t> gWriteMicros{0};
+static std::atomic<uint64_t> gPreallocatedBytes{0};
+static std::atomic<uint64_t> gDirectFiles{0};
+
+static WavWriterConfig CurrentConfig() {
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    return gConfig;
+}
+
+/// Makes the write system call [call], counting it, its time and the bytes
+/// it wrote.
+template <typename Call>
+static ssize_t CountedWrite(Call call) {
+    auto started = std::chrono::steady_clock::now();
+    ssize_t n = call();
+    gWriteMicros += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count());
+    gWriteCalls++;
+    if (n > 0) gBytes += static_cast<uint64_t>(n);
+    return n;
+}
+
+static void PutLe16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void PutLe32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+static void PutLe64(uint8_t* p, uint64_t v) {
+    PutLe32(p, static_cast<uint32_t>(v));
+    PutLe32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+static constexpr uint16_t kFormatPcm = 1;
+static constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+/// KSDATAFORMAT_SUBTYPE_IEEE_FLOAT, as stored in the file.
+static const uint8_t kIeeeFloatSubformat[16] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+/// Speaker positions for [channels] in the order decoders interleave them;
+/// 0 (no assignment) beyond stereo.
+static uint32_t ChannelMask(uint16_t channels) {
+    if (channels == 1) return 0x4;  // front centre
+    if (channels == 2) return 0x3;  // front left, front right
+    return 0;
+}
+
+void FillWavHeader(uint8_t* header, uint32_t dataSize, uint32_t sampleRate,
+                   uint16_t channels, uint16_t bitsPerSample) {
+    FillWavHeader(header, WavHeaderLayout{}, dataSize, sampleRate, channels,
+                  bitsPerSample);
+}
+
+void FillRf64Header(uint8_t* header, uint64_t dataSize, uint32_t sampleRate,
+                    uint16_t channels, uint16_t bitsPerSample) {
+    WavHeaderLayout layout;
+    layout.rf64 = true;
+    FillWavHeader(header, layout, dataSize, sampleRate, channels,
+                  bitsPerSample);
+}
+
+void FillWavHeader(uint8_t* header, const WavHeaderLayout& layout,
+                   uint64_t dataSize, uint32_t sampleRate, uint16_t channels,
+                   uint16_t bitsPerSample) {
+    uint64_t riffSize = layout.size() - 8 + dataSize;
+    bool rf64 = layout.rf64 && riffSize > 0xFFFFFFFFULL;
+    uint16_t blockAlign = channels * bitsPerSample / 8;
+    uint64_t frames = blockAlign ? dataSize / blockAlign : 0;
+
+    uint8_t* p = header;
+    std::memcpy(p, rf64 ? "RF64" : "RIFF", 4);
+    PutLe32(p + 4, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(riffSize));
+    std::memcpy(p + 8, "WAVE", 4);
+    p += 12;
+    if (layout.rf64) {
+        // A JUNK chunk of the same size keeps the place until it is needed.
+        std::memcpy(p, rf64 ? "ds64" : "JUNK", 4);
+        PutLe32(p + 4, 28);
+        std::memset(p + 8, 0, 28);
+        if (rf64) {
+            PutLe64(p + 8, riffSize);
+            PutLe64(p + 16, dataSize);
+            PutLe64(p + 24, frames);
+            // No table entries follow.
+        }
+        p += 36;
+    }
+
+    std::memcpy(p, "fmt ", 4);
+    PutLe32(p + 4, layout.floatSamples ? 40 : 16);
+    PutLe16(p + 8, layout.floatSamples ? kFormatExtensible : kFormatPcm);
+    PutLe16(p + 10, channels);
+    PutLe32(p + 12, sampleRate);
+    PutLe32(p + 16, sampleRate * blockAlign);
+    PutLe16(p + 20, blockAlign);
+    PutLe16(p + 22, bitsPerSample);
+    p += 24;
+    if (layout.floatSamples) {
+        PutLe16(p, 22);  // extension size
+        PutLe16(p + 2, bitsPerSample);  // valid bits
+        PutLe32(p + 4, ChannelMask(channels));
+        std::memcpy(p + 8, kIeeeFloatSubformat, sizeof(kIeeeFloatSubformat));
+        p += 24;
+        // Non-PCM formats carry the frame count; RF64 keeps it in ds64.
+        std::memcpy(p, "fact", 4);
+        PutLe32(p + 4, 4);
+        PutLe32(p + 8, rf64 || frames > 0xFFFFFFFFULL
+                           ? 0xFFFFFFFF : static_cast<uint32_t>(frames));
+        p += 12;
+    }
+    std::memcpy(p, "data", 4);
+    PutLe32(p + 4, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(dataSize));
+}
+
+/// Writes all of [data] at [offset], retrying on short writes and EINTR.
+static bool PwriteAll(int fd, const uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = CountedWrite([&] { return pwrite(fd, data, size, offset); });
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+/// Writes all of [iov], continuing after short writes and EINTR.  Writes at
+/// the file offset if [offset] is negative, else at [offset] with pwritev().
+static bool WriteAllV(int fd, std::vector<struct iovec>& iov, off_t offset) {
+    size_t index = 0;
+    while (index < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - index, IOV_MAX));
+        ssize_t n = CountedWrite([&] {
+            return offset < 0 ? writev(fd, iov.data() + index, count)
+                              : pwritev(fd, iov.data() + index, count, offset);
+        });
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (offset >= 0) offset += n;
+        // Skip fully written vectors and advance into a partially written one.
+        size_t written = static_cast<size_t>(n);
+        while (index < iov.size() && written >= iov[index].iov_len) {
+            written -= iov[index].iov_len;
+            index++;
+        }
+        if (index < iov.size()) {
+            iov[index].iov_base = static_cast<uint8_t*>(iov[index].iov_base) + written;
+            iov[index].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+/// Builds the iovec list for [chunks].
+static std::vector<struct iovec> ChunkVectors(const std::vector<PcmChunk>& chunks) {
+    std::vector<struct iovec> iov;
+    iov.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        iov.push_back({const_cast<uint8_t*>(chunk.data()), chunk.size()});
+    }
+    return iov;
+}
+
+WavFileWriter::WavFileWriter(const std::string& path) : path_(path) {
+    // Readable too, for moving the data up when the file turns into RF64.
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open output file for writing");
+    }
+    uint8_t header[kWavHeaderSize];
+    FillWavHeader(header, 0, 0, 0, 0);
+    if (!PwriteAll(fd_, header, sizeof(header), 0) ||
+        lseek(fd_, kWavHeaderSize, SEEK_SET) < 0) {
+        Abort();
+        throw std::runtime_error("Failed to write WAV header");
+    }
+}
+
+WavFileWriter::~WavFileWriter() {
+    if (fd_ >= 0) Abort();
+}
+
+/// Moves [size] bytes at [from] in [fd] up to [to], last block first so
+/// the ranges may overlap.
+static bool MoveUp(int fd, uint64_t from, uint64_t to, uint64_t size) {
+    constexpr size_t kBlockBytes = 8 * 1024 * 1024;
+    std::vector<uint8_t> block(static_cast<size_t>(std::min<uint64_t>(size, kBlockBytes)));
+    while (size > 0) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(size, block.size()));
+        size -= count;
+        ssize_t n;
+        do {
+            n = pread(fd, block.data(), count, static_cast<off_t>(from + size));
+        } while (n < 0 && errno == EINTR);
+        if (n != static_cast<ssize_t>(count) ||
+            !PwriteAll(fd, block.data(), count, static_cast<off_t>(to + size))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void WavFileWriter::Relayout(const WavHeaderLayout& layout) {
+    if (!WriteHeader(layout, 0, 0, 0, 0) ||
+        lseek(fd_, static_cast<off_t>(layout.size()), SEEK_SET) < 0) {
+        Abort();
+        throw std::runtime_error("Failed to write WAV header");
+    }
+    layout_ = layout;
+}
+
+void WavFileWriter::Reserve(uint64_t dataBytes) {
+    if (dataSize() > 0 || preallocated_ > 0 || dataBytes == 0) return;
+    WavWriterConfig config = CurrentConfig();
+    // Leave some margin: the hint is an estimate from the container.
+    if (!layout_.rf64 && dataBytes >= kMaxWavDataSize / 4 * 3) {
+        WavHeaderLayout layout = layout_;
+        layout.rf64 = true;
+        Relayout(layout);
+    }
+    // Not every file system can preallocate; the file then just grows.
+    size_t headerSize = layout_.size();
+    if (config.preallocate &&
+        fallocate(fd_, 0, 0, static_cast<off_t>(headerSize + dataBytes)) == 0) {
+        preallocated_ = headerSize + dataBytes;
+        gPreallocatedBytes += preallocated_;
+    }
+    // Positioned writes from parallel segments stay buffered, so O_DIRECT
+    // starts with the first append.
+    directWanted_ = config.directIo && dataBytes >= config.directMinBytes;
+}
+
+void WavFileWriter::SetFloatSamples(bool floatSamples) {
+    if (dataSize() > 0 || layout_.floatSamples == floatSamples) return;
+    WavHeaderLayout layout = layout_;
+    layout.floatSamples = floatSamples;
+    Relayout(layout);
+}
+
+bool WavFileWriter::StartDirect() {
+    directWanted_ = false;
+    int flags = fcntl(fd_, F_GETFL);
+    void* buffer = nullptr;
+    if (flags < 0 ||
+        posix_memalign(&buffer, kDirectAlign, kDirectBufferBytes) != 0) {
+        return false;
+    }
+    if (fcntl(fd_, F_SETFL, flags | O_DIRECT) != 0) {
+        free(buffer);
+        return false;
+    }
+    direct_ = static_cast<uint8_t*>(buffer);
+    // Start with the placeholder header so every write is block aligned.
+    FillWavHeader(direct_, layout_, 0, 0, 0, 0);
+    directFill_ = layout_.size();
+    directOffset_ = 0;
+    gDirectFiles++;
+    return true;
+}
+
+void WavFileWriter::AppendDirect(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        size_t count = std::min(size, kDirectBufferBytes - directFill_);
+        std::memcpy(direct_ + directFill_, data, count);
+        directFill_ += count;
+        data += count;
+        size -= count;
+        if (directFill_ == kDirectBufferBytes) {
+            if (!PwriteAll(fd_, direct_, kDirectBufferBytes,
+                           static_cast<off_t>(directOffset_))) {
+                throw std::runtime_error("Failed to write PCM data to WAV file");
+            }
+            directOffset_ += kDirectBufferBytes;
+            directFill_ = 0;
+        }
+    }
+}
+
+void WavFileWriter::EndDirect() {
+    if (!direct_) return;
+    size_t aligned = directFill_ - directFill_ % kDirectAlign;
+    bool ok = PwriteAll(fd_, direct_, aligned, static_cast<off_t>(directOffset_));
+    int flags = fcntl(fd_, F_GETFL);
+    ok = ok && flags >= 0 && fcntl(fd_, F_SETFL, flags & ~O_DIRECT) == 0 &&
+         PwriteAll(fd_, direct_ + aligned, directFill_ - aligned,
+                   static_cast<off_t>(directOffset_ + aligned)) &&
+         lseek(fd_, static_cast<off_t>(directOffset_ + directFill_), SEEK_SET) >= 0;
+    free(direct_);
+    direct_ = nullptr;
+    directFill_ = 0;
+    if (!ok) throw std::runtime_error("Failed to write PCM data to WAV file");
+}
+
+bool WavFileWriter::WriteHeader(const WavHeaderLayout& layout,
+                                uint64_t dataSize, uint32_t sampleRate,
+                                uint16_t channels, uint16_t bitsPerSample) {
+    uint8_t header[kMaxWavHeaderSize];
+    FillWavHeader(header, layout, dataSize, sampleRate, channels,
+                  bitsPerSample);
+    return PwriteAll(fd_, header, layout.size(), 0);
+}
+
+void WavFileWriter::Append(const PcmChunk& chunk) {
+    if (chunk.empty()) return;
+    if (directWanted_ && dataSize() == 0) StartDirect();
+    if (direct_) {
+        AppendDirect(chunk.data(), chunk.size());
+        dataSize_ += chunk.size();
+        return;
+    }
+    pending_.push_back(chunk);
+    pendingBytes_ += chunk.size();
+    dataSize_ += chunk.size();
+    if (pendingBytes_ >= kFlushThreshold || pending_.size() >= kMaxHeldChunks) {
+        Flush();
+    }
+}
+
+void WavFileWriter::Flush() {
+    EndDirect();
+    std::vector<struct iovec> iov = ChunkVectors(pending_);
+    if (!WriteAllV(fd_, iov, -1)) {
+        throw std::runtime_error("Failed to write PCM data to WAV file");
+    }
+    pending_.clear();
+    pendingBytes_ = 0;
+}
+
+void WavFileWriter::WriteAt(uint64_t dataOffset,
+                            const std::vector<PcmChunk>& chunks) {
+    std::vector<struct iovec> iov = ChunkVectors(chunks);
+    uint64_t bytes = 0;
+    for (const auto& v : iov) bytes += v.iov_len;
+    if (!WriteAllV(fd_, iov, static_cast<off_t>(layout_.size() + dataOffset))) {
+        throw std::runtime_error("Failed to write PCM data to WAV file");
+    }
+    uint64_t end = dataOffset + bytes;
+    uint64_t seen = writtenEnd_.load();
+    while (seen < end && !writtenEnd_.compare_exchange_weak(seen, end)) {
+    }
+}
+
+void WavFileWriter::CopyFrom(int fd, uint64_t offset, uint64_t size) {
+    Flush();
+    loff_t in = static_cast<loff_t>(offset);
+    bool kernelCopy = true;
+    uint64_t left = size;
+    while (left > 0) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(left, SSIZE_MAX));
+        // Both calls write at, and advance, the output file offset.
+        ssize_t n = CountedWrite([&] {
+            return kernelCopy ? copy_file_range(fd, &in, fd_, nullptr, count, 0)
+                              : sendfile(fd_, fd, &in, count);
+        });
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && kernelCopy &&
+            (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+             errno == EOPNOTSUPP)) {
+            kernelCopy = false;
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("Failed to copy PCM data to WAV file");
+        }
+        left -= static_cast<uint64_t>(n);
+    }
+    dataSize_ += size;
+}
+
+void WavFileWriter::Finalize(uint32_t sampleRate, uint16_t channels,
+                             uint16_t bitsPerSample) {
+    Flush();
+    uint64_t size = dataSize();
+    if (!layout_.rf64 && layout_.size() - 8 + size > 0xFFFFFFFFULL) {
+        // Nothing announced this much data: make room for the ds64 chunk.
+        WavHeaderLayout layout = layout_;
+        layout.rf64 = true;
+        if (!MoveUp(fd_, layout_.size(), layout.size(), size)) {
+            Abort();
+            throw std::runtime_error("Failed to write PCM data to WAV file");
+        }
+        layout_ = layout;
+    }
+    if (!WriteHeader(layout_, size, sampleRate, channels, bitsPerSample) ||
+        (preallocated_ > 0 &&
+         ftruncate(fd_, static_cast<off_t>(layout_.size() + size)) != 0)) {
+        Abort();
+        throw std::runtime_error("Failed to finalize WAV header");
+    }
+    if (close(fd_) != 0) {
+        fd_ = -1;
+        std::remove(path_.c_str());
+        throw std::runtime_error("Failed to close WAV file");
+    }
+    fd_ = -1;
+    gFiles++;
+}
+
+void WavFileWriter::Abort() {
+    pending_.clear();
+    pendingBytes_ = 0;
+    free(direct_);
+    direct_ = nullptr;
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    std::remove(path_.c_str());
+}
+
+void WavFileWriter::Configure(const WavWriterConfig& config) {
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    gConfig = config;
+}
+
+WavWriterStats WavFileWriter::Stats() {
+    WavWriterStats stats;
+    stats.files = gFiles.load();
+    stats.bytes = gBytes.load();
+    stats.writeCalls = gWriteCalls.load();
+    stats.writeMicros = gWriteMicros.load();
+    stats.preallocatedBytes = gPreallocatedBytes.load();
+    stats.directFiles = gDirectFiles.load();
+    return stats;
+}
+
+WavMemoryWriter::WavMemoryWriter(bool includeHeader)
+    : includeHeader_(includeHeader),
+      headerSize_(includeHeader ? layout_.size() : 0),
+      bytes_(headerSize_) {}
+
+void WavMemoryWriter::Reserve(uint64_t dataBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_.reserve(headerSize_ + dataBytes);
+}
+
+void WavMemoryWriter::SetFloatSamples(bool floatSamples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes_.size() > headerSize_) return;
+    layout_.floatSamples = floatSamples;
+    if (!includeHeader_) return;
+    headerSize_ = layout_.size();
+    bytes_.resize(headerSize_);
+}
+
+void WavMemoryWriter::Append(const PcmChunk& chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_.insert(bytes_.end(), chunk.data(), chunk.data() + chunk.size());
+}
+
+void WavMemoryWriter::WriteAt(uint64_t dataOffset,
+                              const std::vector<PcmChunk>& chunks) {
+    uint64_t bytes = 0;
+    for (const auto& chunk : chunks) bytes += chunk.size();
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t end = headerSize_ + dataOffset + bytes;
+    if (bytes_.size() < end) bytes_.resize(end);
+    uint8_t* out = bytes_.data() + headerSize_ + dataOffset;
+    for (const auto& chunk : chunks) {
+        std::memcpy(out, chunk.data(), chunk.size());
+        out += chunk.size();
+    }
+}
+
+uint64_t WavMemoryWriter::dataSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_.size() - headerSize_;
+}
+
+void WavMemoryWriter::Finalize(uint32_t sampleRate, uint16_t channels,
+                               uint16_t bitsPerSample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!includeHeader_) return;
+    FillWavHeader(bytes_.data(), layout_, bytes_.size() - headerSize_,
+                  sampleRate, channels, bitsPerSample);
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,247 @@
+#ifndef FLUTTER_PLUGIN_WAV_WRITER_H_
+#define FLUTTER_PLUGIN_WAV_WRITER_H_
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pcm_chunk.h"
+
+namespace audio_decoder {
+
+/// Standard RIFF/WAV header size in bytes (no extra chunks).
+constexpr size_t kWavHeaderSize = 44;
+
+/// Size of a header with room for an RF64 `ds64` chunk (EBU Tech 3306).
+constexpr size_t kRf64HeaderSize = 80;
+
+/// Size of an IEEE float header: a WAVE_FORMAT_EXTENSIBLE `fmt ` chunk and
+/// a `fact` chunk.
+constexpr size_t kWavFloatHeaderSize = 80;
+
+/// Size of the largest header a writer produces: float with room for
+/// `ds64`.
+constexpr size_t kMaxWavHeaderSize = 116;
+
+/// Maximum PCM data size that fits in a standard WAV file (~4 GB).
+constexpr uint64_t kMaxWavDataSize = 0xFFFFFFFFULL - 36;
+
+/// The chunks a WAV header is made of, beyond the sizes and format fields.
+struct WavHeaderLayout {
+    /// IEEE float samples: the `fmt ` chunk is WAVE_FORMAT_EXTENSIBLE with
+    /// the float subformat, followed by a `fact` chunk.
+    bool floatSamples = false;
+    /// Room for a `ds64` chunk, as in FillRf64Header().
+    bool rf64 = false;
+
+    /// 44 bytes for integer PCM, 80 for float, 36 more with `ds64`.
+    size_t size() const {
+        return (floatSamples ? kWavFloatHeaderSize : kWavHeaderSize) +
+               (rf64 ? kRf64HeaderSize - kWavHeaderSize : 0);
+    }
+};
+
+/// Fills [header] with a 44-byte PCM WAV header describing [dataSize] bytes
+/// of interleaved samples.  All fields are written little-endian.
+void FillWavHeader(uint8_t* header, uint32_t dataSize, uint32_t sampleRate,
+                   uint16_t channels, uint16_t bitsPerSample);
+
+/// Fills [header] with an 80-byte PCM header whose first chunk is a `ds64`
+/// chunk if [dataSize] exceeds kMaxWavDataSize, making the file RF64, and
+/// otherwise a `JUNK` chunk of the same size, which a plain WAV reader
+/// skips.
+void FillRf64Header(uint8_t* header, uint64_t dataSize, uint32_t sampleRate,
+                    uint16_t channels, uint16_t bitsPerSample);
+
+/// Fills [header] with the layout.size() bytes of a header of [layout]
+/// describing [dataSize] bytes.  With [layout].rf64 the file turns RF64
+/// once the RIFF size no longer fits 32 bits.
+void FillWavHeader(uint8_t* header, const WavHeaderLayout& layout,
+                   uint64_t dataSize, uint32_t sampleRate, uint16_t channels,
+                   uint16_t bitsPerSample);
+
+struct WavWriterConfig {
+    /// Allocate the expected size up front with fallocate(), so the file
+    /// is laid out in one piece; Finalize() truncates any excess.
+    bool preallocate = true;
+    /// Write the appended data of outputs expected to reach
+    /// [directMinBytes] with O_DIRECT, bypassing the page cache.
+    bool directIo = false;
+    uint64_t directMinBytes = 64 * 1024 * 1024;
+};
+
+struct WavWriterStats {
+    /// Files finalized and the bytes written to output files.
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    /// Write system calls (including kernel copies) and the time in them.
+    uint64_t writeCalls = 0;
+    uint64_t writeMicros = 0;
+    uint64_t preallocatedBytes = 0;
+    uint64_t directFiles = 0;
+};
+
+/// Streams PCM chunks into a WAV file.
+///
+/// Chunks are held by reference and written in batches with writev(), so
+/// decoded data goes from the GstBuffer straight to the kernel without an
+/// intermediate user-space copy.  A batch is written once it holds
+/// kMaxHeldChunks chunks or kFlushThreshold bytes, whichever comes first,
+/// so the decoder gets its buffers back promptly.  The header is written as a placeholder on
+/// open and patched by Finalize().  If the writer is destroyed before
+/// Finalize() succeeds, the partial file is removed.
+///
+/// Files have no size limit: data beyond 4 GB turns the output into RF64.
+/// The header normally takes 44 bytes (80 for float samples); when Reserve()
+/// announces that much data before anything is written, room for the `ds64`
+/// chunk is kept from the start, and otherwise the data is moved up to make
+/// room at Finalize().
+///
+/// Reserve() also preallocates the file and, for large outputs with
+/// WavWriterConfig::directIo, switches appends to O_DIRECT: chunks are then
+/// copied into an aligned buffer mirroring the file from offset 0, written
+/// a full buffer at a time, and the unaligned tail is written through the
+/// page cache at the end.
+class WavFileWriter {
+ public:
+    /// Decoded chunks held by reference before they are written.  Each pins
+    /// a decoder buffer, so this stays well below the decode queue's default
+    /// of 32 buffers.
+    static constexpr size_t kMaxHeldChunks = 16;
+
+    /// Creates (or truncates) [path].  Throws std::runtime_error on failure.
+    explicit WavFileWriter(const std::string& path);
+    ~WavFileWriter();
+
+    WavFileWriter(const WavFileWriter&) = delete;
+    WavFileWriter& operator=(const WavFileWriter&) = delete;
+
+    /// Hint that about [dataBytes] of PCM will follow.  Only acts before
+    /// the first write: preallocates the file, reserves the RF64 header up
+    /// front for a hint near the WAV limit, and picks O_DIRECT if enabled.
+    void Reserve(uint64_t dataBytes);
+
+    /// Describes the samples as IEEE float rather than integer PCM.  Only
+    /// acts before the first write.
+    void SetFloatSamples(bool floatSamples);
+
+    /// Queues [chunk] for writing.  Throws std::runtime_error on I/O errors.
+    void Append(const PcmChunk& chunk);
+
+    /// Writes [chunks] contiguously at byte [dataOffset] of the data chunk
+    /// with pwritev(), bypassing the Append() batch.  Safe to call from
+    /// several threads for disjoint ranges; the data size becomes the end of
+    /// the furthest range written.  Throws std::runtime_error on I/O errors.
+    void WriteAt(uint64_t dataOffset, const std::vector<PcmChunk>& chunks);
+
+    /// Appends [size] bytes of the file open at [fd], starting at byte
+    /// [offset], in the kernel with copy_file_range() (sendfile() where
+    /// that is not supported), so the samples never pass through user
+    /// space.  Throws std::runtime_error on I/O errors or if [fd] ends
+    /// early.
+    void CopyFrom(int fd, uint64_t offset, uint64_t size);
+
+    /// PCM bytes appended or written so far.
+    uint64_t dataSize() const {
+        return std::max<uint64_t>(dataSize_, writtenEnd_.load());
+    }
+
+    /// Flushes pending chunks, writes the final header and closes the file.
+    void Finalize(uint32_t sampleRate, uint16_t channels,
+                  uint16_t bitsPerSample);
+
+    /// Closes and removes the file.
+    void Abort();
+
+    static void Configure(const WavWriterConfig& config);
+    static WavWriterStats Stats();
+
+ private:
+    /// Pending bytes that trigger a writev() of the queued chunks.
+    static constexpr size_t kFlushThreshold = 4 * 1024 * 1024;
+
+    void Flush();
+    /// Turns on O_DIRECT for appends; false if the file system refuses.
+    bool StartDirect();
+    void AppendDirect(const uint8_t* data, size_t size);
+    /// Writes out the direct buffer and turns O_DIRECT off again.
+    void EndDirect();
+    /// Rewrites the header with one of [layout].
+    bool WriteHeader(const WavHeaderLayout& layout, uint64_t dataSize,
+                     uint32_t sampleRate, uint16_t channels,
+                     uint16_t bitsPerSample);
+    /// Replaces the placeholder header, before any data, with one of
+    /// [layout].
+    void Relayout(const WavHeaderLayout& layout);
+
+    std::string path_;
+    int fd_ = -1;
+    WavHeaderLayout layout_;
+    uint64_t preallocated_ = 0;
+    bool directWanted_ = false;
+    /// Aligned buffer holding file bytes from [directOffset_] while
+    /// appends use O_DIRECT.
+    uint8_t* direct_ = nullptr;
+    size_t directFill_ = 0;
+    uint64_t directOffset_ = 0;
+    std::vector<PcmChunk> pending_;
+    size_t pendingBytes_ = 0;
+    uint64_t dataSize_ = 0;
+    std::atomic<uint64_t> writtenEnd_{0};
+};
+
+/// Collects a WAV file, or bare PCM, in a single growable buffer for
+/// callers that return bytes instead of a path.
+///
+/// Room for the header is left at the front and filled by Finalize(), so
+/// leaving the header out costs nothing and the PCM is never moved after it
+/// has been copied in.  Has the same writing interface as WavFileWriter.
+class WavMemoryWriter {
+ public:
+    /// The bytes are returned as one message, so RF64 is not offered; the
+    /// limit leaves room for a float header.
+    static constexpr uint64_t kMaxDataSize =
+        0xFFFFFFFFULL - (kWavFloatHeaderSize - 8);
+
+    explicit WavMemoryWriter(bool includeHeader = true);
+
+    WavMemoryWriter(const WavMemoryWriter&) = delete;
+    WavMemoryWriter& operator=(const WavMemoryWriter&) = delete;
+
+    /// Allocates room for [dataBytes] of PCM so that appending up to that
+    /// much never reallocates.
+    void Reserve(uint64_t dataBytes);
+
+    /// Like WavFileWriter::SetFloatSamples().
+    void SetFloatSamples(bool floatSamples);
+
+    void Append(const PcmChunk& chunk);
+
+    /// Copies [chunks] contiguously to byte [dataOffset] of the PCM data.
+    /// Safe to call from several threads for disjoint ranges.
+    void WriteAt(uint64_t dataOffset, const std::vector<PcmChunk>& chunks);
+
+    uint64_t dataSize() const;
+
+    /// Writes the header, if any.
+    void Finalize(uint32_t sampleRate, uint16_t channels,
+                  uint16_t bitsPerSample);
+
+    /// The header (if included) followed by the PCM data.
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+ private:
+    const bool includeHeader_;
+    WavHeaderLayout layout_;
+    size_t headerSize_;
+    mutable std::mutex mutex_;
+    std::vector<uint8_t> bytes_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_WAV_WRITER_H_
@@ -0,0 +1,88 @@
+#include "waveform_accumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio_decoder {
+
+WaveformAccumulator::WaveformAccumulator(int numberOfSamples)
+    : numberOfSamples_(std::max(numberOfSamples, 0)),
+      maxBins_(2 * kBinsPerWindow * std::max<size_t>(numberOfSamples_, 1)) {
+    bins_.reserve(maxBins_);
+}
+
+void WaveformAccumulator::SetExpectedSamples(uint64_t total) {
+    if (total_ > 0 || numberOfSamples_ == 0) return;
+    binSize_ = std::max<uint64_t>(1, total / (kBinsPerWindow * numberOfSamples_));
+}
+
+void WaveformAccumulator::Add(const void* samples, size_t count,
+                              SampleFormat format) {
+    const uint8_t* data = static_cast<const uint8_t*>(samples);
+    const size_t sampleBytes = BytesPerSample(format);
+    total_ += count;
+    while (count > 0) {
+        if (bins_.empty() || bins_.back().count == binSize_) {
+            if (bins_.size() == maxBins_) MergeBins();
+            if (bins_.empty() || bins_.back().count == binSize_) {
+                bins_.emplace_back();
+            }
+        }
+        SampleStats& bin = bins_.back();
+        size_t n = static_cast<size_t>(
+            std::min<uint64_t>(count, binSize_ - bin.count));
+        bin.Merge(ReduceSamples(format, data, n));
+        data += n * sampleBytes;
+        count -= n;
+    }
+}
+
+void WaveformAccumulator::MergeBins() {
+    size_t merged = 0;
+    for (size_t i = 0; i < bins_.size(); i += 2) {
+        SampleStats bin = bins_[i];
+        if (i + 1 < bins_.size()) bin.Merge(bins_[i + 1]);
+        bins_[merged++] = bin;
+    }
+    bins_.resize(merged);
+    binSize_ *= 2;
+}
+
+double WaveformAccumulator::SumSquares(uint64_t start, uint64_t end) const {
+    double sum = 0;
+    for (size_t b = static_cast<size_t>(start / binSize_);
+         b < bins_.size() && b * binSize_ < end; b++) {
+        const SampleStats& bin = bins_[b];
+        if (bin.count == 0) continue;
+        uint64_t binStart = b * binSize_;
+        uint64_t binEnd = binStart + bin.count;
+        uint64_t lo = std::max(start, binStart);
+        uint64_t hi = std::min(end, binEnd);
+        if (hi <= lo) continue;
+        sum += bin.sumSquares * static_cast<double>(hi - lo) / bin.count;
+    }
+    return sum;
+}
+
+std::vector<double> WaveformAccumulator::Finish() const {
+    std::vector<double> waveform(numberOfSamples_, 0.0);
+    if (total_ == 0 || numberOfSamples_ == 0) return waveform;
+
+    uint64_t samplesPerWindow =
+        std::max<uint64_t>(1, total_ / numberOfSamples_);
+    double maxRms = 0;
+    for (int i = 0; i < numberOfSamples_; i++) {
+        uint64_t start = static_cast<uint64_t>(i) * total_ / numberOfSamples_;
+        if (start >= total_) break;
+        uint64_t end = std::min(start + samplesPerWindow, total_);
+        double rms = std::sqrt(SumSquares(start, end) / (end - start));
+        waveform[i] = rms;
+        if (rms > maxRms) maxRms = rms;
+    }
+    if (maxRms > 0) {
+        for (double& value : waveform) value /= maxRms;
+    }
+    return waveform;
+}
+
+}  // namespace audio_decoder
@@ -0,0 +1,62 @@
+#ifndef FLUTTER_PLUGIN_WAVEFORM_ACCUMULATOR_H_
+#define FLUTTER_PLUGIN_WAVEFORM_ACCUMULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "waveform_kernels.h"
+
+namespace audio_decoder {
+
+/// Builds an RMS waveform from PCM delivered in chunks.
+///
+/// Samples are folded into a fixed number of bins as they arrive, so memory
+/// is proportional to the requested number of points rather than to the
+/// length of the input.  When the total sample count is known up front the
+/// bin size is chosen from it; otherwise bins start at one sample and are
+/// merged pairwise whenever they run out, doubling the bin size each time.
+class WaveformAccumulator {
+ public:
+    explicit WaveformAccumulator(int numberOfSamples);
+
+    /// Sizes the bins for [total] expected samples.  Only has an effect
+    /// before the first Add; a wrong estimate costs precision, not memory.
+    void SetExpectedSamples(uint64_t total);
+
+    /// Folds [count] samples of [format] into the bins, reducing each run
+    /// that falls into one bin with a single vectorized kernel call.
+    void Add(const void* samples, size_t count, SampleFormat format);
+
+    void Add(const int16_t* samples, size_t count) {
+        Add(samples, count, SampleFormat::kS16);
+    }
+
+    /// Samples added so far.
+    uint64_t samples() const { return total_; }
+
+    /// Returns [numberOfSamples] RMS values normalized to the loudest
+    /// window.  Window i starts at sample `i * total / numberOfSamples` and
+    /// spans `total / numberOfSamples` samples (at least one); windows past
+    /// the end of a short input are zero.
+    std::vector<double> Finish() const;
+
+ private:
+    /// Bins kept per output window when the total is known.
+    static constexpr uint64_t kBinsPerWindow = 4;
+
+    void MergeBins();
+
+    /// Sum of squares over [start, end), interpolating partially covered bins.
+    double SumSquares(uint64_t start, uint64_t end) const;
+
+    int numberOfSamples_;
+    size_t maxBins_;
+    uint64_t binSize_ = 1;
+    std::vector<SampleStats> bins_;
+    uint64_t total_ = 0;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_WAVEFORM_ACCUMULATOR_H_
@@ -0,0 +1,482 @@
+#include "waveform_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AUDIO_DECODER_X86_KERNELS 1
+#endif
+
+namespace audio_decoder {
+
+size_t BytesPerSample(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::kS16: return 2;
+        case SampleFormat::kS24: return 3;
+        case SampleFormat::kS32: return 4;
+        case SampleFormat::kF32: return 4;
+    }
+    return 2;
+}
+
+void SampleStats::Merge(const SampleStats& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    sumSquares += other.sumSquares;
+    sumAbs += other.sumAbs;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    count += other.count;
+}
+
+namespace {
+
+using ReduceFn = SampleStats (*)(const uint8_t* data, size_t count);
+
+/// How a sample of each format is read, and the factor that maps its raw
+/// value to full scale.
+template <SampleFormat F> struct SampleTraits;
+
+template <> struct SampleTraits<SampleFormat::kS16> {
+    static constexpr size_t kBytes = 2;
+    static constexpr double kScale = 1.0 / 32768.0;
+    static double Load(const uint8_t* p) {
+        int16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+};
+
+template <> struct SampleTraits<SampleFormat::kS24> {
+    static constexpr size_t kBytes = 3;
+    static constexpr double kScale = 1.0 / 8388608.0;
+    static double Load(const uint8_t* p) {
+        int32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+        if (v & 0x800000) v -= 0x1000000;
+        return v;
+    }
+};
+
+template <> struct SampleTraits<SampleFormat::kS32> {
+    static constexpr size_t kBytes = 4;
+    static constexpr double kScale = 1.0 / 2147483648.0;
+    static double Load(const uint8_t* p) {
+        int32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+};
+
+template <> struct SampleTraits<SampleFormat::kF32> {
+    static constexpr size_t kBytes = 4;
+    static constexpr double kScale = 1.0;
+    static double Load(const uint8_t* p) {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+};
+
+/// Builds stats from raw (unscaled) sums.
+SampleStats ScaledStats(double sumSquares, double sumAbs, double min,
+                        double max, uint64_t count, double scale) {
+    SampleStats stats;
+    stats.sumSquares = sumSquares * scale * scale;
+    stats.sumAbs = sumAbs * scale;
+    stats.min = min * scale;
+    stats.max = max * scale;
+    stats.count = count;
+    return stats;
+}
+
+template <SampleFormat F>
+SampleStats ReduceScalar(const uint8_t* data, size_t count) {
+    using Traits = SampleTraits<F>;
+    if (count == 0) return SampleStats();
+    double sumSquares = 0, sumAbs = 0;
+    double min = Traits::Load(data), max = min;
+    for (size_t i = 0; i < count; i++) {
+        double v = Traits::Load(data + i * Traits::kBytes);
+        sumSquares += v * v;
+        sumAbs += std::fabs(v);
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    return ScaledStats(sumSquares, sumAbs, min, max, count, Traits::kScale);
+}
+
+#ifdef AUDIO_DECODER_X86_KERNELS
+
+// Vector kernels.  Each format without a specialization uses the scalar
+// kernel.  Integer sums are exact for S16; the other formats accumulate in
+// double, like the scalar kernel, so results differ only in rounding.
+
+template <SampleFormat F>
+SampleStats ReduceSse2(const uint8_t* data, size_t count) {
+    return ReduceScalar<F>(data, count);
+}
+
+template <SampleFormat F>
+SampleStats ReduceAvx2(const uint8_t* data, size_t count) {
+    return ReduceSse2<F>(data, count);
+}
+
+/// Vectors of S16 samples whose absolute values are summed in 32-bit lanes
+/// before widening; each lane stays below 2^31.
+constexpr size_t kS16BlockVectors = 16384;
+
+template <typename Lane, size_t N>
+double SumLanes(const Lane (&lanes)[N]) {
+    double sum = 0;
+    for (Lane lane : lanes) sum += static_cast<double>(lane);
+    return sum;
+}
+
+template <>
+__attribute__((target("sse2")))
+SampleStats ReduceSse2<SampleFormat::kS16>(const uint8_t* data, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmin = _mm_set1_epi16(INT16_MAX);
+    __m128i vmax = _mm_set1_epi16(INT16_MIN);
+    __m128i squares = zero, absolute = zero;
+    const size_t vectors = count / 8;
+    const uint8_t* p = data;
+
+    for (size_t done = 0; done < vectors;) {
+        size_t blockEnd = std::min(vectors, done + kS16BlockVectors);
+        __m128i abs32 = zero;
+        for (; done < blockEnd; done++, p += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            vmin = _mm_min_epi16(vmin, x);
+            vmax = _mm_max_epi16(vmax, x);
+            // Pairwise squares are at most 2^31, so read them as unsigned.
+            __m128i sq = _mm_madd_epi16(x, x);
+            squares = _mm_add_epi64(squares, _mm_unpacklo_epi32(sq, zero));
+            squares = _mm_add_epi64(squares, _mm_unpackhi_epi32(sq, zero));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            __m128i signLo = _mm_srai_epi32(lo, 31);
+            __m128i signHi = _mm_srai_epi32(hi, 31);
+            lo = _mm_sub_epi32(_mm_xor_si128(lo, signLo), signLo);
+            hi = _mm_sub_epi32(_mm_xor_si128(hi, signHi), signHi);
+            abs32 = _mm_add_epi32(abs32, _mm_add_epi32(lo, hi));
+        }
+        absolute = _mm_add_epi64(absolute, _mm_unpacklo_epi32(abs32, zero));
+        absolute = _mm_add_epi64(absolute, _mm_unpackhi_epi32(abs32, zero));
+    }
+
+    SampleStats stats;
+    if (vectors > 0) {
+        alignas(16) uint64_t sq[2], ab[2];
+        alignas(16) int16_t mins[8], maxs[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sq), squares);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ab), absolute);
+        _mm_store_si128(reinterpret_cast<__m128i*>(mins), vmin);
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+        stats = ScaledStats(SumLanes(sq), SumLanes(ab),
+                            *std::min_element(mins, mins + 8),
+                            *std::max_element(maxs, maxs + 8), vectors * 8,
+                            SampleTraits<SampleFormat::kS16>::kScale);
+    }
+    stats.Merge(ReduceScalar<SampleFormat::kS16>(p, count - vectors * 8));
+    return stats;
+}
+
+/// Accumulates squares and absolute values of two doubles.
+__attribute__((target("sse2")))
+inline void AccumulatePd(__m128d v, __m128d* squares, __m128d* absolute) {
+    *squares = _mm_add_pd(*squares, _mm_mul_pd(v, v));
+    *absolute = _mm_add_pd(*absolute, _mm_andnot_pd(_mm_set1_pd(-0.0), v));
+}
+
+template <>
+__attribute__((target("sse2")))
+SampleStats ReduceSse2<SampleFormat::kS32>(const uint8_t* data, size_t count) {
+    const size_t vectors = count / 4;
+    if (vectors == 0) return ReduceScalar<SampleFormat::kS32>(data, count);
+    double first = SampleTraits<SampleFormat::kS32>::Load(data);
+    __m128d vmin = _mm_set1_pd(first), vmax = vmin;
+    __m128d squares = _mm_setzero_pd(), absolute = _mm_setzero_pd();
+    const uint8_t* p = data;
+    for (size_t i = 0; i < vectors; i++, p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128d lo = _mm_cvtepi32_pd(x);
+        __m128d hi = _mm_cvtepi32_pd(_mm_srli_si128(x, 8));
+        vmin = _mm_min_pd(vmin, _mm_min_pd(lo, hi));
+        vmax = _mm_max_pd(vmax, _mm_max_pd(lo, hi));
+        AccumulatePd(lo, &squares, &absolute);
+        AccumulatePd(hi, &squares, &absolute);
+    }
+
+    alignas(16) double sq[2], ab[2], mins[2], maxs[2];
+    _mm_store_pd(sq, squares);
+    _mm_store_pd(ab, absolute);
+    _mm_store_pd(mins, vmin);
+    _mm_store_pd(maxs, vmax);
+    SampleStats stats = ScaledStats(SumLanes(sq), SumLanes(ab),
+                                    std::min(mins[0], mins[1]),
+                                    std::max(maxs[0], maxs[1]), vectors * 4,
+                                    SampleTraits<SampleFormat::kS32>::kScale);
+    stats.Merge(ReduceScalar<SampleFormat::kS32>(p, count - vectors * 4));
+    return stats;
+}
+
+template <>
+__attribute__((target("sse2")))
+SampleStats ReduceSse2<SampleFormat::kF32>(const uint8_t* data, size_t count) {
+    const size_t vectors = count / 4;
+    if (vectors == 0) return ReduceScalar<SampleFormat::kF32>(data, count);
+    const float* samples = reinterpret_cast<const float*>(data);
+    __m128 vmin = _mm_set1_ps(static_cast<float>(
+        SampleTraits<SampleFormat::kF32>::Load(data)));
+    __m128 vmax = vmin;
+    __m128d squares = _mm_setzero_pd(), absolute = _mm_setzero_pd();
+    for (size_t i = 0; i < vectors; i++) {
+        __m128 x = _mm_loadu_ps(samples + i * 4);
+        vmin = _mm_min_ps(vmin, x);
+        vmax = _mm_max_ps(vmax, x);
+        AccumulatePd(_mm_cvtps_pd(x), &squares, &absolute);
+        AccumulatePd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), &squares, &absolute);
+    }
+
+    alignas(16) double sq[2], ab[2];
+    alignas(16) float mins[4], maxs[4];
+    _mm_store_pd(sq, squares);
+    _mm_store_pd(ab, absolute);
+    _mm_store_ps(mins, vmin);
+    _mm_store_ps(maxs, vmax);
+    SampleStats stats = ScaledStats(SumLanes(sq), SumLanes(ab),
+                                    *std::min_element(mins, mins + 4),
+                                    *std::max_element(maxs, maxs + 4),
+                                    vectors * 4, 1.0);
+    stats.Merge(ReduceScalar<SampleFormat::kF32>(
+        data + vectors * 16, count - vectors * 4));
+    return stats;
+}
+
+template <>
+__attribute__((target("avx2")))
+SampleStats ReduceAvx2<SampleFormat::kS16>(const uint8_t* data, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i vmin = _mm256_set1_epi16(INT16_MAX);
+    __m256i vmax = _mm256_set1_epi16(INT16_MIN);
+    __m256i squares = zero, absolute = zero;
+    const size_t vectors = count / 16;
+    const uint8_t* p = data;
+
+    for (size_t done = 0; done < vectors;) {
+        size_t blockEnd = std::min(vectors, done + kS16BlockVectors);
+        __m256i abs32 = zero;
+        for (; done < blockEnd; done++, p += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            vmin = _mm256_min_epi16(vmin, x);
+            vmax = _mm256_max_epi16(vmax, x);
+            __m256i sq = _mm256_madd_epi16(x, x);
+            squares = _mm256_add_epi64(squares, _mm256_unpacklo_epi32(sq, zero));
+            squares = _mm256_add_epi64(squares, _mm256_unpackhi_epi32(sq, zero));
+            __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+            __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+            abs32 = _mm256_add_epi32(
+                abs32, _mm256_add_epi32(_mm256_abs_epi32(lo), _mm256_abs_epi32(hi)));
+        }
+        absolute = _mm256_add_epi64(absolute, _mm256_unpacklo_epi32(abs32, zero));
+        absolute = _mm256_add_epi64(absolute, _mm256_unpackhi_epi32(abs32, zero));
+    }
+
+    SampleStats stats;
+    if (vectors > 0) {
+        alignas(32) uint64_t sq[4], ab[4];
+        alignas(32) int16_t mins[16], maxs[16];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sq), squares);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(ab), absolute);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(mins), vmin);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), vmax);
+        stats = ScaledStats(SumLanes(sq), SumLanes(ab),
+                            *std::min_element(mins, mins + 16),
+                            *std::max_element(maxs, maxs + 16), vectors * 16,
+                            SampleTraits<SampleFormat::kS16>::kScale);
+    }
+    stats.Merge(ReduceScalar<SampleFormat::kS16>(p, count - vectors * 16));
+    return stats;
+}
+
+/// Accumulates squares and absolute values of four doubles.
+__attribute__((target("avx2")))
+inline void AccumulatePd256(__m256d v, __m256d* squares, __m256d* absolute) {
+    *squares = _mm256_add_pd(*squares, _mm256_mul_pd(v, v));
+    *absolute = _mm256_add_pd(*absolute,
+                              _mm256_andnot_pd(_mm256_set1_pd(-0.0), v));
+}
+
+/// Folds the double accumulators of an AVX2 kernel into stats.
+__attribute__((target("avx2")))
+SampleStats ScaledStats256(__m256d squares, __m256d absolute, double min,
+                           double max, uint64_t count, double scale) {
+    alignas(32) double sq[4], ab[4];
+    _mm256_store_pd(sq, squares);
+    _mm256_store_pd(ab, absolute);
+    return ScaledStats(SumLanes(sq), SumLanes(ab), min, max, count, scale);
+}
+
+template <>
+__attribute__((target("avx2")))
+SampleStats ReduceAvx2<SampleFormat::kS24>(const uint8_t* data, size_t count) {
+    // Four packed samples are widened per step with a byte shuffle.  A step
+    // loads 16 bytes, so stop while at least 6 samples (18 bytes) remain.
+    if (count < 6) return ReduceScalar<SampleFormat::kS24>(data, count);
+    const size_t steps = (count - 2) / 4;
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+                                          -1, 6, 7, 8, -1, 9, 10, 11);
+    __m128i vmin = _mm_set1_epi32(INT32_MAX), vmax = _mm_set1_epi32(INT32_MIN);
+    __m256d squares = _mm256_setzero_pd(), absolute = _mm256_setzero_pd();
+    const uint8_t* p = data;
+    for (size_t i = 0; i < steps; i++, p += 12) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i x = _mm_srai_epi32(_mm_shuffle_epi8(raw, shuffle), 8);
+        vmin = _mm_min_epi32(vmin, x);
+        vmax = _mm_max_epi32(vmax, x);
+        AccumulatePd256(_mm256_cvtepi32_pd(x), &squares, &absolute);
+    }
+
+    alignas(16) int32_t mins[4], maxs[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(mins), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+    SampleStats stats = ScaledStats256(
+        squares, absolute, *std::min_element(mins, mins + 4),
+        *std::max_element(maxs, maxs + 4), steps * 4,
+        SampleTraits<SampleFormat::kS24>::kScale);
+    stats.Merge(ReduceScalar<SampleFormat::kS24>(p, count - steps * 4));
+    return stats;
+}
+
+template <>
+__attribute__((target("avx2")))
+SampleStats ReduceAvx2<SampleFormat::kS32>(const uint8_t* data, size_t count) {
+    const size_t vectors = count / 8;
+    if (vectors == 0) return ReduceScalar<SampleFormat::kS32>(data, count);
+    __m256i vmin = _mm256_set1_epi32(INT32_MAX);
+    __m256i vmax = _mm256_set1_epi32(INT32_MIN);
+    __m256d squares = _mm256_setzero_pd(), absolute = _mm256_setzero_pd();
+    const uint8_t* p = data;
+    for (size_t i = 0; i < vectors; i++, p += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        vmin = _mm256_min_epi32(vmin, x);
+        vmax = _mm256_max_epi32(vmax, x);
+        AccumulatePd256(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)),
+                        &squares, &absolute);
+        AccumulatePd256(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)),
+                        &squares, &absolute);
+    }
+
+    alignas(32) int32_t mins[8], maxs[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(mins), vmin);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), vmax);
+    SampleStats stats = ScaledStats256(
+        squares, absolute, *std::min_element(mins, mins + 8),
+        *std::max_element(maxs, maxs + 8), vectors * 8,
+        SampleTraits<SampleFormat::kS32>::kScale);
+    stats.Merge(ReduceScalar<SampleFormat::kS32>(p, count - vectors * 8));
+    return stats;
+}
+
+template <>
+__attribute__((target("avx2")))
+SampleStats ReduceAvx2<SampleFormat::kF32>(const uint8_t* data, size_t count) {
+    const size_t vectors = count / 8;
+    if (vectors == 0) return ReduceScalar<SampleFormat::kF32>(data, count);
+    const float* samples = reinterpret_cast<const float*>(data);
+    __m256 vmin = _mm256_set1_ps(samples[0]), vmax = vmin;
+    __m256d squares = _mm256_setzero_pd(), absolute = _mm256_setzero_pd();
+    for (size_t i = 0; i < vectors; i++) {
+        __m256 x = _mm256_loadu_ps(samples + i * 8);
+        vmin = _mm256_min_ps(vmin, x);
+        vmax = _mm256_max_ps(vmax, x);
+        AccumulatePd256(_mm256_cvtps_pd(_mm256_castps256_ps128(x)),
+                        &squares, &absolute);
+        AccumulatePd256(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)),
+                        &squares, &absolute);
+    }
+
+    alignas(32) float mins[8], maxs[8];
+    _mm256_store_ps(mins, vmin);
+    _mm256_store_ps(maxs, vmax);
+    SampleStats stats = ScaledStats256(
+        squares, absolute, *std::min_element(mins, mins + 8),
+        *std::max_element(maxs, maxs + 8), vectors * 8, 1.0);
+    stats.Merge(ReduceScalar<SampleFormat::kF32>(
+        data + vectors * 32, count - vectors * 8));
+    return stats;
+}
+
+#endif  // AUDIO_DECODER_X86_KERNELS
+
+/// Kernels per instruction set, indexed by SampleFormat.
+const ReduceFn kScalarKernels[] = {
+    ReduceScalar<SampleFormat::kS16>, ReduceScalar<SampleFormat::kS24>,
+    ReduceScalar<SampleFormat::kS32>, ReduceScalar<SampleFormat::kF32>};
+
+#ifdef AUDIO_DECODER_X86_KERNELS
+const ReduceFn kSse2Kernels[] = {
+    ReduceSse2<SampleFormat::kS16>, ReduceSse2<SampleFormat::kS24>,
+    ReduceSse2<SampleFormat::kS32>, ReduceSse2<SampleFormat::kF32>};
+
+const ReduceFn kAvx2Kernels[] = {
+    ReduceAvx2<SampleFormat::kS16>, ReduceAvx2<SampleFormat::kS24>,
+    ReduceAvx2<SampleFormat::kS32>, ReduceAvx2<SampleFormat::kF32>};
+#endif
+
+const ReduceFn* KernelsFor(KernelIsa isa) {
+#ifdef AUDIO_DECODER_X86_KERNELS
+    switch (isa) {
+        case KernelIsa::kAvx2: return kAvx2Kernels;
+        case KernelIsa::kSse2: return kSse2Kernels;
+        case KernelIsa::kScalar: break;
+    }
+#endif
+    return kScalarKernels;
+}
+
+}  // namespace
+
+KernelIsa DetectKernelIsa() {
+#ifdef AUDIO_DECODER_X86_KERNELS
+    static const KernelIsa isa = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return KernelIsa::kAvx2;
+        if (__builtin_cpu_supports("sse2")) return KernelIsa::kSse2;
+        return KernelIsa::kScalar;
+    }();
+    return isa;
+#else
+    return KernelIsa::kScalar;
+#endif
+}
+
+const char* KernelIsaName(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::kAvx2: return "avx2";
+        case KernelIsa::kSse2: return "sse2";
+        case KernelIsa::kScalar: break;
+    }
+    return "scalar";
+}
+
+SampleStats ReduceSamples(SampleFormat format, const void* data, size_t count) {
+    static const ReduceFn* const kernels = KernelsFor(DetectKernelIsa());
+    return kernels[static_cast<int>(format)](
+        static_cast<const uint8_t*>(data), count);
+}
+
+SampleStats ReduceSamples(SampleFormat format, const void* data, size_t count,
+                          KernelIsa isa) {
+    isa = std::min(isa, DetectKernelIsa());
+    return KernelsFor(isa)[static_cast<int>(format)](
+        static_cast<const uint8_t*>(data), count);
+}
+
+}  // namespace audio_decoder
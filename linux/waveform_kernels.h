@@ -0,0 +1,50 @@
+#ifndef FLUTTER_PLUGIN_WAVEFORM_KERNELS_H_
+#define FLUTTER_PLUGIN_WAVEFORM_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audio_decoder {
+
+/// Interleaved little-endian sample layouts the reduction kernels accept.
+/// kS24 is packed (3 bytes per sample), as in GStreamer's S24LE.
+enum class SampleFormat { kS16, kS24, kS32, kF32 };
+
+/// Bytes one sample of [format] occupies.
+size_t BytesPerSample(SampleFormat format);
+
+/// Instruction sets the kernels are built for, in increasing preference.
+enum class KernelIsa { kScalar, kSse2, kAvx2 };
+
+/// Returns the best instruction set supported by the running CPU.
+KernelIsa DetectKernelIsa();
+
+/// Returns "scalar", "sse2" or "avx2".
+const char* KernelIsaName(KernelIsa isa);
+
+/// Reduction of a run of samples, in full-scale units (integer formats are
+/// divided by 2^(bits-1), so every format reports values in [-1, 1]).
+struct SampleStats {
+    double sumSquares = 0;
+    double sumAbs = 0;
+    double min = 0;
+    double max = 0;
+    uint64_t count = 0;
+
+    /// Folds [other] into this, as if both runs had been reduced together.
+    void Merge(const SampleStats& other);
+};
+
+/// Computes sum of squares, sum of absolute values and min/max peaks over
+/// [count] samples at [data], using the kernel selected for this CPU.
+SampleStats ReduceSamples(SampleFormat format, const void* data, size_t count);
+
+/// Same as above with an explicit instruction set, for tests and
+/// benchmarks.  Falls back to the best supported set if [isa] is not
+/// available on this CPU or in this build.
+SampleStats ReduceSamples(SampleFormat format, const void* data, size_t count,
+                          KernelIsa isa);
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_WAVEFORM_KERNELS_H_
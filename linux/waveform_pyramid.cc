@@ -0,0 +1,340 @@
+#include "waveform_pyramid.h"
+
+#include "scratch_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace audio_decoder {
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'W', 'F', 'P'};
+constexpr uint32_t kVersion = 1;
+
+/// Fixed part of a sidecar.  Fields are in host byte order; the magic and
+/// version checks reject files from elsewhere.
+struct SidecarHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t analysisRate;
+    uint32_t baseBinSamples;
+    uint32_t levels;
+    uint64_t totalSamples;
+    int64_t mtimeNs;
+    uint64_t fileSize;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+/// Offset of the first bin: header plus the path, padded for float access.
+size_t BinsOffset(uint32_t pathLength) {
+    return (sizeof(SidecarHeader) + pathLength + 3) & ~size_t{3};
+}
+
+uint64_t BinSamples(size_t level) {
+    return uint64_t{kPyramidBaseBinSamples} << level;
+}
+
+/// Samples covered by bin [index] of [level]; only the last bin is short.
+uint64_t BinCount(size_t level, uint64_t index, uint64_t total) {
+    uint64_t first = index * BinSamples(level);
+    return std::min(BinSamples(level), total - first);
+}
+
+PyramidBin ToBin(const SampleStats& stats) {
+    return {static_cast<float>(stats.min), static_cast<float>(stats.max),
+            static_cast<float>(stats.sumSquares / stats.count)};
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// PyramidKey
+// ---------------------------------------------------------------------------
+
+bool PyramidKey::ForFile(const std::string& path, uint32_t analysisRate,
+                         PyramidKey* key) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    key->path = path;
+    key->mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                   st.st_mtim.tv_nsec;
+    key->size = static_cast<uint64_t>(st.st_size);
+    key->analysisRate = analysisRate;
+    return true;
+}
+
+std::string PyramidKey::SidecarName() const {
+    // FNV-1a, so names stay stable across builds and standard libraries.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const void* data, size_t length) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ p[i]) * 0x100000001b3ULL;
+        }
+    };
+    mix(path.data(), path.size());
+    mix(&analysisRate, sizeof(analysisRate));
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.wfp",
+                  static_cast<unsigned long long>(hash));
+    return name;
+}
+
+// ---------------------------------------------------------------------------
+// WaveformPyramidBuilder
+// ---------------------------------------------------------------------------
+
+void WaveformPyramidBuilder::Add(const void* samples, size_t count,
+                                 SampleFormat format) {
+    const uint8_t* data = static_cast<const uint8_t*>(samples);
+    const size_t sampleBytes = BytesPerSample(format);
+    total_ += count;
+    while (count > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(
+            count, kPyramidBaseBinSamples - current_.count));
+        current_.Merge(ReduceSamples(format, data, n));
+        if (current_.count == kPyramidBaseBinSamples) {
+            base_.push_back(ToBin(current_));
+            current_ = SampleStats();
+        }
+        data += n * sampleBytes;
+        count -= n;
+    }
+}
+
+void WaveformPyramidBuilder::Append(const WaveformPyramidBuilder& next) {
+    if (current_.count > 0) {
+        // Only the last segment may end mid-bin; keep the partial bin so no
+        // samples are lost even if the caller breaks that rule.
+        base_.push_back(ToBin(current_));
+        total_ += kPyramidBaseBinSamples - current_.count;
+        current_ = SampleStats();
+    }
+    base_.insert(base_.end(), next.base_.begin(), next.base_.end());
+    current_ = next.current_;
+    total_ += next.total_;
+}
+
+std::vector<uint8_t> WaveformPyramidBuilder::Serialize(
+        const PyramidKey& key, uint32_t sampleRate) const {
+    std::vector<std::vector<PyramidBin>> levels;
+    if (total_ > 0) {
+        levels.push_back(base_);
+        if (current_.count > 0) levels.back().push_back(ToBin(current_));
+        while (levels.back().size() > 1) {
+            const size_t below = levels.size() - 1;
+            const std::vector<PyramidBin>& fine = levels.back();
+            std::vector<PyramidBin> coarse;
+            coarse.reserve((fine.size() + 1) / 2);
+            for (size_t i = 0; i < fine.size(); i += 2) {
+                PyramidBin bin = fine[i];
+                if (i + 1 < fine.size()) {
+                    const PyramidBin& next = fine[i + 1];
+                    double a = static_cast<double>(BinCount(below, i, total_));
+                    double b = static_cast<double>(BinCount(below, i + 1, total_));
+                    bin.min = std::min(bin.min, next.min);
+                    bin.max = std::max(bin.max, next.max);
+                    bin.meanSquare = static_cast<float>(
+                        (bin.meanSquare * a + next.meanSquare * b) / (a + b));
+                }
+                coarse.push_back(bin);
+            }
+            levels.push_back(std::move(coarse));
+        }
+    }
+
+    SidecarHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sampleRate = sampleRate;
+    header.analysisRate = key.analysisRate;
+    header.baseBinSamples = kPyramidBaseBinSamples;
+    header.levels = static_cast<uint32_t>(levels.size());
+    header.totalSamples = total_;
+    header.mtimeNs = key.mtimeNs;
+    header.fileSize = key.size;
+    header.pathLength = static_cast<uint32_t>(key.path.size());
+
+    size_t bins = 0;
+    for (const auto& level : levels) bins += level.size();
+    std::vector<uint8_t> image(BinsOffset(header.pathLength) +
+                               bins * sizeof(PyramidBin));
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(header), key.path.data(), key.path.size());
+    uint8_t* out = image.data() + BinsOffset(header.pathLength);
+    for (const auto& level : levels) {
+        std::memcpy(out, level.data(), level.size() * sizeof(PyramidBin));
+        out += level.size() * sizeof(PyramidBin);
+    }
+    return image;
+}
+
+// ---------------------------------------------------------------------------
+// WaveformPyramid
+// ---------------------------------------------------------------------------
+
+WaveformPyramid::~WaveformPyramid() {
+    if (mapped_) munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+std::unique_ptr<WaveformPyramid> WaveformPyramid::Open(const std::string& file,
+                                                       const PyramidKey& key) {
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(SidecarHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<WaveformPyramid> pyramid(new WaveformPyramid());
+    pyramid->data_ = static_cast<const uint8_t*>(data);
+    pyramid->size_ = static_cast<size_t>(st.st_size);
+    pyramid->mapped_ = true;
+    if (!pyramid->Parse(&key)) return nullptr;
+    return pyramid;
+}
+
+std::unique_ptr<WaveformPyramid> WaveformPyramid::FromImage(
+        std::vector<uint8_t> image) {
+    std::unique_ptr<WaveformPyramid> pyramid(new WaveformPyramid());
+    pyramid->owned_ = std::move(image);
+    pyramid->data_ = pyramid->owned_.data();
+    pyramid->size_ = pyramid->owned_.size();
+    if (!pyramid->Parse(nullptr)) return nullptr;
+    return pyramid;
+}
+
+bool WaveformPyramid::WriteImage(const std::string& file,
+                                 const std::vector<uint8_t>& image) {
+    size_t slash = file.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : file.substr(0, slash);
+    // An unnamed file leaves nothing behind if the process dies mid-write.
+    auto scratch = ScratchFile::CreateIn(directory);
+    return scratch && scratch->Write(image.data(), image.size()) &&
+           scratch->Publish(file);
+}
+
+bool WaveformPyramid::Parse(const PyramidKey* key) {
+    SidecarHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kVersion ||
+        header.baseBinSamples != kPyramidBaseBinSamples) {
+        return false;
+    }
+    size_t offset = BinsOffset(header.pathLength);
+    if (offset > size_) return false;
+    if (key) {
+        std::string path(reinterpret_cast<const char*>(data_) + sizeof(header),
+                         header.pathLength);
+        if (path != key->path || header.mtimeNs != key->mtimeNs ||
+            header.fileSize != key->size ||
+            header.analysisRate != key->analysisRate) {
+            return false;
+        }
+    }
+
+    uint64_t bins = (header.totalSamples + kPyramidBaseBinSamples - 1) /
+                    kPyramidBaseBinSamples;
+    for (uint32_t level = 0; level < header.levels; level++) {
+        if (bins > (size_ - offset) / sizeof(PyramidBin)) return false;
+        levels_.push_back(reinterpret_cast<const PyramidBin*>(data_ + offset));
+        levelBins_.push_back(bins);
+        offset += bins * sizeof(PyramidBin);
+        bins = (bins + 1) / 2;
+    }
+    return true;
+}
+
+uint64_t WaveformPyramid::samples() const {
+    return reinterpret_cast<const SidecarHeader*>(data_)->totalSamples;
+}
+
+uint32_t WaveformPyramid::sampleRate() const {
+    return reinterpret_cast<const SidecarHeader*>(data_)->sampleRate;
+}
+
+double WaveformPyramid::SumSquares(uint64_t start, uint64_t end) const {
+    const uint64_t total = samples();
+    auto binSum = [&](size_t level, uint64_t index) {
+        return levels_[level][index].meanSquare *
+               static_cast<double>(BinCount(level, index, total));
+    };
+
+    // Base bins cut by the range ends contribute pro rata.
+    uint64_t first = start / kPyramidBaseBinSamples;
+    uint64_t last = (end - 1) / kPyramidBaseBinSamples;
+    if (first == last) {
+        return levels_[0][first].meanSquare * static_cast<double>(end - start);
+    }
+    double sum = 0;
+    uint64_t lo = first, hi = last + 1;
+    if (start % kPyramidBaseBinSamples != 0) {
+        sum += levels_[0][first].meanSquare *
+               static_cast<double>(BinSamples(0) - start % BinSamples(0));
+        lo++;
+    }
+    if (end < std::min(hi * BinSamples(0), total)) {
+        sum += levels_[0][last].meanSquare *
+               static_cast<double>(end - last * BinSamples(0));
+        hi--;
+    }
+
+    // Whole bins in [lo, hi) are covered by O(log n) nodes of the pyramid.
+    for (size_t level = 0; lo < hi && level < levels_.size(); level++) {
+        if (lo & 1) sum += binSum(level, lo++);
+        if (hi & 1) sum += binSum(level, --hi);
+        lo /= 2;
+        hi /= 2;
+    }
+    return sum;
+}
+
+std::vector<double> WaveformPyramid::Rms(uint64_t start, uint64_t end,
+                                         int numberOfSamples) const {
+    std::vector<double> waveform(std::max(numberOfSamples, 0), 0.0);
+    end = std::min(end, samples());
+    if (start >= end || levels_.empty() || numberOfSamples <= 0) {
+        return waveform;
+    }
+
+    const uint64_t length = end - start;
+    const uint64_t samplesPerWindow =
+        std::max<uint64_t>(1, length / numberOfSamples);
+
+    double maxRms = 0;
+    for (int i = 0; i < numberOfSamples; i++) {
+        uint64_t windowStart =
+            start + static_cast<uint64_t>(i) * length / numberOfSamples;
+        if (windowStart >= end) break;
+        uint64_t windowEnd = std::min(windowStart + samplesPerWindow, end);
+        double rms = std::sqrt(SumSquares(windowStart, windowEnd) /
+                               (windowEnd - windowStart));
+        waveform[i] = rms;
+        if (rms > maxRms) maxRms = rms;
+    }
+    if (maxRms > 0) {
+        for (double& value : waveform) value /= maxRms;
+    }
+    return waveform;
+}
+
+}  // namespace audio_decoder
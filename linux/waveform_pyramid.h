@@ -0,0 +1,131 @@
+#ifndef FLUTTER_PLUGIN_WAVEFORM_PYRAMID_H_
+#define FLUTTER_PLUGIN_WAVEFORM_PYRAMID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "waveform_kernels.h"
+
+namespace audio_decoder {
+
+/// Samples summarized by one bin of the finest pyramid level.
+constexpr uint32_t kPyramidBaseBinSamples = 256;
+
+/// Identifies the source a pyramid was built from.  A sidecar whose key does
+/// not match the file on disk is stale and is rebuilt.
+struct PyramidKey {
+    std::string path;
+    int64_t mtimeNs = 0;
+    uint64_t size = 0;
+    /// Analysis rate the pyramid was requested at (the decode may have run
+    /// at a lower rate if the source is below it).
+    uint32_t analysisRate = 0;
+
+    /// Fills a key from stat(2) of [path].  Returns false if it cannot be
+    /// stat'ed (for example a URI rather than a local path).
+    static bool ForFile(const std::string& path, uint32_t analysisRate,
+                        PyramidKey* key);
+
+    /// File name of the sidecar for this key (stable per path and rate).
+    std::string SidecarName() const;
+};
+
+/// One pyramid bin, in full-scale units.
+struct PyramidBin {
+    float min;
+    float max;
+    float meanSquare;
+};
+
+/// Collects base bins while a file decodes and serializes the pyramid.
+class WaveformPyramidBuilder {
+ public:
+    WaveformPyramidBuilder() = default;
+
+    void Add(const void* samples, size_t count, SampleFormat format);
+
+    /// Appends the bins of a builder that collected the samples directly
+    /// following this one's, as when segments of a file are reduced in
+    /// parallel.  This builder must hold a multiple of
+    /// kPyramidBaseBinSamples samples so the bins line up.
+    void Append(const WaveformPyramidBuilder& next);
+
+    /// Samples added so far.
+    uint64_t samples() const { return total_; }
+
+    /// Returns the sidecar image: header, source path, then every level from
+    /// the base bins up to a single bin, each level half the size of the
+    /// one below.
+    std::vector<uint8_t> Serialize(const PyramidKey& key,
+                                   uint32_t sampleRate) const;
+
+ private:
+    std::vector<PyramidBin> base_;
+    SampleStats current_;
+    uint64_t total_ = 0;
+};
+
+/// A min/max/RMS pyramid, either memory-mapped from a sidecar file or held
+/// in memory.  Each window of a query is summed from the few pyramid nodes
+/// that cover it exactly, plus pro-rata shares of the base bins cut by its
+/// ends, so a query costs O(log n) per point regardless of the file's
+/// length.
+class WaveformPyramid {
+ public:
+    ~WaveformPyramid();
+
+    WaveformPyramid(const WaveformPyramid&) = delete;
+    WaveformPyramid& operator=(const WaveformPyramid&) = delete;
+
+    /// Maps the sidecar at [file].  Returns null if it is missing, corrupt
+    /// or was built for a different [key].
+    static std::unique_ptr<WaveformPyramid> Open(const std::string& file,
+                                                 const PyramidKey& key);
+
+    /// Wraps a serialized image (see WaveformPyramidBuilder::Serialize).
+    static std::unique_ptr<WaveformPyramid> FromImage(std::vector<uint8_t> image);
+
+    /// Writes [image] to an unnamed file next to [file] and links it into
+    /// place, so readers never see a partial sidecar.  Returns false on I/O
+    /// errors.
+    static bool WriteImage(const std::string& file,
+                           const std::vector<uint8_t>& image);
+
+    uint64_t samples() const;
+    uint32_t sampleRate() const;
+
+    /// True if windows of [samplesPerWindow] samples are at least one base
+    /// bin wide; finer windows need the samples themselves.
+    static bool Resolves(uint64_t samplesPerWindow) {
+        return samplesPerWindow >= kPyramidBaseBinSamples;
+    }
+
+    /// Returns [numberOfSamples] RMS values over samples [start, end),
+    /// normalized to the loudest window, with the same window placement as
+    /// WaveformAccumulator::Finish().
+    std::vector<double> Rms(uint64_t start, uint64_t end,
+                            int numberOfSamples) const;
+
+ private:
+    WaveformPyramid() = default;
+
+    bool Parse(const PyramidKey* key);
+
+    /// Sum of squares over samples [start, end).
+    double SumSquares(uint64_t start, uint64_t end) const;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> owned_;
+    /// Bins of each level, finest first.
+    std::vector<const PyramidBin*> levels_;
+    std::vector<uint64_t> levelBins_;
+};
+
+}  // namespace audio_decoder
+
+#endif  // FLUTTER_PLUGIN_WAVEFORM_PYRAMID_H_
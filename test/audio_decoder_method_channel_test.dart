@@ -1,7 +1,12 @@
+import 'dart:typed_data';
+
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
+import 'package:audio_decoder/audio_batch.dart';
 import 'package:audio_decoder/audio_decoder_method_channel.dart';
 import 'package:audio_decoder/audio_conversion_exception.dart';
+import 'package:audio_decoder/audio_pcm_stream.dart';
+import 'package:audio_decoder/wav_sample_format.dart';
 
 void main() {
   TestWidgetsFlutterBinding.ensureInitialized();
@@ -49,6 +54,21 @@ void main() {
     );
   });
 
+  test('convertToWav sends non-integer sampleFormat', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'convertToWav');
+      expect(methodCall.arguments['sampleFormat'], 'float');
+      return '/output/test.wav';
+    });
+
+    expect(
+      await platform.convertToWav('/input/test.mp3', '/output/test.wav', sampleFormat: WavSampleFormat.float),
+      '/output/test.wav',
+    );
+  });
+
   test('convertToWav omits null optional parameters', () async {
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
       MethodCall methodCall,
@@ -57,6 +77,7 @@ void main() {
       expect(methodCall.arguments.containsKey('sampleRate'), false);
       expect(methodCall.arguments.containsKey('channels'), false);
       expect(methodCall.arguments.containsKey('bitDepth'), false);
+      expect(methodCall.arguments.containsKey('sampleFormat'), false);
       return '/output/test.wav';
     });
 
@@ -123,6 +144,82 @@ void main() {
     expect(info.format, 'mp3');
   });
 
+  test('getAudioInfoBatch returns one result per path', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'getAudioInfoBatch');
+      expect(methodCall.arguments, {'paths': ['/a.mp3', '/b.txt']});
+      return [
+        {
+          'path': '/a.mp3',
+          'info': {'durationMs': 5000, 'sampleRate': 44100, 'channels': 2, 'bitRate': 128000, 'format': 'mp3'},
+          'error': null,
+        },
+        {'path': '/b.txt', 'info': null, 'error': 'Failed to discover audio info'},
+      ];
+    });
+
+    final results = await platform.getAudioInfoBatch(['/a.mp3', '/b.txt']);
+    expect(results.first.info?.duration, const Duration(seconds: 5));
+    expect(results.last.succeeded, isFalse);
+    expect(results.last.error, 'Failed to discover audio info');
+  });
+
+  test('getAudioInfoBatch falls back to single probes without native support', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      if (methodCall.method == 'getAudioInfoBatch') throw MissingPluginException();
+      if (methodCall.arguments['path'] == '/b.txt') {
+        throw PlatformException(code: 'INFO_ERROR', message: 'Not audio');
+      }
+      return <String, dynamic>{'durationMs': 1000, 'sampleRate': 8000, 'channels': 1, 'bitRate': 0, 'format': 'wav'};
+    });
+
+    final results = await platform.getAudioInfoBatch(['/a.wav', '/b.txt']);
+    expect(results.first.info?.sampleRate, 8000);
+    expect(results.last.error, 'Not audio');
+  });
+
+  test('configure sends only the provided settings', () async {
+    final cases = <(Future<void> Function(), Map<String, Object>)>[
+      (() => platform.configure(maxQueuedBytes: 1048576), {'maxQueuedBytes': 1048576}),
+      (() => platform.configure(waveformSampleRate: 4000), {'waveformSampleRate': 4000}),
+      (() => platform.configure(maxConcurrentJobs: 2), {'maxConcurrentJobs': 2}),
+      (() => platform.configure(progressIntervalMs: 500), {'progressIntervalMs': 500}),
+      (
+        () => platform.configure(scratchDirectory: '/var/tmp', scratchMemoryBytes: 1024),
+        {'scratchDirectory': '/var/tmp', 'scratchMemoryBytes': 1024},
+      ),
+      (() => platform.configure(infoTimeoutMs: 2000), {'infoTimeoutMs': 2000}),
+      (() => platform.configure(streamPauseTimeoutMs: 60000), {'streamPauseTimeoutMs': 60000}),
+      (
+        () => platform.configure(infoCacheEntries: 100, infoCacheFile: '/cache/info.idx'),
+        {'infoCacheEntries': 100, 'infoCacheFile': '/cache/info.idx'},
+      ),
+      (
+        () => platform.configure(wavPreallocate: false, wavDirectIo: true),
+        {'wavPreallocate': false, 'wavDirectIo': true},
+      ),
+    ];
+
+    MethodCall? sent;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      sent = methodCall;
+      return null;
+    });
+
+    for (final (configure, expected) in cases) {
+      sent = null;
+      await configure();
+      expect(sent?.method, 'configure');
+      expect(sent?.arguments, expected, reason: 'Expected only $expected');
+    }
+  });
+
   test('trimAudio sends correct arguments and returns path', () async {
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
       MethodCall methodCall,
@@ -194,6 +291,294 @@ void main() {
     );
   });
 
+  test('getWaveform sends optional time range', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'getWaveform');
+      expect(methodCall.arguments, {
+        'path': '/in.mp3',
+        'numberOfSamples': 10,
+        'startMs': 1500,
+        'endMs': 3000,
+      });
+      return List.filled(10, 0.5);
+    });
+
+    final waveform = await platform.getWaveform(
+      '/in.mp3',
+      10,
+      start: const Duration(milliseconds: 1500),
+      end: const Duration(seconds: 3),
+    );
+    expect(waveform.length, 10);
+  });
+
+  test('convertToWav sends jobId when provided', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.arguments['jobId'], 'job-1');
+      return '/output/test.wav';
+    });
+
+    await platform.convertToWav('/input/test.mp3', '/output/test.wav', jobId: 'job-1');
+  });
+
+  test('cancelled jobs throw AudioJobCancelledException', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      throw PlatformException(code: 'CANCELLED', message: 'Job was cancelled');
+    });
+
+    expect(
+      () => platform.convertToM4a('/input/test.mp3', '/output/test.m4a', jobId: 'job-2'),
+      throwsA(isA<AudioJobCancelledException>()),
+    );
+  });
+
+  test('convertBatch sends items and streams per-item results', () async {
+    const EventChannel events = EventChannel('audio_decoder/events');
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(onListen: (arguments, sink) {
+        sink.success(<String, dynamic>{
+          'type': 'batchItem',
+          'jobId': 'other-batch',
+          'index': 0,
+          'inputPath': '/x.mp3',
+          'outputPath': '/x.wav',
+          'error': null,
+        });
+        sink.success(<String, dynamic>{
+          'type': 'batchItem',
+          'jobId': 'batch-1',
+          'index': 1,
+          'inputPath': '/b.mp3',
+          'outputPath': '/b.m4a',
+          'error': 'Decoding failed',
+        });
+      }),
+    );
+    addTearDown(() => TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(events, null));
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'convertBatch');
+      expect(methodCall.arguments, {
+        'items': [
+          {'inputPath': '/a.mp3', 'outputPath': '/a.wav', 'format': 'wav', 'sampleRate': 16000},
+          {'inputPath': '/b.mp3', 'outputPath': '/b.m4a', 'format': 'm4a'},
+        ],
+        'jobId': 'batch-1',
+      });
+      return {
+        'items': [
+          {'index': 0, 'inputPath': '/a.mp3', 'outputPath': '/a.wav', 'error': null},
+          {'index': 1, 'inputPath': '/b.mp3', 'outputPath': '/b.m4a', 'error': 'Decoding failed'},
+        ],
+        'failed': 1,
+      };
+    });
+
+    final streamed = <AudioBatchItemResult>[];
+    final result = await platform.convertBatch(
+      const [AudioBatchItem.wav('/a.mp3', '/a.wav', sampleRate: 16000), AudioBatchItem.m4a('/b.mp3', '/b.m4a')],
+      jobId: 'batch-1',
+      onItemDone: streamed.add,
+    );
+    // Item 0 sent no event, so it is reported from the result.
+    expect(streamed.map((r) => r.index), [1, 0]);
+    expect(result.items.map((r) => r.succeeded), [true, false]);
+    expect(result.failures.single.error, 'Decoding failed');
+    expect(result.allSucceeded, isFalse);
+  });
+
+  test('convertBatch reports every item once when the result overtakes the item events', () async {
+    const EventChannel events = EventChannel('audio_decoder/events');
+    late MockStreamHandlerEventSink eventSink;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(onListen: (arguments, sink) => eventSink = sink),
+    );
+    addTearDown(() => TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(events, null));
+    final items = [
+      {'index': 0, 'inputPath': '/a.mp3', 'outputPath': '/a.wav', 'error': null},
+      {'index': 1, 'inputPath': '/b.mp3', 'outputPath': '/b.wav', 'error': null},
+    ];
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      // Only the first item's event is delivered before the result.
+      eventSink.success(<String, dynamic>{'type': 'batchItem', 'jobId': 'batch-2', ...items[0]});
+      return {'items': items, 'failed': 0};
+    });
+
+    final streamed = <AudioBatchItemResult>[];
+    await platform.convertBatch(
+      const [AudioBatchItem.wav('/a.mp3', '/a.wav'), AudioBatchItem.wav('/b.mp3', '/b.wav')],
+      jobId: 'batch-2',
+      onItemDone: streamed.add,
+    );
+    // The late event for the second item arrives after the call returned.
+    eventSink.success(<String, dynamic>{'type': 'batchItem', 'jobId': 'batch-2', ...items[1]});
+    await Future<void>.delayed(Duration.zero);
+    expect(streamed.map((r) => r.index), [0, 1]);
+  });
+
+  test('decodeStream delivers chunks and requests more as they are consumed', () async {
+    const EventChannel events = EventChannel('audio_decoder/events');
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(onListen: (arguments, sink) {
+        sink.success(<String, dynamic>{
+          'type': 'pcmFormat',
+          'jobId': 'stream-1',
+          'sampleRate': 16000,
+          'channels': 1,
+          'bitsPerSample': 32,
+          'float': true,
+        });
+        for (var i = 0; i < 3; i++) {
+          sink.success(<String, dynamic>{
+            'type': 'pcm',
+            'jobId': 'stream-1',
+            'data': Uint8List(8),
+            'frameOffset': i * 2,
+          });
+        }
+        sink.success(<String, dynamic>{'type': 'pcmEnd', 'jobId': 'stream-1'});
+      }),
+    );
+    addTearDown(() => TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(events, null));
+    final calls = <MethodCall>[];
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      calls.add(methodCall);
+      return methodCall.method == 'requestPcmChunks' ? true : null;
+    });
+
+    final chunks = await platform
+        .decodeStream('/a.ogg', format: AudioPcmFormat.f32, chunkSize: 8, start: const Duration(seconds: 1), jobId: 'stream-1')
+        .toList();
+    expect(chunks.map((c) => c.frameOffset), [0, 2, 4]);
+    expect(chunks.first.format, AudioPcmFormat.f32);
+    expect(chunks.first.sampleRate, 16000);
+    expect(chunks.first.frameCount, 2);
+    expect(calls.first.method, 'decodeStream');
+    expect(calls.first.arguments, {
+      'inputPath': '/a.ogg',
+      'format': 'f32',
+      'chunkBytes': 8,
+      'credits': 4,
+      'jobId': 'stream-1',
+      'startMs': 1000,
+    });
+    expect(calls.skip(1).map((c) => c.method), everyElement('requestPcmChunks'));
+  });
+
+  test('decodeStream reports native errors on the stream', () async {
+    const EventChannel events = EventChannel('audio_decoder/events');
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(onListen: (arguments, sink) {}),
+    );
+    addTearDown(() => TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(events, null));
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      throw PlatformException(code: 'DECODE_ERROR', message: 'No audio data decoded');
+    });
+
+    await expectLater(
+      platform.decodeStream('/a.txt', chunkSize: 1024, jobId: 'stream-2'),
+      emitsError(isA<AudioConversionException>()),
+    );
+  });
+
+  test('cancel sends jobId and returns whether the job was found', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'cancel');
+      expect(methodCall.arguments, {'jobId': 'job-3'});
+      return true;
+    });
+
+    expect(await platform.cancel('job-3'), isTrue);
+  });
+
+  test('cancel returns false when the platform has no implementation', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      throw MissingPluginException();
+    });
+
+    expect(await platform.cancel('job-4'), isFalse);
+  });
+
+  test('progressEvents decodes native progress events', () async {
+    const EventChannel events = EventChannel('audio_decoder/events');
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(onListen: (arguments, sink) {
+        sink.success(<String, dynamic>{
+          'type': 'progress',
+          'jobId': 'job-5',
+          'positionMs': 1500,
+          'durationMs': -1,
+          'bytesWritten': 4096,
+          'realTimeFactor': 12.5,
+          'done': false,
+        });
+        sink.endOfStream();
+      }),
+    );
+    addTearDown(() => TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockStreamHandler(events, null));
+
+    final progress = await platform.progressEvents.toList();
+    expect(progress, hasLength(1));
+    expect(progress.single.jobId, 'job-5');
+    expect(progress.single.position, const Duration(milliseconds: 1500));
+    expect(progress.single.duration, isNull);
+    expect(progress.single.bytesWritten, 4096);
+    expect(progress.single.realTimeFactor, 12.5);
+    expect(progress.single.done, isFalse);
+  });
+
+  test('getDecoderStats returns native counters', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      expect(methodCall.method, 'getDecoderStats');
+      return <String, dynamic>{
+        'pipelinePool': <String, dynamic>{'hits': 3, 'misses': 1},
+      };
+    });
+
+    final stats = await platform.getDecoderStats();
+    expect(stats['pipelinePool']['hits'], 3);
+    expect(stats['pipelinePool']['misses'], 1);
+  });
+
+  test('getDecoderStats returns empty map when not implemented', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, (
+      MethodCall methodCall,
+    ) async {
+      throw MissingPluginException();
+    });
+
+    expect(await platform.getDecoderStats(), isEmpty);
+  });
+
   group('bytes API', () {
     final testInput = Uint8List.fromList([1, 2, 3, 4]);
 
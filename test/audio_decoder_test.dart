@@ -8,10 +8,10 @@ import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 final class MockAudioDecoderPlatform extends AudioDecoderPlatform with MockPlatformInterfaceMixin {
   @override
-  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth}) => Future.value(outputPath);
+  Future<String> convertToWav(String inputPath, String outputPath, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, String? jobId}) => Future.value(outputPath);
 
   @override
-  Future<String> convertToM4a(String inputPath, String outputPath) => Future.value(outputPath);
+  Future<String> convertToM4a(String inputPath, String outputPath, {String? jobId}) => Future.value(outputPath);
 
   @override
   Future<AudioInfo> getAudioInfo(String path) => Future.value(
@@ -25,20 +25,28 @@ final class MockAudioDecoderPlatform extends AudioDecoderPlatform with MockPlatf
   );
 
   @override
-  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end) =>
+  Future<List<AudioInfoResult>> getAudioInfoBatch(List<String> paths, {String? jobId}) async => [
+        for (final path in paths)
+          path.endsWith('.txt')
+              ? AudioInfoResult(path: path, error: 'Not audio')
+              : AudioInfoResult(path: path, info: await getAudioInfo(path)),
+      ];
+
+  @override
+  Future<String> trimAudio(String inputPath, String outputPath, Duration start, Duration end, {String? jobId}) =>
       Future.value(outputPath);
 
   @override
-  Future<List<double>> getWaveform(String path, int numberOfSamples) => Future.value(List.filled(numberOfSamples, 0.5));
+  Future<List<double>> getWaveform(String path, int numberOfSamples, {Duration? start, Duration? end, String? jobId}) => Future.value(List.filled(numberOfSamples, 0.5));
 
   @override
-  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, bool? includeHeader}) =>
+  Future<Uint8List> convertToWavBytes(Uint8List inputData, String formatHint, {int? sampleRate, int? channels, int? bitDepth, WavSampleFormat sampleFormat = WavSampleFormat.integer, bool? includeHeader, String? jobId}) =>
       Future.value(Uint8List.fromList(
         (includeHeader == false) ? [0x00, 0x01] : [0x52, 0x49, 0x46, 0x46],
       ));
 
   @override
-  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint) =>
+  Future<Uint8List> convertToM4aBytes(Uint8List inputData, String formatHint, {String? jobId}) =>
       Future.value(Uint8List.fromList([0x00, 0x00, 0x00, 0x20])); // ftyp header stub
 
   @override
@@ -53,12 +61,60 @@ final class MockAudioDecoderPlatform extends AudioDecoderPlatform with MockPlatf
   );
 
   @override
-  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav'}) =>
+  Future<Uint8List> trimAudioBytes(Uint8List inputData, String formatHint, Duration start, Duration end, {String outputFormat = 'wav', String? jobId}) =>
       Future.value(Uint8List.fromList([0x52, 0x49, 0x46, 0x46]));
 
   @override
-  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples) =>
+  Future<List<double>> getWaveformBytes(Uint8List inputData, String formatHint, int numberOfSamples, {String? jobId}) =>
       Future.value(List.filled(numberOfSamples, 0.7));
+
+  @override
+  Stream<AudioPcmChunk> decodeStream(String inputPath,
+          {int? sampleRate, int? channels, AudioPcmFormat format = AudioPcmFormat.s16, required int chunkSize, Duration? start, Duration? end, required String jobId}) =>
+      Stream.fromIterable([
+        for (var i = 0; i < 2; i++)
+          AudioPcmChunk(
+            data: Uint8List(chunkSize),
+            sampleRate: sampleRate ?? 44100,
+            channels: channels ?? 2,
+            format: format,
+            frameOffset: i * chunkSize ~/ (format == AudioPcmFormat.f32 ? 4 : 2) ~/ (channels ?? 2),
+          ),
+      ]);
+
+  @override
+  Future<bool> cancel(String jobId) => Future.value(jobId == 'running');
+
+  @override
+  Future<AudioBatchResult> convertBatch(List<AudioBatchItem> items,
+      {required String jobId, void Function(AudioBatchItemResult result)? onItemDone}) async {
+    final results = [
+      for (var i = 0; i < items.length; i++)
+        AudioBatchItemResult(index: i, inputPath: items[i].inputPath, outputPath: items[i].outputPath),
+    ];
+    if (onItemDone != null) results.reversed.forEach(onItemDone);
+    return AudioBatchResult(results);
+  }
+
+  @override
+  Stream<AudioJobProgress> get progressEvents => Stream.fromIterable(const [
+        AudioJobProgress(jobId: 'other', position: Duration.zero, bytesWritten: 0, realTimeFactor: 0, done: true),
+        AudioJobProgress(
+            jobId: 'running',
+            position: Duration(seconds: 1),
+            duration: Duration(seconds: 4),
+            bytesWritten: 100,
+            realTimeFactor: 20,
+            done: false),
+        AudioJobProgress(
+            jobId: 'running',
+            position: Duration(seconds: 4),
+            duration: Duration(seconds: 4),
+            bytesWritten: 400,
+            realTimeFactor: 20,
+            done: true),
+        AudioJobProgress(jobId: 'running', position: Duration.zero, bytesWritten: 0, realTimeFactor: 0, done: false),
+      ]);
 }
 
 void main() {
@@ -100,6 +156,30 @@ void main() {
     expect(info.format, 'mp3');
   });
 
+  test('getAudioInfoBatch delegates to platform', () async {
+    AudioDecoderPlatform.instance = MockAudioDecoderPlatform();
+
+    final results = await AudioDecoder.getAudioInfoBatch(['/a.mp3', '/b.txt']);
+    expect(results.map((r) => r.succeeded), [true, false]);
+    expect(results.first.info?.format, 'mp3');
+    expect(await AudioDecoder.getAudioInfoBatch(const []), isEmpty);
+  });
+
+  test('configure rejects non-positive infoTimeout', () {
+    expect(() => AudioDecoder.configure(infoTimeout: Duration.zero), throwsArgumentError);
+  });
+
+  test('configure rejects negative streamPauseTimeout', () {
+    expect(
+      () => AudioDecoder.configure(streamPauseTimeout: const Duration(milliseconds: -1)),
+      throwsArgumentError,
+    );
+  });
+
+  test('configure rejects negative infoCacheEntries', () {
+    expect(() => AudioDecoder.configure(infoCacheEntries: -1), throwsArgumentError);
+  });
+
   test('trimAudio delegates to platform', () async {
     MockAudioDecoderPlatform fakePlatform = MockAudioDecoderPlatform();
     AudioDecoderPlatform.instance = fakePlatform;
@@ -222,6 +302,95 @@ void main() {
       AudioDecoderPlatform.instance = fakePlatform;
     });
 
+    test('configure rejects negative queue limits', () {
+      expect(() => AudioDecoder.configure(maxQueuedBuffers: -1), throwsArgumentError);
+      expect(() => AudioDecoder.configure(maxQueuedBytes: -1), throwsArgumentError);
+    });
+
+    test('getWaveform rejects end before start', () {
+      expect(
+        () => AudioDecoder.getWaveform(
+          '/in.mp3',
+          start: const Duration(seconds: 2),
+          end: const Duration(seconds: 1),
+        ),
+        throwsArgumentError,
+      );
+    });
+
+    test('configure rejects negative decodeSegments', () {
+      expect(() => AudioDecoder.configure(decodeSegments: -1), throwsArgumentError);
+    });
+
+    test('createJobId returns distinct IDs', () {
+      expect(AudioDecoder.createJobId(), isNot(AudioDecoder.createJobId()));
+    });
+
+    test('convertBatch delegates to platform and reports each item', () async {
+      final done = <int>[];
+      final result = await AudioDecoder.convertBatch(
+        const [AudioBatchItem.wav('/a.mp3', '/a.wav'), AudioBatchItem.m4a('/b.mp3', '/b.m4a')],
+        onItemDone: (item) => done.add(item.index),
+      );
+      expect(done, [1, 0]);
+      expect(result.items.map((r) => r.outputPath), ['/a.wav', '/b.m4a']);
+      expect(result.allSucceeded, isTrue);
+    });
+
+    test('convertBatch validates WAV options', () {
+      expect(
+        () => AudioDecoder.convertBatch(const [AudioBatchItem.wav('/a.mp3', '/a.wav', bitDepth: 12)]),
+        throwsArgumentError,
+      );
+    });
+
+    test('decodeStream delegates to platform', () async {
+      final chunks = await AudioDecoder.decodeStream('/a.mp3', sampleRate: 8000, channels: 1, chunkSize: 400).toList();
+      expect(chunks, hasLength(2));
+      expect(chunks.last.frameCount, 200);
+      expect(chunks.last.position, const Duration(milliseconds: 25));
+    });
+
+    test('decodeStream validates its options', () {
+      expect(() => AudioDecoder.decodeStream('/a.mp3', chunkSize: 0), throwsArgumentError);
+      expect(() => AudioDecoder.decodeStream('/a.mp3', channels: 0), throwsArgumentError);
+      expect(
+        () => AudioDecoder.decodeStream('/a.mp3', start: const Duration(seconds: 2), end: const Duration(seconds: 1)),
+        throwsArgumentError,
+      );
+    });
+
+    test('cancel delegates to platform', () async {
+      expect(await AudioDecoder.cancel('running'), isTrue);
+      expect(await AudioDecoder.cancel('finished'), isFalse);
+    });
+
+    test('configure rejects negative maxConcurrentJobs', () {
+      expect(() => AudioDecoder.configure(maxConcurrentJobs: -1), throwsArgumentError);
+    });
+
+    test('progressOf follows one job until its last event', () async {
+      final events = await AudioDecoder.progressOf('running').toList();
+      expect(events.map((e) => e.position), [const Duration(seconds: 1), const Duration(seconds: 4)]);
+      expect(events.first.fraction, 0.25);
+      expect(events.last.done, isTrue);
+    });
+
+    test('configure rejects negative progressInterval', () {
+      expect(
+        () => AudioDecoder.configure(progressInterval: const Duration(milliseconds: -1)),
+        throwsArgumentError,
+      );
+    });
+
+    test('configure rejects negative scratchMemoryBudget', () {
+      expect(() => AudioDecoder.configure(scratchMemoryBudget: -1), throwsArgumentError);
+    });
+
+    test('configure rejects non-positive waveformSampleRate', () {
+      expect(() => AudioDecoder.configure(waveformSampleRate: 0), throwsArgumentError);
+    });
+
     test('convertToWav rejects zero sampleRate', () {
       expect(
         () => AudioDecoder.convertToWav('/in.mp3', '/out.wav', sampleRate: 0),
@@ -257,6 +426,19 @@ void main() {
       );
     });
 
+    test('convertToWav rejects bitDepth with float samples', () {
+      expect(
+        () => AudioDecoder.convertToWav('/in.mp3', '/out.wav', bitDepth: 24, sampleFormat: WavSampleFormat.float),
+        throwsArgumentError,
+      );
+    });
+
+    test('convertToWavBytes accepts native samples', () async {
+      final result = await AudioDecoder.convertToWavBytes(Uint8List(1),
+          formatHint: 'ogg', sampleFormat: WavSampleFormat.native);
+      expect(result, isNotEmpty);
+    });
+
     test('convertToWavBytes rejects zero sampleRate', () {
       expect(
         () => AudioDecoder.convertToWavBytes(Uint8List(1), formatHint: 'mp3', sampleRate: 0),